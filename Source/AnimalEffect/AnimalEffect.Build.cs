@@ -14,7 +14,7 @@ public class AnimalEffect : ModuleRules
 			"UMG"
 		});
 
-		PrivateDependencyModuleNames.AddRange(new string[] {  });
+		PrivateDependencyModuleNames.AddRange(new string[] { "AssetRegistry" });
 
 		PublicIncludePaths.Add(ModuleDirectory);
 	}
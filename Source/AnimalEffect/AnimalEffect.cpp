@@ -1,6 +1,23 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "AnimalEffect.h"
+#include "Data/AEDataAsset.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, AnimalEffect, "AnimalEffect" );
+class FAnimalEffectModule : public FDefaultGameModuleImpl
+{
+public:
+
+	void StartupModule() override
+	{
+		UAEMetaAsset::InitializeClassIndex();
+	}
+
+	void ShutdownModule() override
+	{
+		UAEMetaAsset::ShutdownClassIndex();
+	}
+
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FAnimalEffectModule, AnimalEffect, "AnimalEffect" );
@@ -0,0 +1,173 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CraftingAvailability.h"
+
+#include "RecipeAsset.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogCraftingAvailability, Log, All);
+
+FCraftingAvailability::~FCraftingAvailability()
+{
+	Deinitialize();
+}
+
+void FCraftingAvailability::Initialize(const TArray<UCraftingRecipeAsset*>& InRecipes, FInventory& InInventory)
+{
+	Deinitialize();
+
+	Inventory = &InInventory;
+	SlotsChangedHandle = Inventory->OnSlotsChanged.AddRaw(this, &FCraftingAvailability::OnInventorySlotsChanged);
+
+	for (const UCraftingRecipeAsset* Recipe : InRecipes)
+	{
+		if (Recipe == nullptr)
+		{
+			continue;
+		}
+
+		// a recipe may list the same asset more than once, treat that as a single larger requirement
+		TMap<const UAEMetaAsset*, int32> RequiredCounts;
+		for (const FRecipeIngredient& Ingredient : Recipe->GetIngredients())
+		{
+			if (Ingredient.AssetType == nullptr)
+			{
+				UE_LOG(LogCraftingAvailability, Warning, TEXT("Recipe '%s' has a null ingredient"), *Recipe->GetName());
+				continue;
+			}
+			RequiredCounts.FindOrAdd(Ingredient.AssetType) += FMath::Max(Ingredient.Count, 1);
+		}
+
+		const int32 RecipeIndex = Recipes.Add({ Recipe, RequiredCounts.Num(), 0 });
+		for (const TPair<const UAEMetaAsset*, int32>& RequiredCount : RequiredCounts)
+		{
+			UsesByIngredient.FindOrAdd(RequiredCount.Key).Add({ RecipeIndex, RequiredCount.Value });
+			IngredientCounts.Add(RequiredCount.Key, 0);
+		}
+
+		// a recipe without ingredients is always craftable
+		if (RequiredCounts.Num() == 0)
+		{
+			CraftableRecipes.Add(Recipe);
+		}
+	}
+
+	// seed the counts with a single pass over the inventory
+	KnownSlots.SetNum(Inventory->Slots.Num());
+
+	TArray<int32> AllSlots;
+	AllSlots.Reserve(Inventory->Slots.Num());
+	for (int32 SlotIndex = 0; SlotIndex < Inventory->Slots.Num(); ++SlotIndex)
+	{
+		AllSlots.Add(SlotIndex);
+	}
+	OnInventorySlotsChanged(*Inventory, AllSlots);
+}
+
+void FCraftingAvailability::Deinitialize()
+{
+	if (Inventory)
+	{
+		Inventory->OnSlotsChanged.Remove(SlotsChangedHandle);
+		Inventory = nullptr;
+	}
+	SlotsChangedHandle.Reset();
+
+	Recipes.Reset();
+	UsesByIngredient.Reset();
+	IngredientCounts.Reset();
+	KnownSlots.Reset();
+	CraftableRecipes.Reset();
+}
+
+void FCraftingAvailability::OnInventorySlotsChanged(const FInventory& ChangedInventory, const TArray<int32>& ChangedSlots)
+{
+	if (KnownSlots.Num() < ChangedInventory.Slots.Num())
+	{
+		KnownSlots.SetNum(ChangedInventory.Slots.Num());
+	}
+
+	// fold the slot changes into one delta per asset first so each affected recipe is revisited once per asset
+	TMap<const UAEMetaAsset*, int32, TInlineSetAllocator<8>> CountDeltas;
+	for (int32 SlotIndex : ChangedSlots)
+	{
+		const FInventorySlotData& OldSlot = KnownSlots[SlotIndex];
+		const FInventorySlotData& NewSlot = ChangedInventory.Slots[SlotIndex];
+
+		if (OldSlot.AssetType && IngredientCounts.Contains(OldSlot.AssetType))
+		{
+			CountDeltas.FindOrAdd(OldSlot.AssetType) -= OldSlot.StackSize;
+		}
+		if (NewSlot.AssetType && IngredientCounts.Contains(NewSlot.AssetType))
+		{
+			CountDeltas.FindOrAdd(NewSlot.AssetType) += NewSlot.StackSize;
+		}
+
+		KnownSlots[SlotIndex] = NewSlot;
+	}
+
+	TMap<int32, bool, TInlineSetAllocator<8>> ChangedRecipes;
+	for (const TPair<const UAEMetaAsset*, int32>& CountDelta : CountDeltas)
+	{
+		if (CountDelta.Value != 0)
+		{
+			SetAssetCount(CountDelta.Key, IngredientCounts.FindChecked(CountDelta.Key) + CountDelta.Value, ChangedRecipes);
+		}
+	}
+
+	// everything is up to date before anyone hears about it. a listener changing the inventory gets its own pass,
+	// so craftability is read again here rather than remembered
+	for (const TPair<int32, bool>& ChangedRecipe : ChangedRecipes)
+	{
+		if (!Recipes.IsValidIndex(ChangedRecipe.Key))
+		{
+			// a listener deinitialized us
+			break;
+		}
+
+		const UCraftingRecipeAsset* Recipe = Recipes[ChangedRecipe.Key].Recipe;
+		const bool bIsCraftable = IsCraftable(Recipe);
+		if (bIsCraftable != ChangedRecipe.Value)
+		{
+			OnRecipeCraftableChanged.Broadcast(Recipe, bIsCraftable);
+		}
+	}
+}
+
+void FCraftingAvailability::SetAssetCount(const UAEMetaAsset* AssetType, int32 NewCount, TMap<int32, bool, TInlineSetAllocator<8>>& ChangedRecipes)
+{
+	int32& Count = IngredientCounts.FindChecked(AssetType);
+	const int32 OldCount = Count;
+	Count = NewCount;
+
+	for (const FIngredientUse& Use : UsesByIngredient.FindChecked(AssetType))
+	{
+		const bool bWasSatisfied = OldCount >= Use.RequiredCount;
+		const bool bIsSatisfied = NewCount >= Use.RequiredCount;
+		if (bWasSatisfied == bIsSatisfied)
+		{
+			continue;
+		}
+
+		FRecipeState& RecipeState = Recipes[Use.RecipeIndex];
+		const bool bWasCraftable = RecipeState.NumSatisfiedIngredients == RecipeState.NumIngredients;
+		RecipeState.NumSatisfiedIngredients += bIsSatisfied ? 1 : -1;
+		const bool bIsCraftable = RecipeState.NumSatisfiedIngredients == RecipeState.NumIngredients;
+
+		if (bIsCraftable != bWasCraftable)
+		{
+			if (bIsCraftable)
+			{
+				CraftableRecipes.Add(RecipeState.Recipe);
+			}
+			else
+			{
+				CraftableRecipes.Remove(RecipeState.Recipe);
+			}
+
+			if (!ChangedRecipes.Contains(Use.RecipeIndex))
+			{
+				ChangedRecipes.Add(Use.RecipeIndex, bWasCraftable);
+			}
+		}
+	}
+}
@@ -0,0 +1,80 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Inventory/Inventory.h"
+
+class UAEMetaAsset;
+class UCraftingRecipeAsset;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnRecipeCraftableChanged, const UCraftingRecipeAsset* /*Recipe*/, bool /*bCraftable*/);
+
+/**
+ * Keeps the set of recipes craftable from an inventory up to date.
+ * - Recipes are indexed by ingredient, and each recipe counts how many of its ingredients are satisfied.
+ * - Driven by FInventory::OnSlotsChanged, so a change only revisits the recipes using an asset whose count changed.
+ * - IsCraftable is a set lookup.
+ * The recipe assets must be kept alive by the owner.
+ * Not copyable or movable, the inventory holds a raw binding to this instance.
+ */
+class ANIMALEFFECT_API FCraftingAvailability
+{
+public:
+
+	FCraftingAvailability() = default;
+	~FCraftingAvailability();
+
+	FCraftingAvailability(const FCraftingAvailability&) = delete;
+	FCraftingAvailability& operator=(const FCraftingAvailability&) = delete;
+	FCraftingAvailability(FCraftingAvailability&&) = delete;
+	FCraftingAvailability& operator=(FCraftingAvailability&&) = delete;
+
+	void Initialize(const TArray<UCraftingRecipeAsset*>& InRecipes, FInventory& InInventory);
+	void Deinitialize();
+
+	FORCEINLINE bool IsCraftable(const UCraftingRecipeAsset* Recipe) const { return CraftableRecipes.Contains(Recipe); }
+
+	FORCEINLINE const TSet<const UCraftingRecipeAsset*>& GetCraftableRecipes() const { return CraftableRecipes; }
+
+	// broadcast once an inventory change has been fully applied, so listeners are free to change the inventory again
+	FOnRecipeCraftableChanged OnRecipeCraftableChanged;
+
+private:
+
+	void OnInventorySlotsChanged(const FInventory& Inventory, const TArray<int32>& ChangedSlots);
+
+	// adds the index of every recipe whose craftability flipped, with what it was before, to ChangedRecipes unless it's already there
+	void SetAssetCount(const UAEMetaAsset* AssetType, int32 NewCount, TMap<int32, bool, TInlineSetAllocator<8>>& ChangedRecipes);
+
+private:
+
+	struct FRecipeState
+	{
+		const UCraftingRecipeAsset* Recipe;
+		int32 NumIngredients;
+		int32 NumSatisfiedIngredients;
+	};
+
+	struct FIngredientUse
+	{
+		int32 RecipeIndex;
+		int32 RequiredCount;
+	};
+
+	TArray<FRecipeState> Recipes;
+
+	TMap<const UAEMetaAsset*, TArray<FIngredientUse>> UsesByIngredient;
+
+	// only tracked for assets that are an ingredient of some recipe
+	TMap<const UAEMetaAsset*, int32> IngredientCounts;
+
+	// what each slot held when we last saw it, so a change can be turned into count deltas
+	TArray<FInventorySlotData> KnownSlots;
+
+	TSet<const UCraftingRecipeAsset*> CraftableRecipes;
+
+	FInventory* Inventory = nullptr;
+
+	FDelegateHandle SlotsChangedHandle;
+
+};
@@ -0,0 +1,8 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "RecipeAsset.h"
+
+FText UCraftingRecipeAsset::GetTitle() const
+{
+	return Title.IsEmpty() ? FText::FromString(GetName()) : Title;
+}
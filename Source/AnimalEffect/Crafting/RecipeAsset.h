@@ -0,0 +1,51 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Items/Interfaces/PickupActorInterface.h"
+
+#include "Engine/DataAsset.h"
+
+#include "RecipeAsset.generated.h"
+
+class UAEMetaAsset;
+
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FRecipeIngredient
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	const UAEMetaAsset* AssetType = nullptr;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (ClampMin = 1))
+	int32 Count = 1;
+};
+
+UCLASS()
+class ANIMALEFFECT_API UCraftingRecipeAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+private:
+
+	// any quality of an ingredient counts towards its Count
+	UPROPERTY(EditDefaultsOnly, Category = "Recipe")
+	TArray<FRecipeIngredient> Ingredients;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Recipe")
+	FPickupData Result;
+
+	UPROPERTY(EditDefaultsOnly, Category = "UI")
+	FText Title;
+
+public:
+
+	FORCEINLINE const TArray<FRecipeIngredient>& GetIngredients() const { return Ingredients; }
+
+	FORCEINLINE const FPickupData& GetResult() const { return Result; }
+
+	UFUNCTION(BlueprintPure, Category = "UI")
+	FText GetTitle() const;
+
+};
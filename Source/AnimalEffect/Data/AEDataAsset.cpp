@@ -2,6 +2,11 @@
 
 #include "AEDataAsset.h"
 
+#include "AssetRegistryModule.h"
+#include "Engine/AssetManager.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogAEDataAsset, Log, All);
+
 namespace
 {
 
@@ -24,11 +29,57 @@ namespace
 
 	static FUObjectAnnotationDense<FPtrAnnotation, true> MetaAnnotations;
 
+	// actor class path to meta asset path for every meta asset in the asset registry, loaded or not
+	static TMap<FName, FSoftObjectPath> ClassIndex;
+
+	static FDelegateHandle FilesLoadedHandle;
+
+#if WITH_EDITOR
+	static FDelegateHandle AssetAddedHandle;
+	static FDelegateHandle AssetRemovedHandle;
+	static FDelegateHandle AssetRenamedHandle;
+#endif // WITH_EDITOR
+
 }
 
 TSubclassOf<AActor> UAEMetaAsset::GetActorClass() const
 {
 	UClass* LoadedClass = ActorClass.LoadSynchronous();
+	RegisterActorClass(LoadedClass);
+	return LoadedClass;
+}
+
+TSubclassOf<AActor> UAEMetaAsset::GetLoadedActorClass() const
+{
+	UClass* LoadedClass = ActorClass.Get();
+	RegisterActorClass(LoadedClass);
+	return LoadedClass;
+}
+
+void UAEMetaAsset::GetActorClassAsync(FOnActorClassLoaded OnLoaded) const
+{
+	if (TSubclassOf<AActor> LoadedClass = GetLoadedActorClass())
+	{
+		OnLoaded.ExecuteIfBound(LoadedClass);
+		return;
+	}
+
+	if (ActorClass.IsNull())
+	{
+		OnLoaded.ExecuteIfBound(nullptr);
+		return;
+	}
+
+	TWeakObjectPtr<const UAEMetaAsset> WeakThis(this);
+	UAssetManager::GetStreamableManager().RequestAsyncLoad(ActorClass.ToSoftObjectPath(), FStreamableDelegate::CreateLambda([WeakThis, OnLoaded]()
+	{
+		const UAEMetaAsset* MetaAsset = WeakThis.Get();
+		OnLoaded.ExecuteIfBound(MetaAsset ? MetaAsset->GetLoadedActorClass() : nullptr);
+	}));
+}
+
+void UAEMetaAsset::RegisterActorClass(UClass* LoadedClass) const
+{
 	if (LoadedClass)
 	{
 		if (MetaAnnotations.GetAnnotation(LoadedClass) == nullptr)
@@ -36,23 +87,218 @@ TSubclassOf<AActor> UAEMetaAsset::GetActorClass() const
 			MetaAnnotations.AddAnnotation(LoadedClass, this);
 		}
 	}
-	return LoadedClass;
 }
 
 const UAEMetaAsset* UAEMetaAsset::GetMetaAssetForClass(UClass* Class)
 {
+	if (Class == nullptr)
+	{
+		return nullptr;
+	}
+
 	const UAEMetaAsset* MetaAsset = MetaAnnotations.GetAnnotationRef(Class);
+	if (MetaAsset)
+	{
+		return MetaAsset;
+	}
+
+	const FSoftObjectPath* MetaAssetPath = ClassIndex.Find(FName(*Class->GetPathName()));
+	if (MetaAssetPath == nullptr)
+	{
+		UE_LOG(LogAEDataAsset, Error, TEXT("No meta asset found for class '%s'"), *Class->GetPathName());
+		return nullptr;
+	}
+
+	MetaAsset = Cast<UAEMetaAsset>(MetaAssetPath->ResolveObject());
+	if (MetaAsset == nullptr)
+	{
+		// meta assets are small and don't hard reference their actor class so this is cheap
+		MetaAsset = Cast<UAEMetaAsset>(MetaAssetPath->TryLoad());
+	}
+
 	if (MetaAsset == nullptr)
 	{
-		// #todo: we shouldn't be asking for a metaasset that hasn't been cached usually
-		// if we do we need to find the correct metaasset and cache it
-		// MetaAsset = FindMetaAsset(Class);
-		// MetaAnnotations.AddAnnotation(Class, MetaAsset);
-		check(false);
+		UE_LOG(LogAEDataAsset, Error, TEXT("Failed to load meta asset '%s' for class '%s'"), *MetaAssetPath->ToString(), *Class->GetPathName());
+		return nullptr;
 	}
+
+	MetaAsset->RegisterActorClass(Class);
 	return MetaAsset;
 }
 
+void UAEMetaAsset::InitializeClassIndex()
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+	// in the editor the registry is still discovering assets at startup. index what's there now and again once it's done
+	if (AssetRegistry.IsLoadingAssets())
+	{
+		FilesLoadedHandle = AssetRegistry.OnFilesLoaded().AddStatic(&UAEMetaAsset::RebuildClassIndex);
+	}
+
+#if WITH_EDITOR
+	AssetAddedHandle = AssetRegistry.OnAssetAdded().AddStatic(&UAEMetaAsset::OnAssetAdded);
+	AssetRemovedHandle = AssetRegistry.OnAssetRemoved().AddStatic(&UAEMetaAsset::OnAssetRemoved);
+	AssetRenamedHandle = AssetRegistry.OnAssetRenamed().AddStatic(&UAEMetaAsset::OnAssetRenamed);
+#endif // WITH_EDITOR
+
+	RebuildClassIndex();
+}
+
+void UAEMetaAsset::ShutdownClassIndex()
+{
+	if (FAssetRegistryModule* AssetRegistryModule = FModuleManager::GetModulePtr<FAssetRegistryModule>(TEXT("AssetRegistry")))
+	{
+		IAssetRegistry& AssetRegistry = AssetRegistryModule->Get();
+		AssetRegistry.OnFilesLoaded().Remove(FilesLoadedHandle);
+
+#if WITH_EDITOR
+		AssetRegistry.OnAssetAdded().Remove(AssetAddedHandle);
+		AssetRegistry.OnAssetRemoved().Remove(AssetRemovedHandle);
+		AssetRegistry.OnAssetRenamed().Remove(AssetRenamedHandle);
+#endif // WITH_EDITOR
+	}
+
+	ClassIndex.Empty();
+}
+
+void UAEMetaAsset::RebuildClassIndex()
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+#if WITH_EDITOR
+	// rebuilding per asset while the initial scan is running would be quadratic. OnFilesLoaded picks it all up
+	if (AssetRegistry.IsLoadingAssets())
+	{
+		return;
+	}
+#endif // WITH_EDITOR
+
+	TArray<FAssetData> MetaAssets;
+	AssetRegistry.GetAssetsByClass(UAEMetaAsset::StaticClass()->GetFName(), MetaAssets, true);
+
+	ClassIndex.Reset();
+	ClassIndex.Reserve(MetaAssets.Num());
+
+	for (const FAssetData& AssetData : MetaAssets)
+	{
+		AddToClassIndex(AssetData);
+	}
+
+	UE_LOG(LogAEDataAsset, Log, TEXT("Indexed %d meta asset classes"), ClassIndex.Num());
+}
+
+bool UAEMetaAsset::GetIndexKey(const FAssetData& AssetData, FName& OutClassKey)
+{
+	FString ActorClassPath;
+	if (!AssetData.GetTagValue(GET_MEMBER_NAME_CHECKED(UAEMetaAsset, ActorClass), ActorClassPath))
+	{
+		return false;
+	}
+
+	// normalize through FSoftObjectPath so the key matches UClass::GetPathName
+	const FSoftObjectPath ClassPath(ActorClassPath.TrimQuotes());
+	if (ClassPath.IsNull())
+	{
+		return false;
+	}
+
+	OutClassKey = FName(*ClassPath.ToString());
+	return true;
+}
+
+void UAEMetaAsset::AddToClassIndex(const FAssetData& AssetData)
+{
+	FName ClassKey;
+	if (!GetIndexKey(AssetData, ClassKey))
+	{
+		return;
+	}
+
+	if (const FSoftObjectPath* ExistingPath = ClassIndex.Find(ClassKey))
+	{
+		if (*ExistingPath != AssetData.ToSoftObjectPath())
+		{
+			UE_LOG(LogAEDataAsset, Warning, TEXT("'%s' and '%s' both claim class '%s'. using the first"), *ExistingPath->ToString(), *AssetData.ObjectPath.ToString(), *ClassKey.ToString());
+		}
+		return;
+	}
+
+	ClassIndex.Add(ClassKey, AssetData.ToSoftObjectPath());
+}
+
+#if WITH_EDITOR
+namespace
+{
+	bool IsMetaAssetData(const FAssetData& AssetData)
+	{
+		// registry events fire for every asset in the project, most of which we don't care about
+		const UClass* AssetClass = AssetData.GetClass();
+		return AssetClass && AssetClass->IsChildOf(UAEMetaAsset::StaticClass());
+	}
+
+	bool IsScanningAssets()
+	{
+		// OnFilesLoaded rebuilds everything once the initial scan is done
+		return FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get().IsLoadingAssets();
+	}
+}
+
+void UAEMetaAsset::OnAssetAdded(const FAssetData& AssetData)
+{
+	if (!IsMetaAssetData(AssetData) || IsScanningAssets())
+	{
+		return;
+	}
+
+	AddToClassIndex(AssetData);
+}
+
+void UAEMetaAsset::OnAssetRemoved(const FAssetData& AssetData)
+{
+	if (!IsMetaAssetData(AssetData) || IsScanningAssets())
+	{
+		return;
+	}
+
+	FName ClassKey;
+	if (!GetIndexKey(AssetData, ClassKey))
+	{
+		return;
+	}
+
+	// only if it's the asset that claimed the class, a duplicate that lost out was never indexed
+	const FSoftObjectPath* ExistingPath = ClassIndex.Find(ClassKey);
+	if (ExistingPath && *ExistingPath == AssetData.ToSoftObjectPath())
+	{
+		ClassIndex.Remove(ClassKey);
+	}
+}
+
+void UAEMetaAsset::OnAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath)
+{
+	if (!IsMetaAssetData(AssetData) || IsScanningAssets())
+	{
+		return;
+	}
+
+	FName ClassKey;
+	if (!GetIndexKey(AssetData, ClassKey))
+	{
+		return;
+	}
+
+	FSoftObjectPath* ExistingPath = ClassIndex.Find(ClassKey);
+	if (ExistingPath && *ExistingPath == FSoftObjectPath(OldObjectPath))
+	{
+		*ExistingPath = AssetData.ToSoftObjectPath();
+		return;
+	}
+
+	AddToClassIndex(AssetData);
+}
+#endif // WITH_EDITOR
+
 FText UAEMetaAsset::GetTitle() const
 {
 	return Title.IsEmpty() ? FText::FromString(GetName()) : Title;
@@ -2,11 +2,14 @@
 
 #pragma once
 
+#include "AssetData.h"
 #include "Engine/DataAsset.h"
 #include "UObject/UObjectAnnotation.h"
 
 #include "AEDataAsset.generated.h"
 
+DECLARE_DELEGATE_OneParam(FOnActorClassLoaded, TSubclassOf<AActor> /*ActorClass*/);
+
 UCLASS()
 class ANIMALEFFECT_API UAEMetaAsset : public UPrimaryDataAsset
 {
@@ -14,7 +17,8 @@ class ANIMALEFFECT_API UAEMetaAsset : public UPrimaryDataAsset
 
 private:
 
-	UPROPERTY(EditDefaultsOnly, Category = "Actor")
+	// searchable so the class to meta asset index can be built from the asset registry without loading anything
+	UPROPERTY(EditDefaultsOnly, AssetRegistrySearchable, Category = "Actor", meta = (AssetBundles = "Actor"))
 	TSoftClassPtr<AActor> ActorClass;
 
 	UPROPERTY(EditDefaultsOnly, Category = "UI")
@@ -22,11 +26,42 @@ private:
 
 public:
 
+	// #note: this will load the class synchronously if it isn't resident. prefer GetActorClassAsync or preloading through UMetaAssetPreloader
 	TSubclassOf<AActor> GetActorClass() const;
 
+	// null if the class isn't loaded yet. never loads
+	TSubclassOf<AActor> GetLoadedActorClass() const;
+
+	// calls back immediately if the class is resident, otherwise once it has streamed in (with null if it failed to load)
+	void GetActorClassAsync(FOnActorClassLoaded OnLoaded) const;
+
+	FORCEINLINE const TSoftClassPtr<AActor>& GetActorClassPtr() const { return ActorClass; }
+
+	// works for any class with a meta asset, whether or not either is loaded. may load the meta asset (but never its actor class)
 	static const UAEMetaAsset* GetMetaAssetForClass(UClass* Class);
 
+	// builds the actor class path to meta asset path index from asset registry tags. called on module startup
+	static void InitializeClassIndex();
+	static void ShutdownClassIndex();
+
 	UFUNCTION(BlueprintPure, Category = "UI")
 	FText GetTitle() const;
 
+private:
+
+	void RegisterActorClass(UClass* LoadedClass) const;
+
+	static void RebuildClassIndex();
+
+	// false if AssetData isn't a meta asset with an actor class
+	static bool GetIndexKey(const FAssetData& AssetData, FName& OutClassKey);
+	static void AddToClassIndex(const FAssetData& AssetData);
+
+#if WITH_EDITOR
+	// incremental updates for single asset registry events, so bulk imports don't rebuild the whole index per asset
+	static void OnAssetAdded(const FAssetData& AssetData);
+	static void OnAssetRemoved(const FAssetData& AssetData);
+	static void OnAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath);
+#endif // WITH_EDITOR
+
 };
@@ -4,6 +4,8 @@
 
 #include "WorldGrid/WorldGridSubsystem.h"
 
+#include "AssetRegistryModule.h"
+
 DECLARE_LOG_CATEGORY_CLASS(LogDigActualizer, Log, All)
 
 FPickupData UDigActualizer::Actualize() const
@@ -16,7 +18,75 @@ FPickupData UDigActualizer::Actualize() const
 	return FPickupData();
 }
 
+bool UDigActualizer::GetDetectionSummary(const TSoftObjectPtr<UDigActualizer>& Actualizer, FDigDetectionSummary& OutSummary)
+{
+	if (Actualizer.IsNull())
+	{
+		return false;
+	}
+
+	if (const UDigActualizer* LoadedActualizer = Actualizer.Get())
+	{
+		OutSummary = LoadedActualizer->GetDetectionSummary();
+		return true;
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	const FAssetData AssetData = AssetRegistry.GetAssetByObjectPath(Actualizer.ToSoftObjectPath().GetAssetPathName());
+
+	if (AssetData.IsValid()
+		&& AssetData.GetTagValue(GET_MEMBER_NAME_CHECKED(UDigActualizer, DetectionRadius), OutSummary.Radius)
+		&& AssetData.GetTagValue(GET_MEMBER_NAME_CHECKED(UDigActualizer, DetectionRarity), OutSummary.Rarity))
+	{
+		OutSummary.bHasSummary = true;
+		return true;
+	}
+
+	// saved before the detection properties were searchable. load it like we used to rather than failing to place it
+	UE_LOG(LogDigActualizer, Warning, TEXT("'%s' has no detection tags in the asset registry, loading it. resave it to avoid the load"), *Actualizer.ToString());
+	if (const UDigActualizer* LoadedActualizer = Actualizer.LoadSynchronous())
+	{
+		OutSummary = LoadedActualizer->GetDetectionSummary();
+		return true;
+	}
+
+	UE_LOG(LogDigActualizer, Warning, TEXT("No detection summary found for '%s'"), *Actualizer.ToString());
+	return false;
+}
+
 bool ADigActualizerSpawner::TrySpawn_Internal(UWorldGridSubsystem* WorldGrid, const FGridVector& DesiredPosition)
 {
-	return WorldGrid->TryPlaceDigActualizerOnGrid(Actualizer, DesiredPosition);
+	FDigDetectionSummary Summary = CookedDetectionSummary;
+	if (!Summary.IsValid() && !UDigActualizer::GetDetectionSummary(Actualizer, Summary))
+	{
+		return false;
+	}
+
+	return WorldGrid->TryPlaceDigActualizerOnGrid(Actualizer, Summary, DesiredPosition);
+}
+
+#if WITH_EDITOR
+void ADigActualizerSpawner::PreSave(const ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+
+	CookDetectionSummary();
+}
+
+void ADigActualizerSpawner::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(ADigActualizerSpawner, Actualizer))
+	{
+		CookDetectionSummary();
+	}
+}
+
+void ADigActualizerSpawner::CookDetectionSummary()
+{
+	// loading here is fine, this only runs in the editor
+	const UDigActualizer* LoadedActualizer = Actualizer.LoadSynchronous();
+	CookedDetectionSummary = LoadedActualizer ? LoadedActualizer->GetDetectionSummary() : FDigDetectionSummary();
 }
+#endif // WITH_EDITOR
@@ -20,11 +20,12 @@ class ANIMALEFFECT_API UDigActualizer : public UDataAsset
 public:
 
 	// radius in grid cells that the buried item can be detected
-	UPROPERTY(EditAnywhere, Category = "Detection")
+	// searchable so the grid can read it from the asset registry without loading this asset
+	UPROPERTY(EditAnywhere, AssetRegistrySearchable, Category = "Detection")
 	int32 DetectionRadius;
 
 	// the detected rarity of the buried item
-	UPROPERTY(EditAnywhere, Category = "Rarity")
+	UPROPERTY(EditAnywhere, AssetRegistrySearchable, Category = "Rarity")
 	int32 DetectionRarity;
 
 	// this is probably temporary
@@ -35,6 +36,12 @@ public:
 
 	FPickupData Actualize() const;
 
+	FORCEINLINE FDigDetectionSummary GetDetectionSummary() const { return { DetectionRadius, DetectionRarity, true }; }
+
+	// reads the summary from the asset if it's loaded, otherwise from its asset registry tags.
+	// only loads if the asset was saved before the tags existed, and warns so it gets resaved
+	static bool GetDetectionSummary(const TSoftObjectPtr<UDigActualizer>& Actualizer, FDigDetectionSummary& OutSummary);
+
 };
 
 UCLASS()
@@ -46,9 +53,22 @@ protected:
 
 	bool TrySpawn_Internal(UWorldGridSubsystem* WorldGrid, const FGridVector& DesiredPosition) override;
 
+#if WITH_EDITOR
+	void PreSave(const ITargetPlatform* TargetPlatform) override;
+	void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif // WITH_EDITOR
+
 private:
 
+#if WITH_EDITOR
+	void CookDetectionSummary();
+#endif // WITH_EDITOR
+
 	UPROPERTY(EditAnywhere, Category = "Items")
 	TSoftObjectPtr<UDigActualizer> Actualizer;
 
+	// baked from Actualizer in the editor so spawning never has to load or look it up
+	UPROPERTY(VisibleAnywhere, Category = "Items")
+	FDigDetectionSummary CookedDetectionSummary;
+
 };
\ No newline at end of file
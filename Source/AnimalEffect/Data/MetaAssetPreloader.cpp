@@ -0,0 +1,207 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MetaAssetPreloader.h"
+
+#include "AEDataAsset.h"
+#include "DigActualizer.h"
+#include "Inventory/Inventory.h"
+#include "Items/Interfaces/PickupActorInterface.h"
+#include "WorldGrid/WorldGridSubsystem.h"
+
+#include "Engine/AssetManager.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogMetaAssetPreloader, Log, All);
+
+UMetaAssetPreloader* UMetaAssetPreloader::Get(const UObject* WorldContextObject)
+{
+	auto Preloader = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::Assert)->GetSubsystem<UMetaAssetPreloader>();
+	check(Preloader);
+	return Preloader;
+}
+
+void UMetaAssetPreloader::Deinitialize()
+{
+	for (const TPair<int32, TSharedPtr<FStreamableHandle>>& Handle : Handles)
+	{
+		if (Handle.Value.IsValid())
+		{
+			Handle.Value->CancelHandle();
+		}
+	}
+	Handles.Reset();
+	CompletedBatchIds.Reset();
+	RequestedPaths.Reset();
+	PinnedObjects.Reset();
+
+	Super::Deinitialize();
+}
+
+void UMetaAssetPreloader::PreloadActorClasses(const TArray<const UAEMetaAsset*>& MetaAssets)
+{
+	TArray<FSoftObjectPath> PathsToLoad;
+	TArray<TWeakObjectPtr<const UAEMetaAsset>> PendingMetaAssets;
+
+	for (const UAEMetaAsset* MetaAsset : MetaAssets)
+	{
+		if (MetaAsset == nullptr)
+		{
+			continue;
+		}
+
+		// already resident, just make sure it's in the class cache
+		if (MetaAsset->GetLoadedActorClass())
+		{
+			continue;
+		}
+
+		const FSoftObjectPath ActorClassPath = MetaAsset->GetActorClassPtr().ToSoftObjectPath();
+		if (ActorClassPath.IsNull())
+		{
+			continue;
+		}
+
+		bool bAlreadyRequested = false;
+		RequestedPaths.Add(ActorClassPath, &bAlreadyRequested);
+		if (!bAlreadyRequested)
+		{
+			PathsToLoad.Add(ActorClassPath);
+			PendingMetaAssets.Add(MetaAsset);
+		}
+	}
+
+	if (PathsToLoad.Num() == 0)
+	{
+		return;
+	}
+
+	UE_LOG(LogMetaAssetPreloader, Verbose, TEXT("Preloading %d actor classes"), PathsToLoad.Num());
+
+	RequestAsyncLoad(PathsToLoad, PendingMetaAssets);
+}
+
+void UMetaAssetPreloader::PreloadInventory(const FInventory& Inventory)
+{
+	TArray<const UAEMetaAsset*> MetaAssets;
+	for (const FInventorySlotData& Slot : Inventory.Slots)
+	{
+		if (Slot.IsValid())
+		{
+			MetaAssets.AddUnique(Slot.AssetType);
+		}
+	}
+
+	PreloadActorClasses(MetaAssets);
+}
+
+void UMetaAssetPreloader::PreloadInventorySlots(const FInventory& Inventory, const TArray<int32>& Slots)
+{
+	TArray<const UAEMetaAsset*> MetaAssets;
+	for (int32 SlotIndex : Slots)
+	{
+		const FInventorySlotData& Slot = Inventory.Slots[SlotIndex];
+		if (Slot.IsValid())
+		{
+			MetaAssets.AddUnique(Slot.AssetType);
+		}
+	}
+
+	PreloadActorClasses(MetaAssets);
+}
+
+void UMetaAssetPreloader::PreloadAroundGridPosition(const FGridVector& Position, int32 Radius)
+{
+	UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(this);
+
+	TArray<const UAEMetaAsset*> MetaAssets;
+	for (int32 Y = Position.Y - Radius; Y <= Position.Y + Radius; ++Y)
+	{
+		for (int32 X = Position.X - Radius; X <= Position.X + Radius; ++X)
+		{
+			if (const IPickupActorInterface* Pickup = Cast<IPickupActorInterface>(WorldGrid->GetActorAtGridPosition(FGridVector(X, Y))))
+			{
+				FPickupData PickupData;
+				Pickup->GetPickupData(PickupData);
+				if (PickupData.IsValid())
+				{
+					MetaAssets.AddUnique(PickupData.AssetType);
+				}
+			}
+		}
+	}
+
+	PreloadActorClasses(MetaAssets);
+}
+
+void UMetaAssetPreloader::PreloadDigActualizersAroundGridPosition(const FGridVector& Position, int32 Radius)
+{
+	UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(this);
+
+	TArray<FSoftObjectPath> PathsToLoad;
+	for (int32 Y = Position.Y - Radius; Y <= Position.Y + Radius; ++Y)
+	{
+		for (int32 X = Position.X - Radius; X <= Position.X + Radius; ++X)
+		{
+			const TSoftObjectPtr<UDigActualizer> Actualizer = WorldGrid->GetDigActualizerAtPosition(FGridVector(X, Y));
+			if (Actualizer.IsNull() || Actualizer.IsValid())
+			{
+				continue;
+			}
+
+			bool bAlreadyRequested = false;
+			RequestedPaths.Add(Actualizer.ToSoftObjectPath(), &bAlreadyRequested);
+			if (!bAlreadyRequested)
+			{
+				PathsToLoad.Add(Actualizer.ToSoftObjectPath());
+			}
+		}
+	}
+
+	if (PathsToLoad.Num() > 0)
+	{
+		UE_LOG(LogMetaAssetPreloader, Verbose, TEXT("Preloading %d dig actualizers"), PathsToLoad.Num());
+		RequestAsyncLoad(PathsToLoad);
+	}
+}
+
+void UMetaAssetPreloader::RequestAsyncLoad(const TArray<FSoftObjectPath>& PathsToLoad, const TArray<TWeakObjectPtr<const UAEMetaAsset>>& MetaAssets)
+{
+	const int32 BatchId = NextBatchId++;
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(PathsToLoad,
+		FStreamableDelegate::CreateUObject(this, &UMetaAssetPreloader::OnBatchLoaded, BatchId, PathsToLoad, MetaAssets));
+
+	if (Handle.IsValid() && !CompletedBatchIds.Remove(BatchId))
+	{
+		Handles.Add(BatchId, Handle);
+	}
+}
+
+void UMetaAssetPreloader::OnBatchLoaded(int32 BatchId, TArray<FSoftObjectPath> LoadedPaths, TArray<TWeakObjectPtr<const UAEMetaAsset>> LoadedMetaAssets)
+{
+	for (const FSoftObjectPath& Path : LoadedPaths)
+	{
+		if (UObject* LoadedObject = Path.ResolveObject())
+		{
+			PinnedObjects.Add(LoadedObject);
+		}
+		else
+		{
+			UE_LOG(LogMetaAssetPreloader, Warning, TEXT("Failed to preload '%s'"), *Path.ToString());
+			RequestedPaths.Remove(Path);
+		}
+	}
+
+	// registers the loaded classes in the class to meta asset cache
+	for (const TWeakObjectPtr<const UAEMetaAsset>& WeakMetaAsset : LoadedMetaAssets)
+	{
+		if (const UAEMetaAsset* MetaAsset = WeakMetaAsset.Get())
+		{
+			MetaAsset->GetLoadedActorClass();
+		}
+	}
+
+	// everything is pinned now, the handle has nothing left to keep alive
+	if (Handles.Remove(BatchId) == 0)
+	{
+		CompletedBatchIds.Add(BatchId);
+	}
+}
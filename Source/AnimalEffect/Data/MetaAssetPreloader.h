@@ -0,0 +1,67 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Engine/StreamableManager.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "MetaAssetPreloader.generated.h"
+
+class UAEMetaAsset;
+struct FGridVector;
+struct FInventory;
+
+/**
+ * Streams in the actor classes of meta assets in the background before anything asks for them,
+ * so UAEMetaAsset::GetActorClass finds them resident instead of hitching on a synchronous load.
+ * Does the same for buried dig actualizers near the player.
+ * - Requests are batched: every call issues at most one async request for all of its missing classes.
+ * - Loaded classes are registered in the class to meta asset cache as they arrive.
+ * - Loaded classes and actualizers are pinned for the lifetime of the world, and the streamable handle is dropped once they are.
+ * - A path that fails to load is forgotten so the next request for it tries again.
+ */
+UCLASS()
+class ANIMALEFFECT_API UMetaAssetPreloader : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	static UMetaAssetPreloader* Get(const UObject* WorldContextObject);
+
+	void Deinitialize() override;
+
+	void PreloadActorClasses(const TArray<const UAEMetaAsset*>& MetaAssets);
+
+	void PreloadInventory(const FInventory& Inventory);
+	void PreloadInventorySlots(const FInventory& Inventory, const TArray<int32>& Slots);
+
+	// preloads what the pickups within Radius cells of Position would need once they're picked up
+	void PreloadAroundGridPosition(const FGridVector& Position, int32 Radius);
+
+	// streams in what's buried within Radius cells of Position so digging it up resolves immediately
+	void PreloadDigActualizersAroundGridPosition(const FGridVector& Position, int32 Radius);
+
+private:
+
+	void OnBatchLoaded(int32 BatchId, TArray<FSoftObjectPath> LoadedPaths, TArray<TWeakObjectPtr<const UAEMetaAsset>> LoadedMetaAssets);
+
+	// MetaAssets are the ones whose classes are among PathsToLoad, if any
+	void RequestAsyncLoad(const TArray<FSoftObjectPath>& PathsToLoad, const TArray<TWeakObjectPtr<const UAEMetaAsset>>& MetaAssets = TArray<TWeakObjectPtr<const UAEMetaAsset>>());
+
+	// paths that are loading or have loaded. failed paths are removed again
+	TSet<FSoftObjectPath> RequestedPaths;
+
+	// in flight only, by batch id
+	TMap<int32, TSharedPtr<FStreamableHandle>> Handles;
+
+	// batches whose callback ran before RequestAsyncLoad got its handle back, so the handle is never stored
+	TSet<int32> CompletedBatchIds;
+
+	int32 NextBatchId = 0;
+
+	// everything we've loaded, kept alive until the world goes away
+	UPROPERTY(Transient)
+	TSet<UObject*> PinnedObjects;
+
+};
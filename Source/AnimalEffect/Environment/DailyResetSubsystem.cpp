@@ -0,0 +1,404 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DailyResetSubsystem.h"
+
+#include "Data/AEDataAsset.h"
+#include "Environment/Tree.h"
+#include "GameFramework/AEWorldSettings.h"
+#include "WorldGrid/WorldGridInterface.h"
+#include "WorldGrid/WorldGridScatter.h"
+#include "WorldGrid/WorldGridSubsystem.h"
+
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogDailyReset, Log, All);
+
+namespace
+{
+	// positions applied between budget checks
+	constexpr int32 ApplySliceSize = 16;
+
+	FORCEINLINE uint32 HashCell(int32 Seed, int32 Day, int32 CellIndex)
+	{
+		return HashCombine(HashCombine(GetTypeHash(Seed), GetTypeHash(Day)), GetTypeHash(CellIndex));
+	}
+
+	// inputs are gathered from maps and actor lists, sorting them makes the plan independent of that order
+	FORCEINLINE bool SortGridVectors(const FGridVector& A, const FGridVector& B)
+	{
+		return (A.Y != B.Y) ? (A.Y < B.Y) : (A.X < B.X);
+	}
+}
+
+UDailyResetSubsystem* UDailyResetSubsystem::Get(const UObject* WorldContextObject)
+{
+	auto DailyResetSubsystem = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::Assert)->GetSubsystem<UDailyResetSubsystem>();
+	check(DailyResetSubsystem);
+	return DailyResetSubsystem;
+}
+
+void UDailyResetSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Collection.InitializeDependency(UWorldGridSubsystem::StaticClass());
+
+	Super::Initialize(Collection);
+
+	if (const AAEWorldSettings* Settings = Cast<AAEWorldSettings>(GetWorld()->GetWorldSettings()))
+	{
+		Config = Settings->GetDailyResetConfig();
+	}
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UDailyResetSubsystem::OnWorldPostActorTick);
+}
+
+void UDailyResetSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	Batches.Empty();
+	RespawnClasses.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UDailyResetSubsystem::StartNewDay(int32 Day)
+{
+	check(IsInGameThread());
+
+	if (IsResetInProgress())
+	{
+		UE_LOG(LogDailyReset, Warning, TEXT("Can't start day %d, the reset for day %d is still running."), Day, PendingDay);
+		return false;
+	}
+
+	UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(this);
+	const int32 ChunkCountPerSide = WorldGrid->GetChunkCountPerSide();
+
+	// everything that needs actors or dig actualizers is read here, the worker only gets positions
+	TArray<TArray<FGridVector>> StumpsByChunk;
+	StumpsByChunk.SetNum(ChunkCountPerSide * ChunkCountPerSide);
+
+	// an unloaded class can't have any instances, so only loaded ones are counted
+	TArray<UClass*> LoadedRespawnClasses;
+	for (const FWorldGridScatterRule& Rule : Config.RespawnRules)
+	{
+		LoadedRespawnClasses.Add(Rule.Asset ? *Rule.Asset->GetLoadedActorClass() : nullptr);
+	}
+
+	TArray<TArray<FGridVector>> ExistingByRule;
+	ExistingByRule.SetNum(Config.RespawnRules.Num());
+
+	TArray<AActor*> Actors;
+	WorldGrid->GetActorsInRect(FGridRect(FGridVector(0, 0), FGridVector(WorldGrid->GetConfig().Width)), Actors);
+	for (AActor* Actor : Actors)
+	{
+		FGridVector Position;
+		if (!WorldGrid->GetActorGridPosition(Actor, Position))
+		{
+			continue;
+		}
+
+		const ATree* Tree = Cast<ATree>(Actor);
+		if (Tree && Tree->IsStump())
+		{
+			const FGridVector Chunk = WorldGrid->GetChunkForGridPosition(Position);
+			StumpsByChunk[(Chunk.Y * ChunkCountPerSide) + Chunk.X].Add(Position);
+		}
+
+		for (int32 RuleIndex = 0; RuleIndex < LoadedRespawnClasses.Num(); ++RuleIndex)
+		{
+			if (LoadedRespawnClasses[RuleIndex] && Actor->IsA(LoadedRespawnClasses[RuleIndex]))
+			{
+				ExistingByRule[RuleIndex].Add(Position);
+			}
+		}
+	}
+
+	for (TArray<FGridVector>& Existing : ExistingByRule)
+	{
+		Existing.Sort(&SortGridVectors);
+	}
+
+	TArray<TArray<FGridVector>> DigSpotsByChunk;
+	DigSpotsByChunk.SetNum(ChunkCountPerSide * ChunkCountPerSide);
+
+	TArray<FGridVector> DigSpots;
+	WorldGrid->GetDigActualizerPositions(DigSpots);
+	for (const FGridVector& Position : DigSpots)
+	{
+		const FGridVector Chunk = WorldGrid->GetChunkForGridPosition(Position);
+		DigSpotsByChunk[(Chunk.Y * ChunkCountPerSide) + Chunk.X].Add(Position);
+	}
+
+	TArray<FGridVector> RespawnSizes;
+	RespawnSizes.Reserve(Config.RespawnRules.Num());
+	for (const FWorldGridScatterRule& Rule : Config.RespawnRules)
+	{
+		const IWorldGridInterface* WorldGridInterface = Cast<IWorldGridInterface>(Rule.Asset);
+		RespawnSizes.Add(WorldGridInterface ? WorldGridInterface->GetWorldGridSize() : FGridVector(1));
+	}
+
+	bPlanning = true;
+	PendingDay = Day;
+
+	// streamed in while the worker plans, spawning a batch mustn't be what loads them
+	TWeakObjectPtr<UDailyResetSubsystem> WeakThisForLoads(this);
+	RespawnClasses.Reset();
+	for (const FWorldGridScatterRule& Rule : Config.RespawnRules)
+	{
+		if (Rule.Asset == nullptr)
+		{
+			continue;
+		}
+
+		++PendingClassLoads;
+		Rule.Asset->GetActorClassAsync(FOnActorClassLoaded::CreateLambda([WeakThisForLoads](TSubclassOf<AActor> ActorClass)
+		{
+			if (UDailyResetSubsystem* This = WeakThisForLoads.Get())
+			{
+				// a class that failed to load just spawns nothing, SpawnActorsOnGridBatch says why
+				if (ActorClass)
+				{
+					This->RespawnClasses.Add(ActorClass);
+				}
+				--This->PendingClassLoads;
+			}
+		}));
+	}
+
+	FWorldGridSnapshotPtr Snapshot = WorldGrid->GetSnapshot();
+	TWeakObjectPtr<UDailyResetSubsystem> WeakThis(this);
+	const FDailyResetConfig Settings = Config;
+	const double StartTime = FPlatformTime::Seconds();
+
+	Async(EAsyncExecution::ThreadPool, [Snapshot, Settings, Day, StumpsByChunk = MoveTemp(StumpsByChunk), DigSpotsByChunk = MoveTemp(DigSpotsByChunk),
+		RespawnSizes = MoveTemp(RespawnSizes), ExistingByRule = MoveTemp(ExistingByRule), WeakThis, StartTime]()
+	{
+		TArray<FDailyResetBatch> NewBatches;
+		PlanReset(*Snapshot, Settings, Day, StumpsByChunk, DigSpotsByChunk, RespawnSizes, ExistingByRule, NewBatches);
+
+		UE_LOG(LogDailyReset, Log, TEXT("Planned day %d in %.2fms."), Day, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Day, NewBatches = MoveTemp(NewBatches)]() mutable
+		{
+			// the world went away while we were planning
+			if (UDailyResetSubsystem* This = WeakThis.Get())
+			{
+				This->OnResetPlanned(Day, MoveTemp(NewBatches));
+			}
+		});
+	});
+
+	return true;
+}
+
+void UDailyResetSubsystem::PlanReset(const FWorldGridSnapshot& Snapshot, const FDailyResetConfig& Settings, int32 Day, const TArray<TArray<FGridVector>>& StumpsByChunk,
+	const TArray<TArray<FGridVector>>& DigSpotsByChunk, const TArray<FGridVector>& RespawnSizes, const TArray<TArray<FGridVector>>& ExistingByRule,
+	TArray<FDailyResetBatch>& OutBatches)
+{
+	const int32 Width = Snapshot.GetWidth();
+	const int32 ChunkCount = StumpsByChunk.Num();
+	const uint32 RegrowThreshold = static_cast<uint32>(FMath::Clamp(Settings.RegrowChance, 0.f, 1.f) * 65536.f);
+
+	// every chunk only writes its own lists
+	TArray<TArray<FGridVector>> RegrowByChunk;
+	TArray<TArray<FGridVector>> ClearByChunk;
+	RegrowByChunk.SetNum(ChunkCount);
+	ClearByChunk.SetNum(ChunkCount);
+
+	ParallelFor(ChunkCount, [&](int32 ChunkIndex)
+	{
+		TArray<FGridVector>& Regrow = RegrowByChunk[ChunkIndex];
+		for (const FGridVector& Position : StumpsByChunk[ChunkIndex])
+		{
+			if ((HashCell(Settings.Seed, Day, (Position.Y * Width) + Position.X) & 0xFFFF) < RegrowThreshold)
+			{
+				Regrow.Add(Position);
+			}
+		}
+		Regrow.Sort(&SortGridVectors);
+
+		ClearByChunk[ChunkIndex] = DigSpotsByChunk[ChunkIndex];
+		ClearByChunk[ChunkIndex].Sort(&SortGridVectors);
+	});
+
+	FDailyResetBatch& RegrowBatch = OutBatches.AddDefaulted_GetRef();
+	RegrowBatch.Stage = EDailyResetStage::Regrow;
+	for (const TArray<FGridVector>& Regrow : RegrowByChunk)
+	{
+		RegrowBatch.Positions.Append(Regrow);
+	}
+
+	// respawns and burials are scattered together, so nothing gets buried under something that's about to grow there
+	TArray<FWorldGridScatterRule> Rules = Settings.RespawnRules;
+	TArray<TArray<FGridVector>> Existing = ExistingByRule;
+	for (int32 RuleIndex = 0; RuleIndex < Rules.Num(); ++RuleIndex)
+	{
+		// MaxCount is the total to top up to, not how many to add
+		FWorldGridScatterRule& Rule = Rules[RuleIndex];
+		if (Rule.MaxCount > 0)
+		{
+			Rule.MaxCount -= Existing[RuleIndex].Num();
+			if (Rule.MaxCount <= 0)
+			{
+				// 0 would mean no limit
+				Rule.MaxCount = 0;
+				Rule.Density = 0.f;
+			}
+		}
+	}
+	Rules.Append(Settings.BuryRules);
+	Existing.SetNum(Rules.Num());
+
+	TArray<FGridVector> Sizes = RespawnSizes;
+	for (int32 RuleIndex = 0; RuleIndex < Settings.BuryRules.Num(); ++RuleIndex)
+	{
+		Sizes.Add(FGridVector(1));
+	}
+
+	TArray<TArray<FGridVector>> Placements;
+	FWorldGridScatter::Scatter(Snapshot, Rules, Sizes, HashCombine(GetTypeHash(Settings.Seed), GetTypeHash(Day)), Placements, &Existing);
+
+	for (int32 RuleIndex = 0; RuleIndex < Settings.RespawnRules.Num(); ++RuleIndex)
+	{
+		if (Settings.RespawnRules[RuleIndex].Asset == nullptr)
+		{
+			continue;
+		}
+
+		FDailyResetBatch& RespawnBatch = OutBatches.AddDefaulted_GetRef();
+		RespawnBatch.Stage = EDailyResetStage::Respawn;
+		RespawnBatch.RuleIndex = RuleIndex;
+		RespawnBatch.Positions = MoveTemp(Placements[RuleIndex]);
+	}
+
+	FDailyResetBatch& ClearBatch = OutBatches.AddDefaulted_GetRef();
+	ClearBatch.Stage = EDailyResetStage::ClearDigSpots;
+	for (const TArray<FGridVector>& Clear : ClearByChunk)
+	{
+		ClearBatch.Positions.Append(Clear);
+	}
+
+	for (int32 RuleIndex = 0; RuleIndex < Settings.BuryRules.Num(); ++RuleIndex)
+	{
+		if (Settings.BuryRules[RuleIndex].Actualizer.IsNull())
+		{
+			continue;
+		}
+
+		FDailyResetBatch& BuryBatch = OutBatches.AddDefaulted_GetRef();
+		BuryBatch.Stage = EDailyResetStage::Bury;
+		BuryBatch.RuleIndex = RuleIndex;
+		BuryBatch.Positions = MoveTemp(Placements[Settings.RespawnRules.Num() + RuleIndex]);
+	}
+}
+
+void UDailyResetSubsystem::OnResetPlanned(int32 Day, TArray<FDailyResetBatch>&& NewBatches)
+{
+	bPlanning = false;
+
+	Batches = MoveTemp(NewBatches);
+	BatchIndex = 0;
+	PositionIndex = 0;
+	ApplyStartTime = FPlatformTime::Seconds();
+}
+
+void UDailyResetSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if ((World != GetWorld()) || (Batches.Num() == 0))
+	{
+		return;
+	}
+
+	if (PendingClassLoads > 0)
+	{
+		return;
+	}
+
+	// at least one slice goes through every frame, however small the budget
+	const double EndTime = FPlatformTime::Seconds() + (Config.FrameBudgetMs / 1000.0);
+	do
+	{
+		const FDailyResetBatch& Batch = Batches[BatchIndex];
+		const int32 Count = FMath::Min(ApplySliceSize, Batch.Positions.Num() - PositionIndex);
+		ApplyBatchSlice(Batch, PositionIndex, Count);
+
+		PositionIndex += Count;
+		if (PositionIndex >= Batch.Positions.Num())
+		{
+			++BatchIndex;
+			PositionIndex = 0;
+		}
+	}
+	while ((BatchIndex < Batches.Num()) && (FPlatformTime::Seconds() < EndTime));
+
+	if (BatchIndex < Batches.Num())
+	{
+		return;
+	}
+
+	Batches.Reset();
+	BatchIndex = 0;
+	RespawnClasses.Reset();
+	CurrentDay = PendingDay;
+
+	UE_LOG(LogDailyReset, Log, TEXT("Day %d reset applied in %.2fms."), CurrentDay, (FPlatformTime::Seconds() - ApplyStartTime) * 1000.0);
+	OnDailyResetComplete.Broadcast(CurrentDay);
+}
+
+void UDailyResetSubsystem::ApplyBatchSlice(const FDailyResetBatch& Batch, int32 Start, int32 Count)
+{
+	UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(this);
+	const TArrayView<const FGridVector> Positions(Batch.Positions.GetData() + Start, Count);
+
+	switch (Batch.Stage)
+	{
+	case EDailyResetStage::Regrow:
+		for (const FGridVector& Position : Positions)
+		{
+			// the stump may have been removed since the reset was planned
+			if (ATree* Tree = Cast<ATree>(WorldGrid->GetActorAtGridPosition(Position)))
+			{
+				Tree->Regrow();
+			}
+		}
+		break;
+
+	case EDailyResetStage::Respawn:
+		WorldGrid->SpawnActorsOnGridBatch(Config.RespawnRules[Batch.RuleIndex].Asset, Positions);
+		break;
+
+	case EDailyResetStage::ClearDigSpots:
+		for (const FGridVector& Position : Positions)
+		{
+			WorldGrid->TryRemoveDigActualizerFromGrid(Position);
+		}
+		break;
+
+	case EDailyResetStage::Bury:
+		WorldGrid->PlaceDigActualizersOnGridBatch(Config.BuryRules[Batch.RuleIndex].Actualizer, Positions);
+		break;
+	}
+}
+
+namespace
+{
+	void StartNewDayCommand(const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr)
+		{
+			return;
+		}
+
+		UDailyResetSubsystem* DailyReset = UDailyResetSubsystem::Get(World);
+		const int32 Day = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : DailyReset->GetCurrentDay() + 1;
+		DailyReset->StartNewDay(Day);
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs StartNewDayConsoleCommand(
+		TEXT("AE.StartNewDay"),
+		TEXT("Regrows stumps, respawns resources and reburies dig spots in the current world. Usage: AE.StartNewDay [Day=current day + 1]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartNewDayCommand));
+}
@@ -0,0 +1,127 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGrid/WorldGridSnapshot.h"
+#include "WorldGrid/WorldGridTypes.h"
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "DailyResetSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FDailyResetConfig
+{
+	GENERATED_BODY()
+
+	// the same seed and day always reset a world in the same state the same way
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Seed = 1;
+
+	// 0 to 1, the chance a stump grows back on any given day
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0, ClampMax = 1))
+	float RegrowChance = 1.f;
+
+	// resources that grow back each day. each rule is topped up to its MaxCount (0 is no limit) around the ones still standing,
+	// keeping its spacing from them, so a day only fills in what was harvested
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<FWorldGridScatterRule> RespawnRules;
+
+	// everything buried is dug up at the start of a day and these are buried instead
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<FWorldGridScatterRule> BuryRules;
+
+	// game thread time a reset may take per frame while it's being applied
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0.1))
+	float FrameBudgetMs = 1.f;
+};
+
+enum class EDailyResetStage : uint8
+{
+	Regrow,
+	Respawn,
+	ClearDigSpots,
+	Bury,
+};
+
+// the cells one stage of a reset touches, applied in order
+struct FDailyResetBatch
+{
+	EDailyResetStage Stage = EDailyResetStage::Regrow;
+
+	// index into the stage's rules, for Respawn and Bury
+	int32 RuleIndex = INDEX_NONE;
+
+	TArray<FGridVector> Positions;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnDailyResetComplete, int32 /*Day*/);
+
+/**
+ * Resets the world for a new day: stumps regrow, resources respawn and buried items are dug up and buried elsewhere.
+ * - The game thread only gathers stumps and dig spots per chunk and takes a grid snapshot.
+ * - A worker plans the reset from those, chunk by chunk in parallel, plus a FWorldGridScatter pass for respawns and burying.
+ * - Respawn classes are streamed in while the reset is planned. Applying waits for them rather than loading on the game thread.
+ * - The plan comes back as one batch per stage, applied on the game thread a slice at a time under FDailyResetConfig::FrameBudgetMs,
+ *   so a reset never hitches no matter how big the island, or how many of them a server runs.
+ * Every random choice is hashed from the seed, the day and the cell, so replaying a day on the same world gives the same result.
+ */
+UCLASS()
+class ANIMALEFFECT_API UDailyResetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	static UDailyResetSubsystem* Get(const UObject* WorldContextObject);
+
+	void Initialize(FSubsystemCollectionBase& Collection) override;
+	void Deinitialize() override;
+
+	// game thread only. returns false if the last reset is still being planned or applied
+	bool StartNewDay(int32 Day);
+
+	FORCEINLINE bool IsResetInProgress() const { return bPlanning || (Batches.Num() > 0) || (PendingClassLoads > 0); }
+
+	// the last day whose reset finished
+	FORCEINLINE int32 GetCurrentDay() const { return CurrentDay; }
+
+	// broadcast once the last batch of a reset has been applied
+	FOnDailyResetComplete OnDailyResetComplete;
+
+private:
+
+	// runs on a worker. inputs are bucketed by chunk, row-major
+	static void PlanReset(const FWorldGridSnapshot& Snapshot, const FDailyResetConfig& Settings, int32 Day, const TArray<TArray<FGridVector>>& StumpsByChunk,
+		const TArray<TArray<FGridVector>>& DigSpotsByChunk, const TArray<FGridVector>& RespawnSizes, const TArray<TArray<FGridVector>>& ExistingByRule,
+		TArray<FDailyResetBatch>& OutBatches);
+
+	void OnResetPlanned(int32 Day, TArray<FDailyResetBatch>&& NewBatches);
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void ApplyBatchSlice(const FDailyResetBatch& Batch, int32 Start, int32 Count);
+
+	FDailyResetConfig Config;
+
+	bool bPlanning = false;
+	int32 PendingDay = 0;
+	int32 CurrentDay = 0;
+
+	// what's left of the reset being applied. BatchIndex and PositionIndex are where the next frame picks up
+	TArray<FDailyResetBatch> Batches;
+	int32 BatchIndex = 0;
+	int32 PositionIndex = 0;
+
+	double ApplyStartTime = 0.0;
+
+	// respawn classes still streaming in. nothing is applied until they're all here
+	int32 PendingClassLoads = 0;
+
+	// keeps the respawn classes loaded until the reset has spawned them
+	UPROPERTY(Transient)
+	TArray<UClass*> RespawnClasses;
+
+	FDelegateHandle PostActorTickHandle;
+
+};
@@ -10,6 +10,13 @@ ATree::ATree()
 
 }
 
+void ATree::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Health = MaxHealth;
+}
+
 void ATree::OnAxeHit(APawn* HitInstigator)
 {
 	if (Health == 0)
@@ -24,3 +31,14 @@ void ATree::OnAxeHit(APawn* HitInstigator)
 		
 	}
 }
+
+void ATree::Regrow()
+{
+	if (Health == MaxHealth)
+	{
+		return;
+	}
+
+	Health = MaxHealth;
+	OnRegrown();
+}
@@ -37,8 +37,24 @@ public:
 
 	void OnAxeHit(APawn* HitInstigator);
 
+	// a tree chopped down to 0 health stays on the grid as a stump until it regrows
+	FORCEINLINE bool IsStump() const { return Health == 0; }
+
+	// back to full health, usually at the start of a new day
+	void Regrow();
+
+protected:
+
+	void BeginPlay() override;
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Health")
+	void OnRegrown();
+
 private:
 
+	UPROPERTY(EditDefaultsOnly, Category = "Health", meta = (ClampMin = 1))
+	int32 MaxHealth = 3;
+
 	UPROPERTY(BlueprintReadOnly, Category = "Health", meta = (AllowPrivateAccess = true))
 	int32 Health;
 
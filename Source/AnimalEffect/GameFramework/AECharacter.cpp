@@ -3,16 +3,19 @@
 #include "AECharacter.h"
 
 #include "Data/AEDataAsset.h"
+#include "Data/MetaAssetPreloader.h"
 #include "Inventory/InventoryItemInterface.h"
 #include "Items/DropActor.h"
 #include "Items/Interfaces/InteractableActorInterface.h"
 #include "Tools/Tool.h"
+#include "WorldGrid/GridCellTrackerComponent.h"
 #include "WorldGrid/WorldGridInterface.h"
 #include "WorldGrid/WorldGridSubsystem.h"
 
 #include "Camera/CameraComponent.h"
 #include "Components/BoxComponent.h"
 #include "Gameframework/SpringArmComponent.h"
+#include "Net/UnrealNetwork.h"
 
 DECLARE_LOG_CATEGORY_CLASS(LogAECharacter, Log, All);
 
@@ -29,6 +32,8 @@ AAECharacter::AAECharacter(const FObjectInitializer& OI)
 	InteractableCollisionComponent = CreateDefaultSubobject<UBoxComponent>(TEXT("InteractableCollision"));
 	InteractableCollisionComponent->SetupAttachment(GetRootComponent());
 	InteractableCollisionComponent->SetCollisionProfileName(TEXT("PawnInteractableCollision"), false);
+
+	GridCellTrackerComponent = CreateDefaultSubobject<UGridCellTrackerComponent>(TEXT("GridCellTracker"));
 }
 
 void AAECharacter::Tick(float DeltaTime)
@@ -37,11 +42,35 @@ void AAECharacter::Tick(float DeltaTime)
 
 	GEngine->AddOnScreenDebugMessage(1, 0.f, FColor::Green, FString::Printf(TEXT("CurrentTool: %s"), IsValid(EquippedToolInstance) ? *EquippedToolInstance->GetName() : TEXT("none")));
 
-	ScanForInteractables();
+#if !UE_BUILD_SHIPPING
+	if (IPickupActorInterface* Pickup = CurrentPickup.GetInterface())
+	{
+		FText PickupText;
+		Pickup->GetPickupText(PickupText);
+		GEngine->AddOnScreenDebugMessage(2, 0.f, FColor::Cyan, FString::Printf(TEXT("Pickup: %s"), *PickupText.ToString()));
+	}
+#endif // !UE_BUILD_SHIPPING
 
 	TickEquippedTool(DeltaTime);
 }
 
+void AAECharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// set here rather than in the constructor so the pointers aren't copied from the archetype
+	ReplicatedItemInventory.SetClientInventory(&ItemInventory);
+	ReplicatedToolInventory.SetClientInventory(&ToolInventory);
+}
+
+void AAECharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(AAECharacter, ReplicatedItemInventory, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AAECharacter, ReplicatedToolInventory, COND_OwnerOnly);
+}
+
 void AAECharacter::TickEquippedTool(float DeltaTime)
 {
 	if (IsValid(EquippedToolInstance) && !IsPerformingAction())
@@ -64,8 +93,8 @@ void AAECharacter::ScanForInteractables()
 	{
 		CurrentPickup = nullptr; // clear previous scan's pickup
 
-		FGridVector GridPosition;
-		if (WorldGrid->GetGridPositionAtWorldLocation(GetActorLocation(), GridPosition))
+		const FGridVector& GridPosition = GridCellTrackerComponent->GetCurrentCell();
+		if (GridPosition.IsValid())
 		{
 			// should we be casting to a drop here explicitly? this method is really only for drops
 			if (IPickupActorInterface* Pickup = Cast<IPickupActorInterface>(WorldGrid->GetActorAtGridPosition(GridPosition)))
@@ -73,9 +102,6 @@ void AAECharacter::ScanForInteractables()
 				if (Pickup->CanPickup(this))
 				{
 					CurrentPickup = Cast<AActor>(Pickup); // #hack
-					FText PickupText;
-					Pickup->GetPickupText(PickupText);
-					GEngine->AddOnScreenDebugMessage(1, 0, FColor::Cyan, FString::Printf(TEXT("Pickup: %s"), *PickupText.ToString()));
 				}
 			}
 		}
@@ -109,6 +135,13 @@ void AAECharacter::OnToolFinishAction()
 {
 	check(IsValid(EquippedToolInstance));
 	bToolIsPerformingAction = false;
+
+	if (PendingToolValidations.Num() > 0)
+	{
+		const TArray<int32> PendingSlots = MoveTemp(PendingToolValidations);
+		PendingToolValidations.Reset();
+		ValidateToolInstances(PendingSlots);
+	}
 }
 
 bool AAECharacter::TryPickup()
@@ -183,7 +216,7 @@ void AAECharacter::EquipTool(int32 ToolIndex)
 	if (ToolInventory.GetAtIndex(ToolIndex, Tool))
 	{
 		// #todo: replicate Tool.Class and Call InstanceTool upon replication. 
-		EquippedToolInstance = InstanceTool(*Tool.AssetType->GetActorClass());
+		EquippedToolInstance = GetOrCreateToolInstance(ToolIndex);
 
 		if (IsValid(EquippedToolInstance))
 		{
@@ -209,10 +242,10 @@ void AAECharacter::UnequipTool(int32 ToolIndex)
 	LastEquippedToolIndex = EquippedToolIndex;
 	EquippedToolIndex = INDEX_NONE;
 
+	// the instance stays cached (and hidden) for the next time this slot is equipped
 	if (IsValid(EquippedToolInstance))
 	{
 		EquippedToolInstance->OnUnequipped();
-		EquippedToolInstance->Destroy();
 		EquippedToolInstance = nullptr;
 	}
 }
@@ -230,6 +263,89 @@ namespace
 	}
 }
 
+void AAECharacter::OnInventorySlotsChanged(const FInventory& Inventory, const TArray<int32>& ChangedSlots)
+{
+	UMetaAssetPreloader::Get(this)->PreloadInventorySlots(Inventory, ChangedSlots);
+
+	if ((Inventory.Type == EInventoryType::Tool) && !bRemappingToolInstances)
+	{
+		ValidateToolInstances(ChangedSlots);
+	}
+
+	if (HasAuthority())
+	{
+		FInventoryReplicationArray& ReplicatedInventory = (Inventory.Type == EInventoryType::Tool) ? ReplicatedToolInventory : ReplicatedItemInventory;
+		ReplicatedInventory.ServerSyncSlots(Inventory, ChangedSlots);
+	}
+
+	if (!OnInventorySlotHandlesChanged.IsBound())
+	{
+		return;
+	}
+
+	TArray<FInventorySlotHandle> ChangedHandles;
+	ChangedHandles.Reserve(ChangedSlots.Num());
+	for (int32 SlotIndex : ChangedSlots)
+	{
+		ChangedHandles.Add({ Inventory.Type, SlotIndex });
+	}
+
+	OnInventorySlotHandlesChanged.Broadcast(ChangedHandles);
+}
+
+void AAECharacter::OnStorageSlotsChanged(const TArray<int32>& ChangedSlots)
+{
+	if (!OnInventorySlotHandlesChanged.IsBound())
+	{
+		return;
+	}
+
+	TArray<FInventorySlotHandle> ChangedHandles;
+	ChangedHandles.Reserve(ChangedSlots.Num());
+	for (int32 SlotIndex : ChangedSlots)
+	{
+		ChangedHandles.Add({ EInventoryType::Storage, SlotIndex });
+	}
+
+	OnInventorySlotHandlesChanged.Broadcast(ChangedHandles);
+}
+
+void AAECharacter::OnGridCellChanged(const FGridVector& PreviousCell, const FGridVector& NewCell)
+{
+	ScanForInteractables();
+
+	if (NewCell.IsValid())
+	{
+		PreloadAroundCell(NewCell);
+	}
+}
+
+void AAECharacter::OnGridOccupantsChanged(const FGridVector& StartPosition, const FGridVector& EndPosition, AActor* NewOccupant)
+{
+	const FGridVector& Cell = GridCellTrackerComponent->GetCurrentCell();
+	if ((Cell.X >= StartPosition.X) && (Cell.X < EndPosition.X) && (Cell.Y >= StartPosition.Y) && (Cell.Y < EndPosition.Y))
+	{
+		ScanForInteractables();
+	}
+}
+
+void AAECharacter::PreloadAroundCell(const FGridVector& Cell)
+{
+	UMetaAssetPreloader* Preloader = UMetaAssetPreloader::Get(this);
+	Preloader->PreloadAroundGridPosition(Cell, PreloadRadius);
+	Preloader->PreloadDigActualizersAroundGridPosition(Cell, DigPreloadRadius);
+}
+
+void AAECharacter::OnRep_ReplicatedItemInventory()
+{
+	ReplicatedItemInventory.ClientBroadcastChanges();
+}
+
+void AAECharacter::OnRep_ReplicatedToolInventory()
+{
+	ReplicatedToolInventory.ClientBroadcastChanges();
+}
+
 bool AAECharacter::GetInventoryLayoutData(EInventoryType InventoryType, FInventoryLayoutData& OutData) const
 {
 
@@ -248,11 +364,18 @@ bool AAECharacter::GetInventoryLayoutData(EInventoryType InventoryType, FInvento
 		OutData.NumRows = ToolInventory.RowCount;
 		GenerateSlotHandles(InventoryType, ItemInventory.ColCount * ItemInventory.RowCount, OutData.SlotHandles);
 		return true;
+	case EInventoryType::Storage:
+		return GetStoragePageLayoutData(0, OutData);
 	default:
 		return false;
 	}
 }
 
+bool AAECharacter::GetStoragePageLayoutData(int32 PageIndex, FInventoryLayoutData& OutData) const
+{
+	return StorageInventory.GetPageLayoutData(PageIndex, OutData);
+}
+
 FInventory& AAECharacter::GetInventoryFromHandle(const FInventorySlotHandle& Handle)
 {
 	switch (Handle.InventoryType)
@@ -262,7 +385,7 @@ FInventory& AAECharacter::GetInventoryFromHandle(const FInventorySlotHandle& Han
 	case EInventoryType::Tool:
 		return ToolInventory;
 	default:
-		check(false);
+		checkf(false, TEXT("No single inventory for '%s' handles"), *UEnum::GetValueAsString(Handle.InventoryType));
 	}
 
 	return ItemInventory;
@@ -277,7 +400,7 @@ const FInventory& AAECharacter::GetInventoryFromHandle(const FInventorySlotHandl
 	case EInventoryType::Tool:
 		return ToolInventory;
 	default:
-		check(false);
+		checkf(false, TEXT("No single inventory for '%s' handles"), *UEnum::GetValueAsString(Handle.InventoryType));
 	}
 
 	return ItemInventory;
@@ -285,6 +408,11 @@ const FInventory& AAECharacter::GetInventoryFromHandle(const FInventorySlotHandl
 
 bool AAECharacter::GetInventorySlotFromHandle(const FInventorySlotHandle& Handle, FInventorySlotData& OutData) const
 {
+	if (Handle.InventoryType == EInventoryType::Storage)
+	{
+		return StorageInventory.GetAtIndex(Handle.SlotIndex, OutData);
+	}
+
 	return GetInventoryFromHandle(Handle).GetAtIndex(Handle.SlotIndex, OutData);
 }
 
@@ -341,6 +469,68 @@ void AAECharacter::OnInventorySlotActionSelectedForHandle(const FInventorySlotHa
 	}
 }
 
+void AAECharacter::SortInventory(EInventoryType InventoryType, EInventorySortKey SortKey)
+{
+	if (IsPerformingAction())
+	{
+		return;
+	}
+
+	TArray<int32> SlotRemap;
+	switch (InventoryType)
+	{
+	case EInventoryType::Item:
+		ItemInventory.SortAndConsolidate(SortKey, SlotRemap);
+		break;
+	case EInventoryType::Storage:
+		StorageInventory.SortAndCompact(SortKey);
+		break;
+	case EInventoryType::Tool:
+	{
+		{
+			TGuardValue<bool> RemapGuard(bRemappingToolInstances, true);
+			ToolInventory.SortAndConsolidate(SortKey, SlotRemap);
+		}
+
+		// the equipped tool stays equipped, it just lives in a different slot now
+		if (SlotRemap.IsValidIndex(EquippedToolIndex))
+		{
+			EquippedToolIndex = SlotRemap[EquippedToolIndex];
+		}
+		if (SlotRemap.IsValidIndex(LastEquippedToolIndex))
+		{
+			LastEquippedToolIndex = SlotRemap[LastEquippedToolIndex];
+		}
+
+		RemapToolInstances(SlotRemap);
+
+		// instances move with their slots. only slots no old slot landed in (the spill of a split stack) can hold something new
+		TBitArray<> RemapTargets(false, ToolInventory.Slots.Num());
+		for (int32 NewIndex : SlotRemap)
+		{
+			if (RemapTargets.IsValidIndex(NewIndex))
+			{
+				RemapTargets[NewIndex] = true;
+			}
+		}
+
+		TArray<int32> SpilledSlots;
+		for (int32 SlotIndex = 0; SlotIndex < ToolInventory.Slots.Num(); ++SlotIndex)
+		{
+			if (!RemapTargets[SlotIndex])
+			{
+				SpilledSlots.Add(SlotIndex);
+			}
+		}
+		ValidateToolInstances(SpilledSlots);
+		break;
+	}
+	default:
+		UE_LOG(LogAECharacter, Error, TEXT("Attempted to sort unsupported inventory '%s'"), *UEnum::GetValueAsString(InventoryType));
+		break;
+	}
+}
+
 bool AAECharacter::TryDropItemForSlotHandle(const FInventorySlotHandle& Handle)
 {
 	check(!IsPerformingAction()); // this callback should really only come from a menu, during which we should not be in the state "IsPerformingAction"
@@ -351,7 +541,10 @@ bool AAECharacter::TryDropItemForSlotHandle(const FInventorySlotHandle& Handle)
 	}
 
 	FInventorySlotData RemovedItem;
-	if (GetInventoryFromHandle(Handle).TryRemoveAtIndex(Handle.SlotIndex, RemovedItem))
+	const bool bRemoved = (Handle.InventoryType == EInventoryType::Storage)
+		? StorageInventory.TryRemoveAtIndex(Handle.SlotIndex, RemovedItem)
+		: GetInventoryFromHandle(Handle).TryRemoveAtIndex(Handle.SlotIndex, RemovedItem);
+	if (bRemoved)
 	{
 		FGridVector DropPosition;
 		if (WorldGrid->GetGridPositionAtWorldLocation(GetActorLocation(), DropPosition))
@@ -382,7 +575,7 @@ bool AAECharacter::TryPlaceItemForSlotHandle(const FInventorySlotHandle& Handle)
 	}
 
 	FInventorySlotData ItemSlot;
-	if (GetInventoryFromHandle(Handle).GetAtIndex(Handle.SlotIndex, ItemSlot))
+	if (GetInventorySlotFromHandle(Handle, ItemSlot))
 	{
 		// #hack: we should not have to get worldgridinterface here
 		const IWorldGridInterface* WorldGridInterface = Cast<IWorldGridInterface>(ItemSlot.AssetType);
@@ -401,7 +594,14 @@ bool AAECharacter::TryPlaceItemForSlotHandle(const FInventorySlotHandle& Handle)
 			SpawnParams.Owner = this;
 			if (AActor* PlacingActor = WorldGrid->TrySpawnActorOnGrid(ItemSlot.AssetType, SpawnParams))
 			{
-				GetInventoryFromHandle(Handle).TryRemoveSingleAtIndex(Handle.SlotIndex, ItemSlot);
+				if (Handle.InventoryType == EInventoryType::Storage)
+				{
+					StorageInventory.TryRemoveSingleAtIndex(Handle.SlotIndex, ItemSlot);
+				}
+				else
+				{
+					GetInventoryFromHandle(Handle).TryRemoveSingleAtIndex(Handle.SlotIndex, ItemSlot);
+				}
 				return true;
 			}
 		}
@@ -432,7 +632,61 @@ void AAECharacter::BeginPlay()
 	ToolInventory.InitializeInventory(this, EInventoryType::Tool, true);
 	ItemInventory.InitializeInventory(this, EInventoryType::Item);
 
+	ToolInventory.OnSlotsChanged.AddUObject(this, &AAECharacter::OnInventorySlotsChanged);
+	ItemInventory.OnSlotsChanged.AddUObject(this, &AAECharacter::OnInventorySlotsChanged);
+
+	StorageInventory.InitializeStorage(this);
+	StorageInventory.OnSlotsChanged.AddUObject(this, &AAECharacter::OnStorageSlotsChanged);
+
+	// default contents were put in before we were listening for changes
+	if (HasAuthority())
+	{
+		ReplicatedToolInventory.ServerSyncAllSlots(ToolInventory);
+		ReplicatedItemInventory.ServerSyncAllSlots(ItemInventory);
+	}
+
+	CraftingAvailability.Initialize(KnownRecipes, ItemInventory);
+
 	WorldGrid = GetWorld()->GetSubsystem<UWorldGridSubsystem>();
+
+	UMetaAssetPreloader* Preloader = UMetaAssetPreloader::Get(this);
+	Preloader->PreloadInventory(ToolInventory);
+	Preloader->PreloadInventory(ItemInventory);
+
+	ToolInstances.SetNumZeroed(ToolInventory.Slots.Num());
+	ToolInstanceAssets.SetNum(ToolInventory.Slots.Num());
+	TArray<int32> AllToolSlots;
+	for (int32 ToolIndex = 0; ToolIndex < ToolInventory.Slots.Num(); ++ToolIndex)
+	{
+		AllToolSlots.Add(ToolIndex);
+	}
+	ValidateToolInstances(AllToolSlots);
+
+	// the tracker may have already found our first cell during its own BeginPlay, so catch up here
+	GridCellTrackerComponent->OnGridCellChanged.AddUObject(this, &AAECharacter::OnGridCellChanged);
+	WorldGrid->OnOccupantsChanged.AddUObject(this, &AAECharacter::OnGridOccupantsChanged);
+	OnGridCellChanged(FGridVector(), GridCellTrackerComponent->GetCurrentCell());
+}
+
+void AAECharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GridCellTrackerComponent->OnGridCellChanged.RemoveAll(this);
+	if (WorldGrid)
+	{
+		WorldGrid->OnOccupantsChanged.RemoveAll(this);
+	}
+
+	CraftingAvailability.Deinitialize();
+
+	for (int32 ToolIndex = 0; ToolIndex < ToolInstances.Num(); ++ToolIndex)
+	{
+		ReleaseToolInstance(ToolIndex);
+	}
+	ToolInstances.Reset();
+	ToolInstanceAssets.Reset();
+	PendingToolValidations.Reset();
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AAECharacter::SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent)
@@ -467,6 +721,175 @@ ATool* AAECharacter::InstanceTool(TSubclassOf<ATool> ToolClass)
 	return InstancedTool;
 }
 
+ATool* AAECharacter::GetOrCreateToolInstance(int32 ToolIndex)
+{
+	FInventorySlotData Tool;
+	if (!ToolInventory.GetAtIndex(ToolIndex, Tool))
+	{
+		return nullptr;
+	}
+
+	if (ToolInstances.Num() <= ToolIndex)
+	{
+		ToolInstances.SetNumZeroed(ToolIndex + 1);
+	}
+	if (ToolInstanceAssets.Num() <= ToolIndex)
+	{
+		ToolInstanceAssets.SetNum(ToolIndex + 1);
+	}
+	ToolInstanceAssets[ToolIndex] = Tool.AssetType;
+
+	ATool*& ToolInstance = ToolInstances[ToolIndex];
+	if (!IsValid(ToolInstance))
+	{
+		// #note: this is only a synchronous load if the preloader hasn't streamed the class in yet
+		ToolInstance = InstanceTool(*Tool.AssetType->GetActorClass());
+		if (IsValid(ToolInstance))
+		{
+			ToolInstance->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetIncludingScale, ToolSocket);
+			ToolInstance->SetActorHiddenInGame(true);
+		}
+	}
+
+	return ToolInstance;
+}
+
+void AAECharacter::WarmToolInstance(int32 ToolIndex)
+{
+	FInventorySlotData Tool;
+	if (!ToolInventory.GetAtIndex(ToolIndex, Tool))
+	{
+		return;
+	}
+
+	const UAEMetaAsset* ToolAsset = Tool.AssetType;
+	TWeakObjectPtr<AAECharacter> WeakThis(this);
+	ToolAsset->GetActorClassAsync(FOnActorClassLoaded::CreateLambda([WeakThis, ToolIndex, ToolAsset](TSubclassOf<AActor> ToolClass)
+	{
+		AAECharacter* Character = WeakThis.Get();
+		if ((Character == nullptr) || (ToolClass == nullptr) || Character->IsActorBeingDestroyed())
+		{
+			return;
+		}
+
+		// the slot may have changed while the class was loading
+		FInventorySlotData CurrentTool;
+		if (Character->ToolInventory.GetAtIndex(ToolIndex, CurrentTool) && (CurrentTool.AssetType == ToolAsset))
+		{
+			Character->GetOrCreateToolInstance(ToolIndex);
+		}
+	}));
+}
+
+void AAECharacter::ValidateToolInstances(const TArray<int32>& ChangedSlots)
+{
+	if (ToolInstanceAssets.Num() < ToolInventory.Slots.Num())
+	{
+		ToolInstanceAssets.SetNum(ToolInventory.Slots.Num());
+	}
+
+	for (int32 ToolIndex : ChangedSlots)
+	{
+		if (!ToolInstanceAssets.IsValidIndex(ToolIndex))
+		{
+			continue;
+		}
+
+		FInventorySlotData Tool;
+		const UAEMetaAsset* CurrentAsset = ToolInventory.GetAtIndex(ToolIndex, Tool) ? Tool.AssetType : nullptr;
+		if (ToolInstanceAssets[ToolIndex].Get() == CurrentAsset)
+		{
+			continue;
+		}
+
+		if (ToolIndex == EquippedToolIndex)
+		{
+			// pulling the tool out from under its action would leave the action running on a destroyed actor
+			if (IsPerformingAction())
+			{
+				PendingToolValidations.AddUnique(ToolIndex);
+				continue;
+			}
+			UnequipTool(EquippedToolIndex);
+		}
+
+		ReleaseToolInstance(ToolIndex);
+		ToolInstanceAssets[ToolIndex] = CurrentAsset;
+
+		if (CurrentAsset != nullptr)
+		{
+			WarmToolInstance(ToolIndex);
+		}
+	}
+}
+
+void AAECharacter::ReleaseToolInstance(int32 ToolIndex)
+{
+	if (ToolInstances.IsValidIndex(ToolIndex))
+	{
+		if (IsValid(ToolInstances[ToolIndex]))
+		{
+			if (ToolInstances[ToolIndex] == EquippedToolInstance)
+			{
+				EquippedToolInstance = nullptr;
+			}
+			ToolInstances[ToolIndex]->Destroy();
+		}
+		ToolInstances[ToolIndex] = nullptr;
+	}
+}
+
+void AAECharacter::RemapToolInstances(const TArray<int32>& SlotRemap)
+{
+	TArray<ATool*> RemappedInstances;
+	RemappedInstances.SetNumZeroed(ToolInstances.Num());
+
+	// the slot's tool moves with it whether or not its instance has been made yet
+	TArray<TWeakObjectPtr<const UAEMetaAsset>> RemappedAssets;
+	RemappedAssets.SetNum(ToolInstanceAssets.Num());
+	for (int32 OldIndex = 0; OldIndex < ToolInstanceAssets.Num(); ++OldIndex)
+	{
+		const int32 NewIndex = SlotRemap.IsValidIndex(OldIndex) ? SlotRemap[OldIndex] : INDEX_NONE;
+		if (RemappedAssets.IsValidIndex(NewIndex) && ToolInstanceAssets[OldIndex].IsValid())
+		{
+			RemappedAssets[NewIndex] = ToolInstanceAssets[OldIndex];
+		}
+	}
+	ToolInstanceAssets = MoveTemp(RemappedAssets);
+
+	for (int32 OldIndex = 0; OldIndex < ToolInstances.Num(); ++OldIndex)
+	{
+		ATool* ToolInstance = ToolInstances[OldIndex];
+		if (!IsValid(ToolInstance))
+		{
+			continue;
+		}
+
+		const int32 NewIndex = SlotRemap.IsValidIndex(OldIndex) ? SlotRemap[OldIndex] : INDEX_NONE;
+		if (!RemappedInstances.IsValidIndex(NewIndex))
+		{
+			ToolInstance->Destroy();
+			continue;
+		}
+
+		// two consolidated slots landed in the same one. the equipped instance wins
+		ATool*& RemappedInstance = RemappedInstances[NewIndex];
+		if (RemappedInstance != nullptr)
+		{
+			if (ToolInstance != EquippedToolInstance)
+			{
+				ToolInstance->Destroy();
+				continue;
+			}
+			RemappedInstance->Destroy();
+		}
+
+		RemappedInstance = ToolInstance;
+	}
+
+	ToolInstances = MoveTemp(RemappedInstances);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 //////////////////////////////////////////////////////////////////////////
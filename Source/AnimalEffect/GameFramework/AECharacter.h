@@ -2,9 +2,13 @@
 
 #pragma once
 
+#include "Crafting/CraftingAvailability.h"
 #include "Inventory/Inventory.h"
 #include "Inventory/InventoryAccessInterface.h"
+#include "Inventory/InventoryReplication.h"
+#include "Inventory/StorageInventory.h"
 #include "Items/Interfaces/PickupActorInterface.h"
+#include "WorldGrid/WorldGridTypes.h"
 
 #include "Gameframework/Character.h"
 
@@ -12,8 +16,10 @@
 
 class AItem;
 class ATool;
+class UCraftingRecipeAsset;
 class UBoxComponent;
 class UCameraComponent;
+class UGridCellTrackerComponent;
 class USphereComponent;
 class USpringArmComponent;
 class UInputComponent;
@@ -30,6 +36,10 @@ public:
 
 	void Tick(float DeltaTime) override;
 
+	void PostInitializeComponents() override;
+
+	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	void TickEquippedTool(float DeltaTime);
 
 	bool IsPerformingAction() const;
@@ -50,10 +60,21 @@ public:
 	FORCEINLINE FInventory& GetToolInventory() { return ToolInventory; }
 	FORCEINLINE const FInventory& GetToolInventory() const { return ToolInventory; }
 
+	FORCEINLINE FStorageInventory& GetStorageInventory() { return StorageInventory; }
+	FORCEINLINE const FStorageInventory& GetStorageInventory() const { return StorageInventory; }
+
+	// the handles of a single storage page. GetInventoryLayoutData with EInventoryType::Storage is the first page
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool GetStoragePageLayoutData(int32 PageIndex, FInventoryLayoutData& OutData) const;
+
+	// recipes craftable from the item inventory, kept up to date as the inventory changes
+	FORCEINLINE const FCraftingAvailability& GetCraftingAvailability() const { return CraftingAvailability; }
+
 	// BEGIN IInventoryAccessInterface
 	UFUNCTION()
 	bool GetInventoryLayoutData(EInventoryType InventoryType, FInventoryLayoutData& OutData) const override;
 
+	// item and tool handles only. storage slots aren't in a single FInventory, they go through GetStorageInventory
 	FInventory& GetInventoryFromHandle(const FInventorySlotHandle& Handle);
 	const FInventory& GetInventoryFromHandle(const FInventorySlotHandle& Handle) const;
 
@@ -65,26 +86,60 @@ public:
 
 	UFUNCTION()
 	void OnInventorySlotActionSelectedForHandle(const FInventorySlotHandle& Handle, EInventoryItemActions Action) override;
+
+	UFUNCTION()
+	void SortInventory(EInventoryType InventoryType, EInventorySortKey SortKey) override;
 	// END IInventoryAccessInterface
 
 	bool TryDropItemForSlotHandle(const FInventorySlotHandle& Handle);
 	bool TryPlaceItemForSlotHandle(const FInventorySlotHandle& Handle);
 	bool TryHoldItemForSlotHandle(const FInventorySlotHandle& Handle);
 
+	// broadcast with the handles of every slot changed by a single inventory operation
+	UPROPERTY(BlueprintAssignable, Category = "Inventory")
+	FOnInventorySlotHandlesChanged OnInventorySlotHandlesChanged;
+
 protected:
 
 	void BeginPlay() override;
+	void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
 	ATool* InstanceTool(TSubclassOf<ATool> ToolClass);
 
+	// returns the cached instance for the tool in ToolIndex, spawning it hidden if there isn't one yet
+	ATool* GetOrCreateToolInstance(int32 ToolIndex);
+
 	void ScanForInteractables();
 
 private:
 
 	void OnToolFinishAction();
 
+	void OnInventorySlotsChanged(const FInventory& Inventory, const TArray<int32>& ChangedSlots);
+	void OnStorageSlotsChanged(const TArray<int32>& ChangedSlots);
+
+	void OnGridCellChanged(const FGridVector& PreviousCell, const FGridVector& NewCell);
+	void OnGridOccupantsChanged(const FGridVector& StartPosition, const FGridVector& EndPosition, AActor* NewOccupant);
+
+	void PreloadAroundCell(const FGridVector& Cell);
+
+	// spawns the hidden instance for the slot once its class has streamed in, so equipping it later doesn't have to
+	void WarmToolInstance(int32 ToolIndex);
+
+	// drops cached instances whose slot emptied or now holds a different tool, and warms the new one.
+	// the equipped instance isn't touched mid-action, it's revisited once the action finishes
+	void ValidateToolInstances(const TArray<int32>& ChangedSlots);
+	void ReleaseToolInstance(int32 ToolIndex);
+	void RemapToolInstances(const TArray<int32>& SlotRemap);
+
+	UFUNCTION()
+	void OnRep_ReplicatedItemInventory();
+
+	UFUNCTION()
+	void OnRep_ReplicatedToolInventory();
+
 	void SwitchToToolInDirection(bool bDirection);
 
 private:
@@ -114,6 +169,9 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Interaction", meta = (AllowPrivateAccess=true))
 	UBoxComponent* InteractableCollisionComponent;
 
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Interaction", meta = (AllowPrivateAccess=true))
+	UGridCellTrackerComponent* GridCellTrackerComponent;
+
 private:
 
 	UPROPERTY(EditDefaultsOnly, Category = "Inventory")
@@ -122,6 +180,22 @@ private:
 	UPROPERTY(EditDefaultsOnly, Category = "Inventory")
 	FInventory ToolInventory;
 
+	// home storage. server side only for now, it isn't replicated
+	UPROPERTY(EditDefaultsOnly, Category = "Inventory")
+	FStorageInventory StorageInventory;
+
+	// only changed slots are sent, and only to the owning client
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_ReplicatedItemInventory)
+	FInventoryReplicationArray ReplicatedItemInventory;
+
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_ReplicatedToolInventory)
+	FInventoryReplicationArray ReplicatedToolInventory;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Crafting")
+	TArray<UCraftingRecipeAsset*> KnownRecipes;
+
+	FCraftingAvailability CraftingAvailability;
+
 	UPROPERTY(EditDefaultsOnly, Category = "Tool")
 	FName ToolSocket = TEXT("tool_r");
 
@@ -134,9 +208,30 @@ private:
 	UPROPERTY(Transient)
 	ATool* EquippedToolInstance;
 
+	// one hidden instance per occupied tool slot so equipping is just show and attach
+	UPROPERTY(Transient)
+	TArray<ATool*> ToolInstances;
+
+	// the tool each slot's instance was made (or is being warmed) for, so count only changes skip the slot
+	TArray<TWeakObjectPtr<const UAEMetaAsset>> ToolInstanceAssets;
+
+	// slots whose instance changed while it was performing an action
+	TArray<int32> PendingToolValidations;
+
+	// set while the tool inventory is sorted so the moved slots don't drop their instances
+	bool bRemappingToolInstances = false;
+
 	UPROPERTY(Transient)
 	bool bToolIsPerformingAction;
 
+	// grid cells around the character whose pickups get their actor classes streamed in ahead of time
+	UPROPERTY(EditDefaultsOnly, Category = "Preload", meta = (ClampMin = 0))
+	int32 PreloadRadius = 8;
+
+	// grid cells around the character whose buried items get streamed in so digging never waits on a load
+	UPROPERTY(EditDefaultsOnly, Category = "Preload", meta = (ClampMin = 0))
+	int32 DigPreloadRadius = 3;
+
 	UPROPERTY(Transient)
 	UWorldGridSubsystem* WorldGrid;
 
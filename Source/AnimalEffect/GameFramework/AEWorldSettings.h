@@ -2,6 +2,7 @@
 
 #pragma
 
+#include "Environment/DailyResetSubsystem.h"
 #include "WorldGrid/WorldGridSubsystem.h"
 
 #include "GameFramework/WorldSettings.h"
@@ -19,9 +20,14 @@ public:
 
 	void GetWorldGridConfig(FWorldGridConfig& OutConfig) override;
 
+	FORCEINLINE const FDailyResetConfig& GetDailyResetConfig() const { return DailyReset; }
+
 private:
 	
 	UPROPERTY(EditAnywhere, Category = "World Grid")
 	FWorldGridConfig WorldGrid;
 
+	UPROPERTY(EditAnywhere, Category = "Daily Reset")
+	FDailyResetConfig DailyReset;
+
 };
\ No newline at end of file
@@ -12,12 +12,22 @@ void FInventory::InitializeInventory(AActor* Owner, EInventoryType InventoryType
 	check(Owner);
 
 	Name = UEnum::GetValueAsString(InventoryType);
+	Type = InventoryType;
 	bOneSlotPerAssetType = bInOneSlotPerAssetType;
+
+	InitializeSlots();
+
+	UE_LOG(LogInventory, Log, TEXT("Initialized '%s' Inventory with size %d for '%s'."), *Name, Slots.Num(), *Owner->GetName());
+}
+
+void FInventory::InitializeSlots()
+{
 	Size = RowCount * ColCount;
 
 	Slots.SetNum(Size);
 
-	UE_LOG(LogInventory, Log, TEXT("Initialized '%s' Inventory with size %d for '%s'."), *Name, Slots.Num(), *Owner->GetName());
+	DirtySlots.Init(false, Size);
+	DirtySlotIndices.Reset();
 }
 
 namespace
@@ -25,12 +35,15 @@ namespace
 	int32 TryAddToEmptySlot(const UAEMetaAsset* AssetType, int32 Count, uint8 Quality, uint8 StackMax, FInventory& Inventory)
 	{
 		uint8 CountRemaining = Count;
-		for (FInventorySlotData& CurrentSlot : Inventory.Slots)
+		for (int32 SlotIndex = 0; SlotIndex < Inventory.Slots.Num(); ++SlotIndex)
 		{
+			FInventorySlotData& CurrentSlot = Inventory.Slots[SlotIndex];
 			if (CurrentSlot.AssetType == nullptr)
 			{
 				check(CurrentSlot.StackSize == 0); // we should never have a null item with a value
 
+				Inventory.MarkSlotDirty(SlotIndex);
+
 				CurrentSlot.AssetType = AssetType;
 				CurrentSlot.Quality = Quality;
 
@@ -85,8 +98,10 @@ int32 FInventory::TryAdd(const UAEMetaAsset* AssetType, int32 Count, uint8 Quali
 
 	int32 CountRemaining = Count;
 	// add to existing
-	for (FInventorySlotData& CurrentSlot : Slots)
+	for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); ++SlotIndex)
 	{
+		FInventorySlotData& CurrentSlot = Slots[SlotIndex];
+
 		// must be an exact match
 		if ((CurrentSlot.AssetType == AssetType) && (CurrentSlot.Quality == Quality))
 		{
@@ -98,6 +113,7 @@ int32 FInventory::TryAdd(const UAEMetaAsset* AssetType, int32 Count, uint8 Quali
 				const uint8 AmountAdded = static_cast<uint8>(FMath::Min(CountRemaining, SpaceAvailable));
 				CurrentSlot.StackSize += AmountAdded;
 				CountRemaining -= AmountAdded;
+				MarkSlotDirty(SlotIndex);
 
 				check(CountRemaining >= 0);
 
@@ -111,6 +127,7 @@ int32 FInventory::TryAdd(const UAEMetaAsset* AssetType, int32 Count, uint8 Quali
 
 	if (bOneSlotPerAssetType && bAttemptedAddToExistingStack)
 	{
+		BroadcastSlotChanges();
 		return CountRemaining;
 	}
 
@@ -118,12 +135,11 @@ int32 FInventory::TryAdd(const UAEMetaAsset* AssetType, int32 Count, uint8 Quali
 	// if we're either not limited to one slot per asset type or none have been added yet, then add to an empty slot
 	if ((CountRemaining > 0) && (!bOneSlotPerAssetType || bNoneAdded))
 	{
-		return TryAddToEmptySlot(AssetType, CountRemaining, Quality, StackMax, *this);
-	}
-	else
-	{
-		return CountRemaining;
+		CountRemaining = TryAddToEmptySlot(AssetType, CountRemaining, Quality, StackMax, *this);
 	}
+
+	BroadcastSlotChanges();
+	return CountRemaining;
 }
 
 bool FInventory::TryRemoveAtIndex(int32 Index, FInventorySlotData& RemovedItem)
@@ -131,6 +147,8 @@ bool FInventory::TryRemoveAtIndex(int32 Index, FInventorySlotData& RemovedItem)
 	if (GetAtIndex(Index, RemovedItem))
 	{
 		Slots[Index] = FInventorySlotData();
+		MarkSlotDirty(Index);
+		BroadcastSlotChanges();
 		return true;
 	}
 	else
@@ -150,6 +168,8 @@ bool FInventory::TryRemoveSingleAtIndex(int32 Index, FInventorySlotData& Removed
 		{
 			Slots[Index] = FInventorySlotData();
 		}
+		MarkSlotDirty(Index);
+		BroadcastSlotChanges();
 		return true;
 	}
 	else
@@ -185,3 +205,295 @@ int32 FInventory::GetAssetCount(const UAEMetaAsset* Asset) const
 
 	return Count;
 }
+
+namespace
+{
+	// one entry per distinct asset and quality, in order of first appearance
+	struct FSortGroup
+	{
+		const UAEMetaAsset* AssetType;
+		uint8 Quality;
+		uint8 StackMax;
+		int32 TotalCount;
+		int32 FirstSourceIndex; // into SortSources
+		int32 NumSources;
+	};
+
+	// assigns each distinct value an ordinal by lexical order. only the distinct values are compared, never the slots
+	void RankNames(const TArray<FName>& Names, TMap<FName, uint32>& OutRanks)
+	{
+		TArray<FName> SortedNames = Names;
+		SortedNames.Sort([](const FName& A, const FName& B) { return A.Compare(B) < 0; });
+
+		OutRanks.Reset();
+		for (const FName& Name : SortedNames)
+		{
+			OutRanks.Add(Name, OutRanks.Num());
+		}
+	}
+
+	// stable LSD radix sort of Order by Keys, a byte per pass. passes where every key has the same byte are skipped
+	void RadixSortByKey(const TArray<uint64>& Keys, TArray<int32>& Order)
+	{
+		const int32 Num = Keys.Num();
+
+		int32 Histograms[8][256];
+		FMemory::Memzero(Histograms);
+		for (uint64 Key : Keys)
+		{
+			for (int32 Pass = 0; Pass < 8; ++Pass)
+			{
+				++Histograms[Pass][(Key >> (Pass * 8)) & 0xFF];
+			}
+		}
+
+		TArray<int32> Scratch;
+		Scratch.SetNumUninitialized(Num);
+
+		for (int32 Pass = 0; Pass < 8; ++Pass)
+		{
+			int32* Histogram = Histograms[Pass];
+			if (Histogram[(Keys[Order[0]] >> (Pass * 8)) & 0xFF] == Num)
+			{
+				continue;
+			}
+
+			int32 Offset = 0;
+			for (int32 Bucket = 0; Bucket < 256; ++Bucket)
+			{
+				const int32 Count = Histogram[Bucket];
+				Histogram[Bucket] = Offset;
+				Offset += Count;
+			}
+
+			for (int32 Entry : Order)
+			{
+				Scratch[Histogram[(Keys[Entry] >> (Pass * 8)) & 0xFF]++] = Entry;
+			}
+
+			Swap(Order, Scratch);
+		}
+	}
+}
+
+void FInventory::SortAndConsolidate(EInventorySortKey SortKey, TArray<int32>& OutSlotRemap)
+{
+	OutSlotRemap.Init(INDEX_NONE, Slots.Num());
+
+	// gather: one linear pass over the slots building a group per asset and quality
+	TArray<FSortGroup> Groups;
+	TMap<TPair<const UAEMetaAsset*, uint8>, int32> GroupIndexForKey;
+	TArray<int32> SlotGroups;
+	SlotGroups.Init(INDEX_NONE, Slots.Num());
+
+	for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); ++SlotIndex)
+	{
+		const FInventorySlotData& CurrentSlot = Slots[SlotIndex];
+		if (!CurrentSlot.IsValid())
+		{
+			continue;
+		}
+
+		const TPair<const UAEMetaAsset*, uint8> GroupKey(CurrentSlot.AssetType, CurrentSlot.Quality);
+		int32 GroupIndex;
+		if (const int32* ExistingGroupIndex = GroupIndexForKey.Find(GroupKey))
+		{
+			GroupIndex = *ExistingGroupIndex;
+		}
+		else
+		{
+			GroupIndex = Groups.Num();
+			GroupIndexForKey.Add(GroupKey, GroupIndex);
+
+			const IInventoryItemInterface* ItemInterface = Cast<IInventoryItemInterface>(CurrentSlot.AssetType);
+			Groups.Add({ CurrentSlot.AssetType, CurrentSlot.Quality, ItemInterface ? ItemInterface->GetInventoryStackMax() : CurrentSlot.StackSize, 0, 0, 0 });
+		}
+
+		FSortGroup& Group = Groups[GroupIndex];
+		Group.TotalCount += CurrentSlot.StackSize;
+		Group.NumSources++;
+		SlotGroups[SlotIndex] = GroupIndex;
+	}
+
+	if (Groups.Num() == 0)
+	{
+		return;
+	}
+
+	// lay the source slots of each group out contiguously, still in slot order
+	TArray<int32> SortSources;
+	SortSources.SetNumUninitialized(SlotGroups.Num());
+	{
+		int32 Offset = 0;
+		for (FSortGroup& Group : Groups)
+		{
+			Group.FirstSourceIndex = Offset;
+			Offset += Group.NumSources;
+			Group.NumSources = 0;
+		}
+		for (int32 SlotIndex = 0; SlotIndex < SlotGroups.Num(); ++SlotIndex)
+		{
+			if (SlotGroups[SlotIndex] != INDEX_NONE)
+			{
+				FSortGroup& Group = Groups[SlotGroups[SlotIndex]];
+				SortSources[Group.FirstSourceIndex + Group.NumSources++] = SlotIndex;
+			}
+		}
+	}
+
+	// rank the distinct assets and categories so every key component is a small integer
+	TMap<FName, uint32> AssetRanks;
+	TMap<FName, uint32> CategoryRanks;
+	{
+		TArray<FName> AssetNames;
+		TArray<FName> CategoryNames;
+		for (const FSortGroup& Group : Groups)
+		{
+			AssetNames.AddUnique(Group.AssetType->GetFName());
+			const IInventoryItemInterface* ItemInterface = Cast<IInventoryItemInterface>(Group.AssetType);
+			CategoryNames.AddUnique(ItemInterface ? ItemInterface->GetInventoryCategory() : NAME_None);
+		}
+		RankNames(AssetNames, AssetRanks);
+		RankNames(CategoryNames, CategoryRanks);
+	}
+
+	// within the primary key, stacks are always grouped by asset with the highest quality first
+	TArray<uint64> Keys;
+	Keys.Reserve(Groups.Num());
+	for (const FSortGroup& Group : Groups)
+	{
+		const uint64 AssetRank = AssetRanks.FindChecked(Group.AssetType->GetFName()) & 0xFFFF;
+		const uint64 InverseQuality = MAX_uint8 - Group.Quality;
+		const uint64 AssetThenQuality = (AssetRank << 8) | InverseQuality;
+
+		uint64 Primary = 0;
+		switch (SortKey)
+		{
+		case EInventorySortKey::Category:
+		{
+			const IInventoryItemInterface* ItemInterface = Cast<IInventoryItemInterface>(Group.AssetType);
+			Primary = CategoryRanks.FindChecked(ItemInterface ? ItemInterface->GetInventoryCategory() : NAME_None) & 0xFFFF;
+			break;
+		}
+		case EInventorySortKey::Quality:
+			Primary = InverseQuality;
+			break;
+		case EInventorySortKey::StackSize:
+			Primary = 0xFFFFFF - FMath::Min(Group.TotalCount, 0xFFFFFF);
+			break;
+		case EInventorySortKey::Asset:
+		default:
+			break;
+		}
+
+		Keys.Add((Primary << 24) | AssetThenQuality);
+	}
+
+	TArray<int32> GroupOrder;
+	GroupOrder.SetNumUninitialized(Groups.Num());
+	for (int32 GroupIndex = 0; GroupIndex < Groups.Num(); ++GroupIndex)
+	{
+		GroupOrder[GroupIndex] = GroupIndex;
+	}
+	RadixSortByKey(Keys, GroupOrder);
+
+	// a stack already over its max (a default slot, or the max was lowered since) can make consolidating need more slots than we have.
+	// leave the inventory as it is rather than lose items
+	{
+		int32 SlotsNeeded = 0;
+		for (const FSortGroup& Group : Groups)
+		{
+			const int32 StackMax = FMath::Max<int32>(Group.StackMax, 1);
+			SlotsNeeded += (Group.TotalCount + StackMax - 1) / StackMax;
+		}
+
+		if (SlotsNeeded > Slots.Num())
+		{
+			UE_LOG(LogInventory, Warning, TEXT("Can't sort inventory, consolidating needs %d slots but there are only %d. some stacks are over their max"), SlotsNeeded, Slots.Num());
+			for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); ++SlotIndex)
+			{
+				OutSlotRemap[SlotIndex] = Slots[SlotIndex].IsValid() ? SlotIndex : INDEX_NONE;
+			}
+			return;
+		}
+	}
+
+	// scatter: write full stacks from the first slot on, remapping every source slot to the stack its first item landed in
+	TArray<FInventorySlotData> SortedSlots;
+	SortedSlots.SetNum(Slots.Num());
+
+	int32 NextSlotIndex = 0;
+	for (int32 GroupIndex : GroupOrder)
+	{
+		const FSortGroup& Group = Groups[GroupIndex];
+		const int32 StackMax = FMath::Max<int32>(Group.StackMax, 1);
+		const int32 GroupFirstSlotIndex = NextSlotIndex;
+
+		int32 CountRemaining = Group.TotalCount;
+		while (CountRemaining > 0)
+		{
+			FInventorySlotData& SortedSlot = SortedSlots[NextSlotIndex++];
+			SortedSlot.AssetType = Group.AssetType;
+			SortedSlot.Quality = Group.Quality;
+			SortedSlot.StackSize = static_cast<uint8>(FMath::Min(CountRemaining, StackMax));
+			CountRemaining -= SortedSlot.StackSize;
+		}
+
+		int32 CountBefore = 0;
+		for (int32 SourceIndex = Group.FirstSourceIndex; SourceIndex < Group.FirstSourceIndex + Group.NumSources; ++SourceIndex)
+		{
+			const int32 OldSlotIndex = SortSources[SourceIndex];
+			OutSlotRemap[OldSlotIndex] = GroupFirstSlotIndex + (CountBefore / StackMax);
+			CountBefore += Slots[OldSlotIndex].StackSize;
+		}
+	}
+
+	for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); ++SlotIndex)
+	{
+		FInventorySlotData& CurrentSlot = Slots[SlotIndex];
+		const FInventorySlotData& SortedSlot = SortedSlots[SlotIndex];
+		if ((CurrentSlot.AssetType != SortedSlot.AssetType) || (CurrentSlot.StackSize != SortedSlot.StackSize) || (CurrentSlot.Quality != SortedSlot.Quality))
+		{
+			CurrentSlot = SortedSlot;
+			MarkSlotDirty(SlotIndex);
+		}
+	}
+
+	BroadcastSlotChanges();
+}
+
+void FInventory::MarkSlotDirty(int32 Index)
+{
+	check(Slots.IsValidIndex(Index));
+
+	if (DirtySlots.Num() != Slots.Num())
+	{
+		// Slots can be resized without going through InitializeInventory (e.g. defaults edited on the CDO)
+		DirtySlots.Init(false, Slots.Num());
+		DirtySlotIndices.Reset();
+	}
+
+	if (!DirtySlots[Index])
+	{
+		DirtySlots[Index] = true;
+		DirtySlotIndices.Add(Index);
+	}
+}
+
+void FInventory::BroadcastSlotChanges()
+{
+	if (DirtySlotIndices.Num() == 0)
+	{
+		return;
+	}
+
+	// clear before broadcasting so listeners are free to modify the inventory again
+	TArray<int32> ChangedSlots = MoveTemp(DirtySlotIndices);
+	DirtySlotIndices.Reset();
+	for (int32 Index : ChangedSlots)
+	{
+		DirtySlots[Index] = false;
+	}
+
+	OnSlotsChanged.Broadcast(*this, ChangedSlots);
+}
@@ -12,9 +12,24 @@ UENUM(BlueprintType)
 enum class EInventoryType : uint8
 {
 	Item,
-	Tool
+	Tool,
+	Storage
 };
 
+UENUM(BlueprintType)
+enum class EInventorySortKey : uint8
+{
+	Asset,
+	Category,
+	Quality,
+	StackSize
+};
+
+struct FInventory;
+
+// carries every slot index touched by a single inventory operation
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnInventorySlotsChanged, const FInventory& /*Inventory*/, const TArray<int32>& /*ChangedSlots*/);
+
 USTRUCT(BlueprintType)
 struct ANIMALEFFECT_API FInventorySlotData
 {
@@ -58,8 +73,17 @@ struct ANIMALEFFECT_API FInventory
 	UPROPERTY(BlueprintReadOnly)
 	int32 Size;
 
+	UPROPERTY(BlueprintReadOnly)
+	EInventoryType Type = EInventoryType::Item;
+
+	// broadcast once at the end of every operation that changed at least one slot
+	FOnInventorySlotsChanged OnSlotsChanged;
+
 	void InitializeInventory(AActor* Owner, EInventoryType InventoryType, bool bInOneSlotPerClass = false);
 
+	// sizes the slots to RowCount * ColCount without logging, for inventories set up often enough to spam, like storage pages
+	void InitializeSlots();
+
 	// returns a remainder of items not added
 	int32 TryAdd(const UAEMetaAsset* AssetType, int32 Count = 1, uint8 Quality = 1);
 
@@ -72,4 +96,25 @@ struct ANIMALEFFECT_API FInventory
 	bool GetAtIndex(int32 Index, FInventorySlotData& Item) const;
 
 	int32 GetAssetCount(const UAEMetaAsset* AssetType) const;
+
+	// merges partial stacks of the same asset and quality, then orders the stacks by SortKey from the first slot on.
+	// OutSlotRemap[OldIndex] is the slot that now holds the first item of the old slot, or INDEX_NONE if the old slot was empty.
+	// all changed slots are broadcast as a single change
+	void SortAndConsolidate(EInventorySortKey SortKey, TArray<int32>& OutSlotRemap);
+
+	FORCEINLINE bool IsSlotDirty(int32 Index) const { return DirtySlots.IsValidIndex(Index) && DirtySlots[Index]; }
+
+	// anything writing to Slots directly must mark the slot and then call BroadcastSlotChanges
+	void MarkSlotDirty(int32 Index);
+
+	// broadcasts OnSlotsChanged with the dirty slots and clears them. does nothing if no slot is dirty
+	void BroadcastSlotChanges();
+
+private:
+
+	// a bit per slot so a slot is only ever reported once per broadcast
+	TBitArray<> DirtySlots;
+
+	// the dirty slots in the order they were marked, so broadcasting doesn't have to walk every slot
+	TArray<int32> DirtySlotIndices;
 };
@@ -36,6 +36,9 @@ struct ANIMALEFFECT_API FInventoryLayoutData
 	TArray<FInventorySlotHandle> SlotHandles;
 };
 
+// lets widgets refresh only the slots that changed instead of re-querying the whole layout
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInventorySlotHandlesChanged, const TArray<FInventorySlotHandle>&, ChangedSlotHandles);
+
 UINTERFACE(meta=(CannotImplementInterfaceInBlueprint))
 class ANIMALEFFECT_API UInventoryAccessInterface : public UInterface
 {
@@ -58,4 +61,7 @@ class ANIMALEFFECT_API IInventoryAccessInterface : public IInterface
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	virtual void OnInventorySlotActionSelectedForHandle(const FInventorySlotHandle& Handle, EInventoryItemActions Action) PURE_VIRTUAL(IInventoryAccessInterface::OnInventorySlotMenuOptionSelectedForHandle, );
 
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	virtual void SortInventory(EInventoryType InventoryType, EInventorySortKey SortKey) PURE_VIRTUAL(IInventoryAccessInterface::SortInventory, );
+
 };
\ No newline at end of file
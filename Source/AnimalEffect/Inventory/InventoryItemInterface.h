@@ -34,6 +34,9 @@ public:
 
 	virtual uint8 GetItemQuality() const { return 1; }
 
+	// used to group and filter items in large inventories
+	virtual FName GetInventoryCategory() const { return NAME_None; }
+
 	// this returns a reference so we know this array exists on the class
 	// #todo: this should end up context aware
 	virtual bool GetAvailableItemActions(TArray<EInventoryItemActions>& AvailableActions) const { return false; }
@@ -0,0 +1,108 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InventoryReplication.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogInventoryReplication, Log, All);
+
+uint32 FInventoryReplicatedSlot::PackSlot(int32 SlotIndex, const FInventorySlotData& SlotData)
+{
+	check(SlotIndex >= 0 && SlotIndex <= MAX_uint16);
+
+	return (static_cast<uint32>(SlotIndex) << 16) | (static_cast<uint32>(SlotData.StackSize) << 8) | static_cast<uint32>(SlotData.Quality);
+}
+
+FInventorySlotData FInventoryReplicatedSlot::ToSlotData() const
+{
+	FInventorySlotData SlotData;
+	SlotData.AssetType = AssetType;
+	SlotData.StackSize = GetStackSize();
+	SlotData.Quality = GetQuality();
+	return SlotData;
+}
+
+void FInventoryReplicatedSlot::PreReplicatedRemove(const FInventoryReplicationArray& InArraySerializer)
+{
+	InArraySerializer.ClientApplySlot(GetSlotIndex(), FInventorySlotData());
+}
+
+void FInventoryReplicatedSlot::PostReplicatedAdd(const FInventoryReplicationArray& InArraySerializer)
+{
+	InArraySerializer.ClientApplySlot(GetSlotIndex(), ToSlotData());
+}
+
+void FInventoryReplicatedSlot::PostReplicatedChange(const FInventoryReplicationArray& InArraySerializer)
+{
+	InArraySerializer.ClientApplySlot(GetSlotIndex(), ToSlotData());
+}
+
+void FInventoryReplicationArray::ServerSyncSlots(const FInventory& Inventory, const TArray<int32>& ChangedSlots)
+{
+	for (int32 SlotIndex : ChangedSlots)
+	{
+		const FInventorySlotData& SlotData = Inventory.Slots[SlotIndex];
+		const int32* ExistingItemIndex = ItemIndexForSlot.Find(SlotIndex);
+
+		if (SlotData.IsValid())
+		{
+			const int32 ItemIndex = ExistingItemIndex ? *ExistingItemIndex : Items.AddDefaulted();
+			ItemIndexForSlot.Add(SlotIndex, ItemIndex);
+
+			FInventoryReplicatedSlot& Item = Items[ItemIndex];
+			Item.AssetType = SlotData.AssetType;
+			Item.PackedSlot = FInventoryReplicatedSlot::PackSlot(SlotIndex, SlotData);
+			MarkItemDirty(Item);
+		}
+		else if (ExistingItemIndex)
+		{
+			const int32 RemovedItemIndex = *ExistingItemIndex;
+			ItemIndexForSlot.Remove(SlotIndex);
+
+			Items.RemoveAtSwap(RemovedItemIndex);
+			if (Items.IsValidIndex(RemovedItemIndex))
+			{
+				// the last item was swapped into the removed item's place
+				ItemIndexForSlot.Add(Items[RemovedItemIndex].GetSlotIndex(), RemovedItemIndex);
+			}
+
+			MarkArrayDirty();
+		}
+	}
+}
+
+void FInventoryReplicationArray::ServerSyncAllSlots(const FInventory& Inventory)
+{
+	TArray<int32> AllSlots;
+	AllSlots.Reserve(Inventory.Slots.Num());
+	for (int32 SlotIndex = 0; SlotIndex < Inventory.Slots.Num(); ++SlotIndex)
+	{
+		AllSlots.Add(SlotIndex);
+	}
+
+	ServerSyncSlots(Inventory, AllSlots);
+}
+
+void FInventoryReplicationArray::ClientBroadcastChanges()
+{
+	if (ClientInventory)
+	{
+		ClientInventory->BroadcastSlotChanges();
+	}
+}
+
+void FInventoryReplicationArray::ClientApplySlot(int32 SlotIndex, const FInventorySlotData& SlotData) const
+{
+	if (ClientInventory == nullptr)
+	{
+		UE_LOG(LogInventoryReplication, Error, TEXT("Received inventory slot %d without a client inventory to write it to"), SlotIndex);
+		return;
+	}
+
+	// initial replication can arrive before the owner initializes its inventory. InitializeInventory keeps what we write here
+	if (!ClientInventory->Slots.IsValidIndex(SlotIndex))
+	{
+		ClientInventory->Slots.SetNum(SlotIndex + 1);
+	}
+
+	ClientInventory->Slots[SlotIndex] = SlotData;
+	ClientInventory->MarkSlotDirty(SlotIndex);
+}
@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Inventory.h"
+
+#include "Engine/NetSerialization.h"
+
+#include "InventoryReplication.generated.h"
+
+struct FInventoryReplicationArray;
+
+// a single occupied inventory slot. empty slots are never replicated, they're removed from the array instead
+USTRUCT()
+struct ANIMALEFFECT_API FInventoryReplicatedSlot : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	const UAEMetaAsset* AssetType = nullptr;
+
+	// slot index in the upper 16 bits, then stack size and quality in a byte each
+	UPROPERTY()
+	uint32 PackedSlot = 0;
+
+	static uint32 PackSlot(int32 SlotIndex, const FInventorySlotData& SlotData);
+
+	FORCEINLINE int32 GetSlotIndex() const { return static_cast<int32>(PackedSlot >> 16); }
+	FORCEINLINE uint8 GetStackSize() const { return static_cast<uint8>((PackedSlot >> 8) & 0xFF); }
+	FORCEINLINE uint8 GetQuality() const { return static_cast<uint8>(PackedSlot & 0xFF); }
+
+	FInventorySlotData ToSlotData() const;
+
+	// BEGIN FFastArraySerializerItem
+	void PreReplicatedRemove(const FInventoryReplicationArray& InArraySerializer);
+	void PostReplicatedAdd(const FInventoryReplicationArray& InArraySerializer);
+	void PostReplicatedChange(const FInventoryReplicationArray& InArraySerializer);
+	// END FFastArraySerializerItem
+};
+
+/**
+ * Delta replicated mirror of an FInventory.
+ * The server feeds it the slots reported by FInventory::OnSlotsChanged so only the changed slots are sent.
+ * On the client every add, change and removal is written back into the client's FInventory, which then
+ * broadcasts its own OnSlotsChanged once the owner calls ClientBroadcastChanges (from its OnRep).
+ */
+USTRUCT()
+struct ANIMALEFFECT_API FInventoryReplicationArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	// server only
+	void ServerSyncSlots(const FInventory& Inventory, const TArray<int32>& ChangedSlots);
+
+	// server only. every slot, for whatever the inventory already held before it started reporting changes
+	void ServerSyncAllSlots(const FInventory& Inventory);
+
+	// the inventory replicated slots are written into. this is not owned by the array
+	FORCEINLINE void SetClientInventory(FInventory* InClientInventory) { ClientInventory = InClientInventory; }
+
+	void ClientBroadcastChanges();
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FInventoryReplicatedSlot, FInventoryReplicationArray>(Items, DeltaParms, *this);
+	}
+
+private:
+
+	friend struct FInventoryReplicatedSlot;
+
+	void ClientApplySlot(int32 SlotIndex, const FInventorySlotData& SlotData) const;
+
+	UPROPERTY()
+	TArray<FInventoryReplicatedSlot> Items;
+
+	// server only. slot index to index in Items
+	TMap<int32, int32> ItemIndexForSlot;
+
+	FInventory* ClientInventory = nullptr;
+
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryReplicationArray> : public TStructOpsTypeTraitsBase2<FInventoryReplicationArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
@@ -0,0 +1,446 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "StorageInventory.h"
+
+#include "InventoryItemInterface.h"
+#include "Data/AEDataAsset.h"
+
+#include "Algo/BinarySearch.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogStorageInventory, Log, All);
+
+namespace
+{
+	FName GetCategoryForAsset(const UAEMetaAsset* AssetType)
+	{
+		const IInventoryItemInterface* ItemInterface = Cast<IInventoryItemInterface>(AssetType);
+		return ItemInterface ? ItemInterface->GetInventoryCategory() : NAME_None;
+	}
+
+	template<typename KeyType>
+	void AddToBucket(TMap<KeyType, TArray<int32>>& Index, KeyType Key, int32 SlotIndex)
+	{
+		TArray<int32>& Bucket = Index.FindOrAdd(Key);
+		Bucket.Insert(SlotIndex, Algo::LowerBound(Bucket, SlotIndex));
+	}
+
+	template<typename KeyType>
+	void RemoveFromBucket(TMap<KeyType, TArray<int32>>& Index, KeyType Key, int32 SlotIndex)
+	{
+		if (TArray<int32>* Bucket = Index.Find(Key))
+		{
+			const int32 BucketIndex = Algo::BinarySearch(*Bucket, SlotIndex);
+			if (BucketIndex != INDEX_NONE)
+			{
+				Bucket->RemoveAt(BucketIndex, 1, false);
+			}
+
+			if (Bucket->Num() == 0)
+			{
+				Index.Remove(Key);
+			}
+		}
+	}
+}
+
+void FStorageInventory::InitializeStorage(AActor* InOwner)
+{
+	check(InOwner);
+
+	Owner = InOwner;
+
+	// slots are allocated per page on first use, see AllocatePage
+	Pages.Reset();
+	Pages.SetNum(PageCount);
+	for (FInventory& Page : Pages)
+	{
+		Page.RowCount = PageRowCount;
+		Page.ColCount = PageColCount;
+		Page.Type = EInventoryType::Storage;
+		Page.Name = UEnum::GetValueAsString(EInventoryType::Storage);
+	}
+
+	PageOccupiedCounts.Init(0, PageCount);
+	OccupiedSlotCount = 0;
+
+	AssetIndex.Reset();
+	CategoryIndex.Reset();
+	QualityIndex.Reset();
+	AssetCounts.Reset();
+
+	ChangedSlots.Reset();
+	ChangedPages.Reset();
+
+	UE_LOG(LogStorageInventory, Log, TEXT("Initialized storage with %d pages of %d slots for '%s'."), PageCount, GetPageSize(), *Owner->GetName());
+}
+
+int32 FStorageInventory::TryAdd(const UAEMetaAsset* AssetType, int32 Count, uint8 Quality)
+{
+	if (AssetType == nullptr)
+	{
+		UE_LOG(LogStorageInventory, Error, TEXT("Can't add null asset to storage"));
+		return Count;
+	}
+
+	const IInventoryItemInterface* ItemInterface = Cast<IInventoryItemInterface>(AssetType);
+	if (ItemInterface == nullptr)
+	{
+		UE_LOG(LogStorageInventory, Error, TEXT("Can't add '%s' to storage"), *AssetType->GetName());
+		return Count;
+	}
+
+	if ((Quality <= 0) || (Count <= 0))
+	{
+		UE_LOG(LogStorageInventory, Warning, TEXT("Can't add '%s' of count '%d' and quality '%d' to storage"), *AssetType->GetName(), Count, Quality);
+		return Count;
+	}
+
+	const int32 StackMax = ItemInterface->GetInventoryStackMax();
+
+	int32 CountRemaining = Count;
+
+	// top up existing stacks in slot order like FInventory does. only slots holding this asset are visited.
+	// topping up a slot takes it out of the bucket and puts it straight back in the same place, so BucketIndex stays valid
+	for (int32 BucketIndex = 0; CountRemaining > 0; ++BucketIndex)
+	{
+		const TArray<int32>* AssetSlots = AssetIndex.Find(AssetType);
+		if ((AssetSlots == nullptr) || !AssetSlots->IsValidIndex(BucketIndex))
+		{
+			break;
+		}
+
+		const int32 SlotIndex = (*AssetSlots)[BucketIndex];
+
+		FInventorySlotData SlotData;
+		GetAtIndex(SlotIndex, SlotData);
+
+		const int32 SpaceAvailable = StackMax - SlotData.StackSize;
+		if ((SlotData.Quality == Quality) && (SpaceAvailable > 0))
+		{
+			const int32 AmountAdded = FMath::Min(CountRemaining, SpaceAvailable);
+			SlotData.StackSize += static_cast<uint8>(AmountAdded);
+			CountRemaining -= AmountAdded;
+			SetSlot(SlotIndex, SlotData);
+		}
+	}
+
+	while (CountRemaining > 0)
+	{
+		const int32 SlotIndex = FindEmptySlot();
+		if (SlotIndex == INDEX_NONE)
+		{
+			break;
+		}
+
+		FInventorySlotData SlotData;
+		SlotData.AssetType = AssetType;
+		SlotData.Quality = Quality;
+		SlotData.StackSize = static_cast<uint8>(FMath::Min(CountRemaining, StackMax));
+		CountRemaining -= SlotData.StackSize;
+		SetSlot(SlotIndex, SlotData);
+	}
+
+	BroadcastSlotChanges();
+	return CountRemaining;
+}
+
+bool FStorageInventory::TryRemoveAtIndex(int32 SlotIndex, FInventorySlotData& RemovedItem)
+{
+	if (GetAtIndex(SlotIndex, RemovedItem))
+	{
+		SetSlot(SlotIndex, FInventorySlotData());
+		BroadcastSlotChanges();
+		return true;
+	}
+	else
+	{
+		UE_LOG(LogStorageInventory, Warning, TEXT("Attempted to remove invalid item at index %d in storage"), SlotIndex);
+		return false;
+	}
+}
+
+bool FStorageInventory::TryRemoveSingleAtIndex(int32 SlotIndex, FInventorySlotData& RemovedItem)
+{
+	FInventorySlotData SlotData;
+	if (!GetAtIndex(SlotIndex, SlotData))
+	{
+		UE_LOG(LogStorageInventory, Warning, TEXT("Attempted to remove invalid item at index %d in storage"), SlotIndex);
+		return false;
+	}
+
+	RemovedItem = SlotData;
+	RemovedItem.StackSize = 1;
+
+	--SlotData.StackSize;
+	SetSlot(SlotIndex, (SlotData.StackSize > 0) ? SlotData : FInventorySlotData());
+	BroadcastSlotChanges();
+	return true;
+}
+
+bool FStorageInventory::GetAtIndex(int32 SlotIndex, FInventorySlotData& Item) const
+{
+	if (!IsValidSlotIndex(SlotIndex))
+	{
+		UE_LOG(LogStorageInventory, Error, TEXT("Can't get item from invalid index %d in storage"), SlotIndex);
+		return false;
+	}
+
+	const FInventory& Page = Pages[SlotIndex / GetPageSize()];
+	Item = (Page.Slots.Num() > 0) ? Page.Slots[SlotIndex % GetPageSize()] : FInventorySlotData();
+	return Item.IsValid();
+}
+
+void FStorageInventory::FindSlots(const FStorageQuery& Query, TArray<int32>& OutSlotIndices) const
+{
+	OutSlotIndices.Reset();
+
+	// start from the most selective index we can
+	const TArray<int32>* Candidates = nullptr;
+	if (Query.AssetType)
+	{
+		Candidates = AssetIndex.Find(Query.AssetType);
+	}
+	else if (!Query.Category.IsNone())
+	{
+		Candidates = CategoryIndex.Find(Query.Category);
+	}
+	else if (Query.MinQuality == Query.MaxQuality)
+	{
+		Candidates = QualityIndex.Find(Query.MinQuality);
+	}
+	else
+	{
+		// no selective field, every occupied slot is a candidate
+		OutSlotIndices.Reserve(OccupiedSlotCount);
+		for (const TPair<uint8, TArray<int32>>& QualityBucket : QualityIndex)
+		{
+			if ((QualityBucket.Key >= Query.MinQuality) && (QualityBucket.Key <= Query.MaxQuality))
+			{
+				OutSlotIndices.Append(QualityBucket.Value);
+			}
+		}
+		OutSlotIndices.Sort();
+		return;
+	}
+
+	if (Candidates == nullptr)
+	{
+		return;
+	}
+
+	OutSlotIndices.Reserve(Candidates->Num());
+	for (int32 SlotIndex : *Candidates)
+	{
+		FInventorySlotData SlotData;
+		GetAtIndex(SlotIndex, SlotData);
+
+		if ((Query.AssetType && (SlotData.AssetType != Query.AssetType)) ||
+			(!Query.Category.IsNone() && (GetCategoryForAsset(SlotData.AssetType) != Query.Category)) ||
+			(SlotData.Quality < Query.MinQuality) ||
+			(SlotData.Quality > Query.MaxQuality))
+		{
+			continue;
+		}
+
+		OutSlotIndices.Add(SlotIndex);
+	}
+}
+
+void FStorageInventory::SortAndCompact(EInventorySortKey Key)
+{
+	TArray<int32> OccupiedSlots;
+	FindSlots(FStorageQuery(), OccupiedSlots);
+
+	TArray<FInventorySlotData> SortedItems;
+	SortedItems.Reserve(OccupiedSlots.Num());
+	for (int32 SlotIndex : OccupiedSlots)
+	{
+		FInventorySlotData SlotData;
+		GetAtIndex(SlotIndex, SlotData);
+		SortedItems.Add(SlotData);
+	}
+
+	// stable so items that compare equal keep their relative order between sorts
+	SortedItems.StableSort([Key](const FInventorySlotData& A, const FInventorySlotData& B)
+	{
+		switch (Key)
+		{
+		case EInventorySortKey::Category:
+			return GetCategoryForAsset(A.AssetType).Compare(GetCategoryForAsset(B.AssetType)) < 0;
+		case EInventorySortKey::Quality:
+			return A.Quality > B.Quality;
+		case EInventorySortKey::StackSize:
+			return A.StackSize > B.StackSize;
+		case EInventorySortKey::Asset:
+		default:
+			return A.AssetType->GetFName().Compare(B.AssetType->GetFName()) < 0;
+		}
+	});
+
+	// only write slots whose contents actually changed so the change list stays small
+	for (int32 SortedIndex = 0; SortedIndex < SortedItems.Num(); ++SortedIndex)
+	{
+		FInventorySlotData CurrentData;
+		GetAtIndex(SortedIndex, CurrentData);
+
+		const FInventorySlotData& SortedData = SortedItems[SortedIndex];
+		if ((CurrentData.AssetType != SortedData.AssetType) || (CurrentData.StackSize != SortedData.StackSize) || (CurrentData.Quality != SortedData.Quality))
+		{
+			SetSlot(SortedIndex, SortedData);
+		}
+	}
+
+	for (int32 SlotIndex : OccupiedSlots)
+	{
+		if (SlotIndex >= SortedItems.Num())
+		{
+			SetSlot(SlotIndex, FInventorySlotData());
+		}
+	}
+
+	BroadcastSlotChanges();
+
+	// everything is at the front now, so release the slots of pages that ended up empty. the pages themselves
+	// and anything bound to them stay
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); ++PageIndex)
+	{
+		if (PageOccupiedCounts[PageIndex] == 0)
+		{
+			Pages[PageIndex].Slots.Empty();
+		}
+	}
+}
+
+bool FStorageInventory::GetPageLayoutData(int32 PageIndex, FInventoryLayoutData& OutData) const
+{
+	if ((PageIndex < 0) || (PageIndex >= PageCount))
+	{
+		UE_LOG(LogStorageInventory, Error, TEXT("Can't get layout for invalid page %d in storage"), PageIndex);
+		return false;
+	}
+
+	OutData.NumColumns = PageColCount;
+	OutData.NumRows = PageRowCount;
+
+	const int32 FirstSlotIndex = PageIndex * GetPageSize();
+	OutData.SlotHandles.Reset(GetPageSize());
+	for (int32 i = 0; i < GetPageSize(); ++i)
+	{
+		OutData.SlotHandles.Add({ EInventoryType::Storage, FirstSlotIndex + i });
+	}
+
+	return true;
+}
+
+FInventory& FStorageInventory::AllocatePage(int32 PageIndex)
+{
+	FInventory& Page = Pages[PageIndex];
+	if (Page.Slots.Num() == 0)
+	{
+		// storage logged once when it was initialized, a line per page would spam
+		Page.InitializeSlots();
+	}
+	return Page;
+}
+
+void FStorageInventory::SetSlot(int32 SlotIndex, const FInventorySlotData& NewData)
+{
+	check(IsValidSlotIndex(SlotIndex));
+
+	const int32 PageIndex = SlotIndex / GetPageSize();
+	const int32 PageSlotIndex = SlotIndex % GetPageSize();
+
+	FInventory& Page = AllocatePage(PageIndex);
+	FInventorySlotData& SlotData = Page.Slots[PageSlotIndex];
+
+	if (SlotData.IsValid())
+	{
+		RemoveFromIndices(SlotIndex, SlotData);
+		--PageOccupiedCounts[PageIndex];
+		--OccupiedSlotCount;
+	}
+
+	SlotData = NewData.IsValid() ? NewData : FInventorySlotData();
+
+	if (SlotData.IsValid())
+	{
+		AddToIndices(SlotIndex, SlotData);
+		++PageOccupiedCounts[PageIndex];
+		++OccupiedSlotCount;
+	}
+
+	// the page's dirty bit tells us whether we already recorded this slot during the current operation
+	if (!Page.IsSlotDirty(PageSlotIndex))
+	{
+		Page.MarkSlotDirty(PageSlotIndex);
+		ChangedSlots.Add(SlotIndex);
+		ChangedPages.Add(PageIndex);
+	}
+}
+
+void FStorageInventory::AddToIndices(int32 SlotIndex, const FInventorySlotData& SlotData)
+{
+	AddToBucket(AssetIndex, SlotData.AssetType, SlotIndex);
+	AddToBucket(CategoryIndex, GetCategoryForAsset(SlotData.AssetType), SlotIndex);
+	AddToBucket(QualityIndex, SlotData.Quality, SlotIndex);
+	AssetCounts.FindOrAdd(SlotData.AssetType) += SlotData.StackSize;
+}
+
+void FStorageInventory::RemoveFromIndices(int32 SlotIndex, const FInventorySlotData& SlotData)
+{
+	RemoveFromBucket(AssetIndex, SlotData.AssetType, SlotIndex);
+	RemoveFromBucket(CategoryIndex, GetCategoryForAsset(SlotData.AssetType), SlotIndex);
+	RemoveFromBucket(QualityIndex, SlotData.Quality, SlotIndex);
+
+	int32& AssetCount = AssetCounts.FindChecked(SlotData.AssetType);
+	AssetCount -= SlotData.StackSize;
+	if (AssetCount <= 0)
+	{
+		AssetCounts.Remove(SlotData.AssetType);
+	}
+}
+
+int32 FStorageInventory::FindEmptySlot() const
+{
+	for (int32 PageIndex = 0; PageIndex < PageCount; ++PageIndex)
+	{
+		if (PageOccupiedCounts[PageIndex] == GetPageSize())
+		{
+			continue;
+		}
+
+		const FInventory& Page = Pages[PageIndex];
+		if (Page.Slots.Num() == 0)
+		{
+			// an unallocated page is empty
+			return PageIndex * GetPageSize();
+		}
+
+		for (int32 PageSlotIndex = 0; PageSlotIndex < Page.Slots.Num(); ++PageSlotIndex)
+		{
+			if (!Page.Slots[PageSlotIndex].IsValid())
+			{
+				return (PageIndex * GetPageSize()) + PageSlotIndex;
+			}
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+void FStorageInventory::BroadcastSlotChanges()
+{
+	// page listeners (e.g. the widget showing that page) get their page-local indices
+	for (int32 PageIndex : ChangedPages)
+	{
+		Pages[PageIndex].BroadcastSlotChanges();
+	}
+	ChangedPages.Reset();
+
+	if (ChangedSlots.Num() > 0)
+	{
+		TArray<int32> BroadcastSlots = MoveTemp(ChangedSlots);
+		ChangedSlots.Reset();
+		OnSlotsChanged.Broadcast(BroadcastSlots);
+	}
+}
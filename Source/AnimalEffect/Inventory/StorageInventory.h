@@ -0,0 +1,130 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Inventory.h"
+#include "InventoryAccessInterface.h"
+
+#include "StorageInventory.generated.h"
+
+// carries the storage-wide slot index of every slot touched by a single storage operation
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnStorageSlotsChanged, const TArray<int32>& /*ChangedSlots*/);
+
+// every set field must match. unset fields match anything
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FStorageQuery
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	const UAEMetaAsset* AssetType = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FName Category = NAME_None;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	uint8 MinQuality = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	uint8 MaxQuality = MAX_uint8;
+};
+
+/**
+ * Storage for thousands of slots, split into pages of PageRowCount x PageColCount.
+ * - Pages are plain FInventory instances created by InitializeStorage. They never move after that, so a page's
+ *   OnSlotsChanged can be bound once the storage is initialized. A page's slots are only allocated once something is stored in it.
+ * - Occupied slots are indexed by asset, category and quality so queries don't walk the whole capacity.
+ * - Slot indices are storage-wide: SlotIndex / GetPageSize() is the page, the remainder the slot in that page.
+ * The UI should only ever ask for the page it's showing through GetPageLayoutData.
+ */
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FStorageInventory
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (ClampMin = 1))
+	int32 PageCount = 100;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (ClampMin = 1))
+	int32 PageRowCount = 4;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta = (ClampMin = 1, DisplayName = "Page Column Count"))
+	int32 PageColCount = 10;
+
+	// broadcast once at the end of every operation that changed at least one slot
+	FOnStorageSlotsChanged OnSlotsChanged;
+
+	void InitializeStorage(AActor* InOwner);
+
+	FORCEINLINE int32 GetPageSize() const { return PageRowCount * PageColCount; }
+	FORCEINLINE int32 GetCapacity() const { return PageCount * GetPageSize(); }
+	FORCEINLINE bool IsValidSlotIndex(int32 SlotIndex) const { return (SlotIndex >= 0) && (SlotIndex < GetCapacity()); }
+
+	// returns a remainder of items not added
+	int32 TryAdd(const UAEMetaAsset* AssetType, int32 Count = 1, uint8 Quality = 1);
+
+	// returns true if found and removed a valid item
+	bool TryRemoveAtIndex(int32 SlotIndex, FInventorySlotData& RemovedItem);
+
+	// returns true if found a valid item
+	bool GetAtIndex(int32 SlotIndex, FInventorySlotData& Item) const;
+
+	FORCEINLINE int32 GetAssetCount(const UAEMetaAsset* AssetType) const { return AssetCounts.FindRef(AssetType); }
+
+	FORCEINLINE int32 GetOccupiedSlotCount() const { return OccupiedSlotCount; }
+
+	// storage-wide indices of every slot matching the query, in ascending order
+	void FindSlots(const FStorageQuery& Query, TArray<int32>& OutSlotIndices) const;
+
+	// returns true if found and removed one item from a valid stack
+	bool TryRemoveSingleAtIndex(int32 SlotIndex, FInventorySlotData& RemovedItem);
+
+	// stable sorts the occupied slots by Key and moves them to the front, releasing the slots of pages that end up empty
+	void SortAndCompact(EInventorySortKey Key);
+
+	FORCEINLINE bool IsPageAllocated(int32 PageIndex) const { return Pages.IsValidIndex(PageIndex) && (Pages[PageIndex].Slots.Num() > 0); }
+
+	// null only for an invalid index. an unallocated page has no slots, which means it's empty
+	FORCEINLINE FInventory* GetPage(int32 PageIndex) { return Pages.IsValidIndex(PageIndex) ? &Pages[PageIndex] : nullptr; }
+	FORCEINLINE const FInventory* GetPage(int32 PageIndex) const { return Pages.IsValidIndex(PageIndex) ? &Pages[PageIndex] : nullptr; }
+
+	bool GetPageLayoutData(int32 PageIndex, FInventoryLayoutData& OutData) const;
+
+private:
+
+	FInventory& AllocatePage(int32 PageIndex);
+
+	// the only place a slot is written so the indices always match the pages
+	void SetSlot(int32 SlotIndex, const FInventorySlotData& NewData);
+
+	void AddToIndices(int32 SlotIndex, const FInventorySlotData& SlotData);
+	void RemoveFromIndices(int32 SlotIndex, const FInventorySlotData& SlotData);
+
+	int32 FindEmptySlot() const;
+
+	void BroadcastSlotChanges();
+
+private:
+
+	UPROPERTY(Transient)
+	AActor* Owner = nullptr;
+
+	// PageCount of them, never resized outside of InitializeStorage
+	UPROPERTY(Transient)
+	TArray<FInventory> Pages;
+
+	// occupied slots per page
+	TArray<int32> PageOccupiedCounts;
+
+	int32 OccupiedSlotCount = 0;
+
+	// buckets are kept sorted by slot index
+	TMap<const UAEMetaAsset*, TArray<int32>> AssetIndex;
+	TMap<FName, TArray<int32>> CategoryIndex;
+	TMap<uint8, TArray<int32>> QualityIndex;
+	TMap<const UAEMetaAsset*, int32> AssetCounts;
+
+	TArray<int32> ChangedSlots;
+	TSet<int32> ChangedPages;
+
+};
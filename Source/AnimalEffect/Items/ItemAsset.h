@@ -34,6 +34,9 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "Inventory")
 	TArray<EInventoryItemActions> InventoryActions;
 
+	UPROPERTY(EditDefaultsOnly, Category = "Inventory")
+	FName InventoryCategory;
+
 public:
 
 	UItemAsset();
@@ -47,5 +50,6 @@ public:
 	FORCEINLINE uint8 GetInventoryStackMax() const override { return bCanStack ? InventoryStackMax : 1; }
 	bool GetAvailableItemActions(TArray<EInventoryItemActions>& AvailableActions) const override;
 	EInventoryType GetInventoryType() const { return InventoryType; }
+	FName GetInventoryCategory() const override { return InventoryCategory; }
 	// END IInventoryItemInterface
 };
@@ -7,6 +7,10 @@
 #include "GameFramework/AECharacter.h"
 #include "WorldGrid/WorldGridSubsystem.h"
 
+#include "Engine/AssetManager.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogToolShovel, Log, All);
+
 ATool_Shovel::ATool_Shovel()
 	: ATool()
 {
@@ -31,16 +35,46 @@ void ATool_Shovel::FinalizeAction()
 		
 		if (BlockingActor == nullptr)
 		{
+			// removing it from the grid right away means the cell can't be dug twice while the load is in flight
 			TSoftObjectPtr<UDigActualizer> DigActualizer = WGS->TryRemoveDigActualizerFromGrid(ProbePosition);
-			DigActualizer.LoadSynchronous(); // #fixme?
-			if (DigActualizer.IsValid())
+			AAECharacter* OwnerCharacter = Cast<AAECharacter>(GetOwner());
+			if (const UDigActualizer* LoadedActualizer = DigActualizer.Get())
 			{
-				AAECharacter* OwnerCharacter = Cast<AAECharacter>(GetOwner());
-				FPickupData DigPickup = DigActualizer->Actualize();
-				OwnerCharacter->TryGiveItemsOfAssetType(DigPickup.AssetType, DigPickup.StackSize, DigPickup.Quality);
+				GiveDigPickup(OwnerCharacter, LoadedActualizer);
+			}
+			else if (!DigActualizer.IsNull())
+			{
+				// the tool may be released before this lands, so hold on to the digger and the grid instead
+				TWeakObjectPtr<AAECharacter> WeakCharacter(OwnerCharacter);
+				TWeakObjectPtr<UWorldGridSubsystem> WeakWGS(WGS);
+				UAssetManager::GetStreamableManager().RequestAsyncLoad(DigActualizer.ToSoftObjectPath(), [WeakCharacter, WeakWGS, DigActualizer, ProbePosition]()
+				{
+					if (WeakCharacter.IsValid() && DigActualizer.IsValid())
+					{
+						GiveDigPickup(WeakCharacter.Get(), DigActualizer.Get());
+					}
+					else if (WeakWGS.IsValid())
+					{
+						// nobody to hand it to, bury it again so it isn't lost
+						UE_LOG(LogToolShovel, Warning, TEXT("Couldn't deliver '%s', putting it back at %s"), *DigActualizer.ToString(), *ProbePosition.ToString());
+						WeakWGS->TryPlaceDigActualizerOnGrid(DigActualizer, ProbePosition);
+					}
+				});
 			}
 		}
 
 		WGS->DebugDrawPosition(ProbePosition, 2.f, FColor::Red);
 	}
 }
+
+void ATool_Shovel::GiveDigPickup(AAECharacter* OwnerCharacter, const UDigActualizer* DigActualizer)
+{
+	if (!IsValid(OwnerCharacter))
+	{
+		UE_LOG(LogToolShovel, Warning, TEXT("Dug up '%s' with no character to give it to"), *DigActualizer->GetName());
+		return;
+	}
+
+	FPickupData DigPickup = DigActualizer->Actualize();
+	OwnerCharacter->TryGiveItemsOfAssetType(DigPickup.AssetType, DigPickup.StackSize, DigPickup.Quality);
+}
@@ -6,6 +6,9 @@
 
 #include "Tool_Shovel.generated.h"
 
+class AAECharacter;
+class UDigActualizer;
+
 UCLASS()
 class ANIMALEFFECT_API ATool_Shovel : public ATool
 {
@@ -17,4 +20,9 @@ public:
 
 	void FinalizeAction() override;
 
+private:
+
+	// static so it can run after the shovel is gone. the pickup belongs to whoever dug, not to the tool
+	static void GiveDigPickup(AAECharacter* Character, const UDigActualizer* DigActualizer);
+
 };
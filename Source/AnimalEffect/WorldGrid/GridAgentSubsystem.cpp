@@ -0,0 +1,482 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "GridAgentSubsystem.h"
+
+#include "WorldGridPathfindingSubsystem.h"
+#include "WorldGridSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogGridAgentSubsystem, Log, All);
+
+namespace
+{
+	// detours around other agents are plain A* with reservations blocking, kept short since the way is usually clear again soon
+	constexpr int32 DetourMaxExpandedNodes = 4096;
+}
+
+UGridAgentSubsystem* UGridAgentSubsystem::Get(const UObject* WorldContextObject)
+{
+	auto GridAgentSubsystem = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::Assert)->GetSubsystem<UGridAgentSubsystem>();
+	check(GridAgentSubsystem);
+	return GridAgentSubsystem;
+}
+
+void UGridAgentSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Collection.InitializeDependency(UWorldGridSubsystem::StaticClass());
+	Collection.InitializeDependency(UWorldGridPathfindingSubsystem::StaticClass());
+
+	Super::Initialize(Collection);
+
+	Config = UWorldGridSubsystem::Get(this)->GetConfig().Agents;
+
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(this, &UGridAgentSubsystem::OnWorldPreActorTick);
+}
+
+void UGridAgentSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+
+	for (TConstSetBitIterator<> It(ActiveAgents); It; ++It)
+	{
+		DestroyProxy(It.GetIndex());
+	}
+
+	Super::Deinitialize();
+}
+
+FGridAgentHandle UGridAgentSubsystem::AddAgent(const FGridVector& Position, TSubclassOf<AActor> ProxyClass)
+{
+	const int32 ReservationToken = UWorldGridSubsystem::NewReservationToken();
+	if (!UWorldGridSubsystem::Get(this)->TryReserveCells(FGridRect(Position, Position + FGridVector(1)), ReservationToken))
+	{
+		UE_LOG(LogGridAgentSubsystem, Warning, TEXT("Can't add an agent at %s, the cell is taken or off the grid."), *Position.ToString());
+		return FGridAgentHandle();
+	}
+
+	int32 Index;
+	if (FreeSlots.Num() > 0)
+	{
+		Index = FreeSlots.Pop(false);
+	}
+	else
+	{
+		Index = ActiveAgents.Add(false);
+		Serials.Add(0);
+		Positions.AddDefaulted();
+		Goals.AddDefaulted();
+		ReservationTokens.Add(0);
+		States.Add(EGridAgentState::Idle);
+		Tiers.Add(EGridAgentTier::Far);
+		LastUpdateTimes.Add(0.0);
+		NextUpdateTimes.Add(0.0);
+		MoveProgress.Add(0.f);
+		BlockedUpdateCounts.Add(0);
+		DetourFailed.Add(false);
+		Paths.AddDefaulted();
+		PathIndices.Add(0);
+		ProxyClasses.AddDefaulted();
+		Proxies.Add(nullptr);
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	ActiveAgents[Index] = true;
+	++Serials[Index];
+	Positions[Index] = Position;
+	Goals[Index] = Position;
+	ReservationTokens[Index] = ReservationToken;
+	States[Index] = EGridAgentState::Idle;
+	// far until the next frame decides otherwise, so a new agent never spawns a proxy it doesn't need
+	Tiers[Index] = EGridAgentTier::Far;
+	LastUpdateTimes[Index] = Now;
+	NextUpdateTimes[Index] = Now;
+	MoveProgress[Index] = 0.f;
+	BlockedUpdateCounts[Index] = 0;
+	DetourFailed[Index] = false;
+	Paths[Index].Reset();
+	PathIndices[Index] = 0;
+	ProxyClasses[Index] = ProxyClass;
+	Proxies[Index] = nullptr;
+
+	++AgentCount;
+
+	FGridAgentHandle Handle;
+	Handle.Index = Index;
+	Handle.Serial = Serials[Index];
+	return Handle;
+}
+
+void UGridAgentSubsystem::RemoveAgent(FGridAgentHandle& Handle)
+{
+	if (!IsValidAgent(Handle))
+	{
+		Handle.Reset();
+		return;
+	}
+
+	const int32 Index = Handle.Index;
+	const FGridVector& Position = Positions[Index];
+	UWorldGridSubsystem::Get(this)->ReleaseCells(FGridRect(Position, Position + FGridVector(1)), ReservationTokens[Index]);
+
+	DestroyProxy(Index);
+
+	ActiveAgents[Index] = false;
+	// in-flight path requests check the serial, this makes them drop their result
+	++Serials[Index];
+	Paths[Index].Empty();
+	ProxyClasses[Index] = nullptr;
+	FreeSlots.Add(Index);
+
+	--AgentCount;
+
+	Handle.Reset();
+}
+
+bool UGridAgentSubsystem::IsValidAgent(const FGridAgentHandle& Handle) const
+{
+	return Handle.IsValid() && ActiveAgents.IsValidIndex(Handle.Index) && ActiveAgents[Handle.Index] && (Serials[Handle.Index] == Handle.Serial);
+}
+
+bool UGridAgentSubsystem::MoveAgentTo(const FGridAgentHandle& Handle, const FGridVector& Goal)
+{
+	if (!IsValidAgent(Handle))
+	{
+		return false;
+	}
+
+	Goals[Handle.Index] = Goal;
+	RequestPath(Handle.Index, false);
+	return true;
+}
+
+void UGridAgentSubsystem::StopAgent(const FGridAgentHandle& Handle)
+{
+	if (!IsValidAgent(Handle))
+	{
+		return;
+	}
+
+	const int32 Index = Handle.Index;
+	Goals[Index] = Positions[Index];
+	States[Index] = EGridAgentState::Idle;
+	Paths[Index].Reset();
+	MoveProgress[Index] = 0.f;
+}
+
+bool UGridAgentSubsystem::GetAgentPosition(const FGridAgentHandle& Handle, FGridVector& OutPosition) const
+{
+	if (!IsValidAgent(Handle))
+	{
+		return false;
+	}
+
+	OutPosition = Positions[Handle.Index];
+	return true;
+}
+
+EGridAgentState UGridAgentSubsystem::GetAgentState(const FGridAgentHandle& Handle) const
+{
+	return IsValidAgent(Handle) ? States[Handle.Index] : EGridAgentState::Idle;
+}
+
+AActor* UGridAgentSubsystem::GetAgentProxy(const FGridAgentHandle& Handle) const
+{
+	return IsValidAgent(Handle) ? Proxies[Handle.Index] : nullptr;
+}
+
+void UGridAgentSubsystem::OnWorldPreActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if ((World != GetWorld()) || (AgentCount == 0))
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double Deadline = StartTime + (Config.FrameBudgetMs / 1000.0);
+	const double Now = World->GetTimeSeconds();
+
+	// tiers are a few integer compares per agent, cheap enough to keep exact every frame
+	TArray<FGridVector, TInlineAllocator<4>> PlayerCells;
+	GatherPlayerCells(PlayerCells);
+	for (TConstSetBitIterator<> It(ActiveAgents); It; ++It)
+	{
+		RefreshTier(It.GetIndex(), PlayerCells, Now);
+	}
+
+	int32 UpdatedCount = 0;
+
+	// near agents first, players would notice them starving behind far ones. they get their own cursor too, or the ones late in
+	// the array would starve behind the near ones before them whenever the budget runs out
+	const int32 SlotCount = ActiveAgents.Num();
+	for (int32 Visited = 0; Visited < SlotCount; ++Visited)
+	{
+		const int32 Index = NearRoundRobinCursor;
+		NearRoundRobinCursor = (NearRoundRobinCursor + 1) % SlotCount;
+
+		if (ActiveAgents[Index] && (Tiers[Index] == EGridAgentTier::Near) && (Now >= NextUpdateTimes[Index]))
+		{
+			UpdateAgent(Index, Now);
+			++UpdatedCount;
+
+			if (FPlatformTime::Seconds() >= Deadline)
+			{
+				break;
+			}
+		}
+	}
+
+	// then everyone else round-robin, picking up where the last frame ran out of budget
+	for (int32 Visited = 0; (Visited < SlotCount) && (FPlatformTime::Seconds() < Deadline); ++Visited)
+	{
+		const int32 Index = RoundRobinCursor;
+		RoundRobinCursor = (RoundRobinCursor + 1) % SlotCount;
+
+		if (ActiveAgents[Index] && (Tiers[Index] != EGridAgentTier::Near) && (Now >= NextUpdateTimes[Index]))
+		{
+			UpdateAgent(Index, Now);
+			++UpdatedCount;
+		}
+	}
+
+	LastUpdatedAgentCount = UpdatedCount;
+}
+
+void UGridAgentSubsystem::GatherPlayerCells(TArray<FGridVector, TInlineAllocator<4>>& OutCells) const
+{
+	UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(this);
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APawn* Pawn = It->IsValid() ? (*It)->GetPawn() : nullptr;
+
+		FGridVector Cell;
+		if (Pawn && WorldGrid->GetGridPositionAtWorldLocation(Pawn->GetActorLocation(), Cell))
+		{
+			OutCells.Add(Cell);
+		}
+	}
+}
+
+void UGridAgentSubsystem::RefreshTier(int32 Index, const TArray<FGridVector, TInlineAllocator<4>>& PlayerCells, double Now)
+{
+	const FGridVector& Position = Positions[Index];
+
+	int32 NearestDistance = MAX_int32;
+	for (const FGridVector& PlayerCell : PlayerCells)
+	{
+		NearestDistance = FMath::Min(NearestDistance, FMath::Max(FMath::Abs(PlayerCell.X - Position.X), FMath::Abs(PlayerCell.Y - Position.Y)));
+	}
+
+	const EGridAgentTier NewTier = (NearestDistance <= Config.NearDistance) ? EGridAgentTier::Near
+		: (NearestDistance <= Config.MidDistance) ? EGridAgentTier::Mid
+		: EGridAgentTier::Far;
+
+	const EGridAgentTier OldTier = Tiers[Index];
+	if (NewTier == OldTier)
+	{
+		return;
+	}
+
+	Tiers[Index] = NewTier;
+
+	if (NewTier == EGridAgentTier::Near)
+	{
+		SpawnProxy(Index);
+	}
+	else if (OldTier == EGridAgentTier::Near)
+	{
+		DestroyProxy(Index);
+	}
+
+	// don't make an agent that just got closer wait out its old, longer interval
+	NextUpdateTimes[Index] = FMath::Min(NextUpdateTimes[Index], Now + GetUpdateInterval(NewTier));
+}
+
+float UGridAgentSubsystem::GetUpdateInterval(EGridAgentTier Tier) const
+{
+	switch (Tier)
+	{
+	case EGridAgentTier::Mid: return Config.MidUpdateInterval;
+	case EGridAgentTier::Far: return Config.FarUpdateInterval;
+	default: return 0.f;
+	}
+}
+
+void UGridAgentSubsystem::UpdateAgent(int32 Index, double Now)
+{
+	const float Elapsed = Now - LastUpdateTimes[Index];
+	LastUpdateTimes[Index] = Now;
+	NextUpdateTimes[Index] = Now + GetUpdateInterval(Tiers[Index]);
+
+	const EGridAgentState State = States[Index];
+	if ((State != EGridAgentState::Moving) && (State != EGridAgentState::Blocked))
+	{
+		return;
+	}
+
+	// a far agent covers everything it missed since its last update in one go
+	MoveProgress[Index] += Elapsed * Config.MoveSpeed;
+	while (MoveProgress[Index] >= 1.f)
+	{
+		if (!StepAgent(Index))
+		{
+			// waiting doesn't bank progress, or the agent would teleport once the way clears
+			MoveProgress[Index] = 0.f;
+			break;
+		}
+		MoveProgress[Index] -= 1.f;
+
+		if (States[Index] == EGridAgentState::Idle)
+		{
+			MoveProgress[Index] = 0.f;
+			break;
+		}
+	}
+
+	if (AActor* Proxy = Proxies[Index])
+	{
+		Proxy->SetActorLocation(UWorldGridSubsystem::Get(this)->GetWorldLocationAtGridPosition(Positions[Index]));
+	}
+}
+
+bool UGridAgentSubsystem::StepAgent(int32 Index)
+{
+	TArray<FGridVector>& Path = Paths[Index];
+	if (!Path.IsValidIndex(PathIndices[Index]))
+	{
+		States[Index] = EGridAgentState::Idle;
+		return true;
+	}
+
+	UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(this);
+
+	const FGridVector Current = Positions[Index];
+	const FGridVector Next = Path[PathIndices[Index]];
+
+	// take the next cell before letting go of this one, so nothing can slip in between
+	if (!WorldGrid->TryReserveCells(FGridRect(Next, Next + FGridVector(1)), ReservationTokens[Index]))
+	{
+		States[Index] = EGridAgentState::Blocked;
+		if (++BlockedUpdateCounts[Index] >= Config.BlockedUpdatesBeforeRepath)
+		{
+			RequestPath(Index, !DetourFailed[Index]);
+		}
+		return false;
+	}
+
+	WorldGrid->ReleaseCells(FGridRect(Current, Current + FGridVector(1)), ReservationTokens[Index]);
+
+	Positions[Index] = Next;
+	BlockedUpdateCounts[Index] = 0;
+
+	if (++PathIndices[Index] >= Path.Num())
+	{
+		States[Index] = EGridAgentState::Idle;
+		Path.Reset();
+	}
+	else
+	{
+		States[Index] = EGridAgentState::Moving;
+	}
+
+	return true;
+}
+
+void UGridAgentSubsystem::RequestPath(int32 Index, bool bAvoidAgents)
+{
+	const FGridVector& Position = Positions[Index];
+	const FGridVector& Goal = Goals[Index];
+	if ((Position.X == Goal.X) && (Position.Y == Goal.Y))
+	{
+		States[Index] = EGridAgentState::Idle;
+		Paths[Index].Reset();
+		return;
+	}
+
+	States[Index] = EGridAgentState::WaitingForPath;
+	BlockedUpdateCounts[Index] = 0;
+
+	UWorldGridPathfindingSubsystem* Pathfinding = UWorldGridPathfindingSubsystem::Get(this);
+	FOnWorldGridPathFound OnFound = FOnWorldGridPathFound::CreateUObject(this, &UGridAgentSubsystem::OnPathFound, Index, Serials[Index], bAvoidAgents);
+
+	// the hierarchical search walks through reserved cells, which is what got a blocked agent stuck
+	if (bAvoidAgents)
+	{
+		FWorldGridPathQuery Query = Pathfinding->MakeQuery(Position, Goal);
+		Query.MaxExpandedNodes = DetourMaxExpandedNodes;
+		Pathfinding->FindPathAsync(Query, MoveTemp(OnFound));
+	}
+	else
+	{
+		Pathfinding->FindPathHierarchicalAsync(Position, Goal, MoveTemp(OnFound));
+	}
+}
+
+void UGridAgentSubsystem::OnPathFound(bool bFound, const TArray<FGridVector>& Path, int32 Index, int32 Serial, bool bDetour)
+{
+	// removed, or removed and the slot reused, while searching
+	if (!ActiveAgents.IsValidIndex(Index) || !ActiveAgents[Index] || (Serials[Index] != Serial))
+	{
+		return;
+	}
+
+	// stopped or redirected while searching. a redirect has its own request in flight
+	const bool bForOtherGoal = (Path.Num() > 0) && ((Path.Last().X != Goals[Index].X) || (Path.Last().Y != Goals[Index].Y));
+	if ((States[Index] != EGridAgentState::WaitingForPath) || bForOtherGoal)
+	{
+		return;
+	}
+
+	// the detour search is capped, so not finding one doesn't mean the goal is unreachable.
+	// stay on the old path and wait, the next repath goes through the hierarchical search again
+	if (bDetour && (!bFound || (Path.Num() < 2)) && Paths[Index].IsValidIndex(PathIndices[Index]))
+	{
+		UE_LOG(LogGridAgentSubsystem, Verbose, TEXT("No detour for agent %d from %s, waiting."), Index, *Positions[Index].ToString());
+		States[Index] = EGridAgentState::Blocked;
+		DetourFailed[Index] = true;
+		return;
+	}
+
+	// the agent hasn't moved since asking, so the path starts on its cell
+	if (!bFound || (Path.Num() < 2))
+	{
+		UE_LOG(LogGridAgentSubsystem, Verbose, TEXT("No path for agent %d from %s to %s."), Index, *Positions[Index].ToString(), *Goals[Index].ToString());
+		States[Index] = EGridAgentState::Idle;
+		Paths[Index].Reset();
+		return;
+	}
+
+	Paths[Index] = Path;
+	PathIndices[Index] = 1;
+	DetourFailed[Index] = false;
+	States[Index] = EGridAgentState::Moving;
+	LastUpdateTimes[Index] = GetWorld()->GetTimeSeconds();
+	MoveProgress[Index] = 0.f;
+}
+
+void UGridAgentSubsystem::SpawnProxy(int32 Index)
+{
+	if ((ProxyClasses[Index] == nullptr) || (Proxies[Index] != nullptr))
+	{
+		return;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const FVector Location = UWorldGridSubsystem::Get(this)->GetWorldLocationAtGridPosition(Positions[Index]);
+	Proxies[Index] = GetWorld()->SpawnActor<AActor>(ProxyClasses[Index], Location, FRotator::ZeroRotator, SpawnParams);
+}
+
+void UGridAgentSubsystem::DestroyProxy(int32 Index)
+{
+	if (Proxies[Index] != nullptr)
+	{
+		Proxies[Index]->Destroy();
+		Proxies[Index] = nullptr;
+	}
+}
@@ -0,0 +1,152 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGridTypes.h"
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "GridAgentSubsystem.generated.h"
+
+UENUM(BlueprintType)
+enum class EGridAgentState : uint8
+{
+	Idle,
+	WaitingForPath,
+	Moving,
+	// the next cell on the path is taken
+	Blocked,
+};
+
+// how often an agent is updated, by distance to the nearest player
+UENUM(BlueprintType)
+enum class EGridAgentTier : uint8
+{
+	Near,
+	Mid,
+	Far,
+};
+
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FGridAgentHandle
+{
+	GENERATED_BODY()
+
+	int32 Index = INDEX_NONE;
+
+	// bumped whenever a slot is reused, so handles to removed agents stay invalid
+	int32 Serial = 0;
+
+	FORCEINLINE bool IsValid() const { return Index != INDEX_NONE; }
+
+	FORCEINLINE void Reset() { *this = FGridAgentHandle(); }
+};
+
+/**
+ * Simulates grid agents (villagers, wildlife) without an actor or a tick each.
+ * - Agent state lives in flat arrays indexed by slot. Removed slots are reused.
+ * - Every frame, agents near a player are updated first, then the rest round-robin until FGridAgentConfig::FrameBudgetMs is spent.
+ *   Mid and far agents only come up every MidUpdateInterval/FarUpdateInterval and cover the distance they missed in one update.
+ * - An agent holds a reservation on the cell it stands on and moves by reserving the next cell before releasing its own,
+ *   so the grid, spawning and other agents all see it.
+ * - Agents near a player get a proxy actor of their ProxyClass, if they have one, that's destroyed again once they're further away.
+ * Paths come from UWorldGridPathfindingSubsystem's hierarchical search on a worker.
+ */
+UCLASS()
+class ANIMALEFFECT_API UGridAgentSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	static UGridAgentSubsystem* Get(const UObject* WorldContextObject);
+
+	void Initialize(FSubsystemCollectionBase& Collection) override;
+	void Deinitialize() override;
+
+	// invalid if Position can't be reserved
+	FGridAgentHandle AddAgent(const FGridVector& Position, TSubclassOf<AActor> ProxyClass = nullptr);
+
+	void RemoveAgent(FGridAgentHandle& Handle);
+
+	bool IsValidAgent(const FGridAgentHandle& Handle) const;
+
+	// returns false if the handle is invalid. the agent goes idle when it gets there or no path is found
+	bool MoveAgentTo(const FGridAgentHandle& Handle, const FGridVector& Goal);
+
+	void StopAgent(const FGridAgentHandle& Handle);
+
+	bool GetAgentPosition(const FGridAgentHandle& Handle, FGridVector& OutPosition) const;
+
+	EGridAgentState GetAgentState(const FGridAgentHandle& Handle) const;
+
+	// null unless the agent is near a player and has a proxy class
+	AActor* GetAgentProxy(const FGridAgentHandle& Handle) const;
+
+	FORCEINLINE int32 GetAgentCount() const { return AgentCount; }
+
+	// for profiling
+	FORCEINLINE int32 GetLastUpdatedAgentCount() const { return LastUpdatedAgentCount; }
+
+private:
+
+	void OnWorldPreActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void GatherPlayerCells(TArray<FGridVector, TInlineAllocator<4>>& OutCells) const;
+
+	void RefreshTier(int32 Index, const TArray<FGridVector, TInlineAllocator<4>>& PlayerCells, double Now);
+
+	void UpdateAgent(int32 Index, double Now);
+
+	// returns false if the agent couldn't move
+	bool StepAgent(int32 Index);
+
+	void RequestPath(int32 Index, bool bAvoidAgents);
+	void OnPathFound(bool bFound, const TArray<FGridVector>& Path, int32 Index, int32 Serial, bool bDetour);
+
+	void SpawnProxy(int32 Index);
+	void DestroyProxy(int32 Index);
+
+	float GetUpdateInterval(EGridAgentTier Tier) const;
+
+private:
+
+	FGridAgentConfig Config;
+
+	FDelegateHandle PreActorTickHandle;
+
+	// agent state, one element per slot
+	TBitArray<> ActiveAgents;
+	TArray<int32> Serials;
+	TArray<FGridVector> Positions;
+	TArray<FGridVector> Goals;
+	TArray<int32> ReservationTokens;
+	TArray<EGridAgentState> States;
+	TArray<EGridAgentTier> Tiers;
+	TArray<double> LastUpdateTimes;
+	TArray<double> NextUpdateTimes;
+	// fractions of a cell walked but not stepped yet
+	TArray<float> MoveProgress;
+	TArray<uint8> BlockedUpdateCounts;
+	// the last detour around other agents found nothing, so the next repath goes back to the hierarchical search
+	TArray<bool> DetourFailed;
+	TArray<TArray<FGridVector>> Paths;
+	TArray<int32> PathIndices;
+
+	UPROPERTY(Transient)
+	TArray<TSubclassOf<AActor>> ProxyClasses;
+
+	UPROPERTY(Transient)
+	TArray<AActor*> Proxies;
+
+	TArray<int32> FreeSlots;
+
+	int32 AgentCount = 0;
+
+	int32 NearRoundRobinCursor = 0;
+
+	int32 RoundRobinCursor = 0;
+
+	int32 LastUpdatedAgentCount = 0;
+
+};
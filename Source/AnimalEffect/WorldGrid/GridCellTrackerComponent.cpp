@@ -0,0 +1,68 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "GridCellTrackerComponent.h"
+
+#include "WorldGridSubsystem.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogGridCellTracker, Log, All);
+
+UGridCellTrackerComponent::UGridCellTrackerComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UGridCellTrackerComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	WorldGrid = UWorldGridSubsystem::Get(this);
+
+	TrackedComponent = GetOwner()->GetRootComponent();
+	if (TrackedComponent.IsValid())
+	{
+		TransformUpdatedHandle = TrackedComponent->TransformUpdated.AddUObject(this, &UGridCellTrackerComponent::OnRootTransformUpdated);
+	}
+	else
+	{
+		UE_LOG(LogGridCellTracker, Error, TEXT("'%s' has no root component to track"), *GetOwner()->GetName());
+	}
+
+	UpdateCurrentCell();
+}
+
+void UGridCellTrackerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (TrackedComponent.IsValid())
+	{
+		TrackedComponent->TransformUpdated.Remove(TransformUpdatedHandle);
+	}
+	TrackedComponent.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UGridCellTrackerComponent::OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	UpdateCurrentCell();
+}
+
+void UGridCellTrackerComponent::UpdateCurrentCell()
+{
+	if (!TrackedComponent.IsValid())
+	{
+		return;
+	}
+
+	FGridVector NewCell;
+	if (!WorldGrid->GetGridPositionAtWorldLocation(TrackedComponent->GetComponentLocation(), NewCell))
+	{
+		NewCell.Invalidate();
+	}
+
+	if ((NewCell.X != CurrentCell.X) || (NewCell.Y != CurrentCell.Y))
+	{
+		const FGridVector PreviousCell = CurrentCell;
+		CurrentCell = NewCell;
+		OnGridCellChanged.Broadcast(PreviousCell, CurrentCell);
+	}
+}
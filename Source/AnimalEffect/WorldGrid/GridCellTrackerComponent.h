@@ -0,0 +1,51 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGridTypes.h"
+
+#include "Components/ActorComponent.h"
+
+#include "GridCellTrackerComponent.generated.h"
+
+class UWorldGridSubsystem;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnGridCellChanged, const FGridVector& /*PreviousCell*/, const FGridVector& /*NewCell*/);
+
+// tracks which grid cell the owner's root component is in without ticking.
+// only fires when the owner actually moves into a new cell (or off the grid, in which case NewCell is invalid)
+UCLASS(ClassGroup = "WorldGrid", meta = (BlueprintSpawnableComponent))
+class ANIMALEFFECT_API UGridCellTrackerComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UGridCellTrackerComponent();
+
+	FOnGridCellChanged OnGridCellChanged;
+
+	// invalid if the owner is off the grid
+	FORCEINLINE const FGridVector& GetCurrentCell() const { return CurrentCell; }
+
+protected:
+
+	void BeginPlay() override;
+	void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+
+	void OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	void UpdateCurrentCell();
+
+	UPROPERTY(Transient)
+	UWorldGridSubsystem* WorldGrid;
+
+	TWeakObjectPtr<USceneComponent> TrackedComponent;
+
+	FDelegateHandle TransformUpdatedHandle;
+
+	FGridVector CurrentCell;
+
+};
@@ -0,0 +1,391 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WorldGridAbstractGraph.h"
+
+#include "Algo/Reverse.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	// runs at least this long get an entrance at each end instead of one in the middle
+	constexpr int32 LongEntranceLength = 6;
+
+	bool AreCostsEqual(const FWorldGridPathCostConfig& A, const FWorldGridPathCostConfig& B)
+	{
+		return (A.SandCost == B.SandCost) && (A.DirtCost == B.DirtCost) && (A.RockCost == B.RockCost) && (A.WaterCost == B.WaterCost)
+			&& (A.ElevationStepCost == B.ElevationStepCost) && (A.MaxElevationStep == B.MaxElevationStep) && (A.bAllowDiagonal == B.bAllowDiagonal)
+			&& (A.bReservationsBlock == B.bReservationsBlock);
+	}
+
+	bool IsWalkable(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const FGridVector& Position)
+	{
+		return !(Costs.bReservationsBlock ? Snapshot.IsOccupied(Position) : Snapshot.HasActor(Position)) && (Costs.GetTerrainCost(Snapshot.GetTerrainTypeAtGridPosition(Position)) >= 0.f);
+	}
+
+	float Octile(const FGridVector& A, const FGridVector& B, float MinTerrainCost)
+	{
+		const int32 DeltaX = FMath::Abs(A.X - B.X);
+		const int32 DeltaY = FMath::Abs(A.Y - B.Y);
+		return (FMath::Abs(DeltaX - DeltaY) + (FMath::Min(DeltaX, DeltaY) * 1.41421356f)) * MinTerrainCost;
+	}
+
+	struct FAbstractOpenNode
+	{
+		float F;
+		int32 CellIndex;
+	};
+
+	struct FAbstractOpenNodePredicate
+	{
+		FORCEINLINE bool operator()(const FAbstractOpenNode& A, const FAbstractOpenNode& B) const { return A.F < B.F; }
+	};
+
+	struct FAbstractSearchNode
+	{
+		float G = MAX_flt;
+		int32 Parent = INDEX_NONE;
+		bool bClosed = false;
+	};
+}
+
+int32 FWorldGridAbstractChunk::FindNode(const FGridVector& Position) const
+{
+	return Nodes.IndexOfByPredicate([&Position](const FGridVector& Node) { return (Node.X == Position.X) && (Node.Y == Position.Y); });
+}
+
+void FWorldGridAbstractGraph::GetSourceVersions(const TArray<int32>& ChunkVersions, int32 ChunkCountPerSide, const FGridVector& Chunk, TArray<int32, TFixedAllocator<5>>& OutVersions)
+{
+	OutVersions.Reset();
+	for (const FGridVector& Offset : { FGridVector(0, 0), FGridVector(1, 0), FGridVector(-1, 0), FGridVector(0, 1), FGridVector(0, -1) })
+	{
+		const FGridVector Neighbour = Chunk + Offset;
+		const bool bOnGrid = (Neighbour.X >= 0) && (Neighbour.X < ChunkCountPerSide) && (Neighbour.Y >= 0) && (Neighbour.Y < ChunkCountPerSide);
+		OutVersions.Add(bOnGrid ? ChunkVersions[(Neighbour.Y * ChunkCountPerSide) + Neighbour.X] : -1);
+	}
+}
+
+TSharedRef<const FWorldGridAbstractGraph, ESPMode::ThreadSafe> FWorldGridAbstractGraph::Build(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const TArray<int32>& ChunkVersions, const FWorldGridAbstractGraph* PreviousGraph)
+{
+	TSharedRef<FWorldGridAbstractGraph, ESPMode::ThreadSafe> Graph = MakeShared<FWorldGridAbstractGraph, ESPMode::ThreadSafe>();
+	Graph->Width = Snapshot.GetWidth();
+	Graph->ChunkCountPerSide = Snapshot.GetChunkCountPerSide();
+	Graph->Costs = Costs;
+
+	const int32 ChunkCount = Graph->ChunkCountPerSide * Graph->ChunkCountPerSide;
+	Graph->Chunks.SetNum(ChunkCount);
+	check(ChunkVersions.Num() == ChunkCount);
+
+	const bool bCanShare = PreviousGraph && (PreviousGraph->Width == Graph->Width) && AreCostsEqual(PreviousGraph->Costs, Costs);
+
+	// a chunk's entrances depend on its neighbours' border cells, so it's stale if any of the five moved
+	TArray<int32> StaleChunks;
+	TArray<TArray<int32, TFixedAllocator<5>>> StaleVersions;
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkCount; ++ChunkIndex)
+	{
+		TArray<int32, TFixedAllocator<5>> SourceVersions;
+		GetSourceVersions(ChunkVersions, Graph->ChunkCountPerSide, FGridVector(ChunkIndex % Graph->ChunkCountPerSide, ChunkIndex / Graph->ChunkCountPerSide), SourceVersions);
+
+		if (bCanShare && (PreviousGraph->Chunks[ChunkIndex]->SourceVersions == SourceVersions))
+		{
+			Graph->Chunks[ChunkIndex] = PreviousGraph->Chunks[ChunkIndex];
+		}
+		else
+		{
+			StaleChunks.Add(ChunkIndex);
+			StaleVersions.Add(SourceVersions);
+		}
+	}
+
+	const int32 ChunkCountPerSide = Graph->ChunkCountPerSide;
+	ParallelFor(StaleChunks.Num(), [&](int32 StaleIndex)
+	{
+		// searches here never leave a chunk so the pathfinder's arrays stay tiny
+		FWorldGridPathfinder Pathfinder;
+		const int32 ChunkIndex = StaleChunks[StaleIndex];
+		Graph->Chunks[ChunkIndex] = BuildChunk(Snapshot, Costs, FGridVector(ChunkIndex % ChunkCountPerSide, ChunkIndex / ChunkCountPerSide), StaleVersions[StaleIndex], Pathfinder);
+	});
+
+	Graph->RebuiltChunkCount = StaleChunks.Num();
+	return Graph;
+}
+
+FWorldGridAbstractChunkPtr FWorldGridAbstractGraph::BuildChunk(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const FGridVector& Chunk, const TArray<int32, TFixedAllocator<5>>& SourceVersions, FWorldGridPathfinder& Pathfinder)
+{
+	TSharedRef<FWorldGridAbstractChunk, ESPMode::ThreadSafe> AbstractChunk = MakeShared<FWorldGridAbstractChunk, ESPMode::ThreadSafe>();
+	AbstractChunk->SourceVersions = SourceVersions;
+	AbstractChunk->Rect = Snapshot.GetChunk(Chunk)->Rect;
+
+	const FGridRect& Rect = AbstractChunk->Rect;
+
+	// each side walks its border in increasing X or Y, so the chunk on the other side finds exactly the same runs
+	struct FSide
+	{
+		FGridVector First;
+		FGridVector Step;
+		FGridVector Across;
+		int32 Length;
+	};
+	const FSide Sides[] =
+	{
+		{ FGridVector(Rect.Max.X - 1, Rect.Min.Y), FGridVector(0, 1), FGridVector(1, 0), Rect.Height() },
+		{ FGridVector(Rect.Min.X, Rect.Min.Y), FGridVector(0, 1), FGridVector(-1, 0), Rect.Height() },
+		{ FGridVector(Rect.Min.X, Rect.Max.Y - 1), FGridVector(1, 0), FGridVector(0, 1), Rect.Width() },
+		{ FGridVector(Rect.Min.X, Rect.Min.Y), FGridVector(1, 0), FGridVector(0, -1), Rect.Width() },
+	};
+
+	auto AddEntrance = [&](const FGridVector& Own, const FGridVector& Other)
+	{
+		int32 NodeIndex = AbstractChunk->FindNode(Own);
+		if (NodeIndex == INDEX_NONE)
+		{
+			NodeIndex = AbstractChunk->Nodes.Add(Own);
+			AbstractChunk->InterEdges.AddDefaulted();
+		}
+
+		const float TerrainCost = Costs.GetTerrainCost(Snapshot.GetTerrainTypeAtGridPosition(Other));
+		const float StepCost = FWorldGridPathfinder::GetStepCost(Snapshot, Costs, Own, Other, Snapshot.GetElevationAtGridPosition(Own), TerrainCost, false);
+		AbstractChunk->InterEdges[NodeIndex].Add({ Other, StepCost });
+	};
+
+	for (const FSide& Side : Sides)
+	{
+		if (!Snapshot.IsValidPosition(Side.First + Side.Across))
+		{
+			continue;
+		}
+
+		int32 RunStart = INDEX_NONE;
+		for (int32 Index = 0; Index <= Side.Length; ++Index)
+		{
+			bool bOpen = false;
+			if (Index < Side.Length)
+			{
+				const FGridVector Own(Side.First.X + (Side.Step.X * Index), Side.First.Y + (Side.Step.Y * Index));
+				const FGridVector Other = Own + Side.Across;
+				bOpen = IsWalkable(Snapshot, Costs, Own) && IsWalkable(Snapshot, Costs, Other)
+					&& (FMath::Abs(Snapshot.GetElevationAtGridPosition(Own) - Snapshot.GetElevationAtGridPosition(Other)) <= Costs.MaxElevationStep);
+			}
+
+			if (bOpen && (RunStart == INDEX_NONE))
+			{
+				RunStart = Index;
+			}
+			else if (!bOpen && (RunStart != INDEX_NONE))
+			{
+				const int32 RunLength = Index - RunStart;
+				const int32 RunEnd = Index - 1;
+
+				TArray<int32, TInlineAllocator<2>> EntranceIndices;
+				if (RunLength < LongEntranceLength)
+				{
+					EntranceIndices.Add(RunStart + (RunLength / 2));
+				}
+				else
+				{
+					EntranceIndices.Add(RunStart);
+					EntranceIndices.Add(RunEnd);
+				}
+
+				for (int32 EntranceIndex : EntranceIndices)
+				{
+					const FGridVector Own(Side.First.X + (Side.Step.X * EntranceIndex), Side.First.Y + (Side.Step.Y * EntranceIndex));
+					AddEntrance(Own, Own + Side.Across);
+				}
+
+				RunStart = INDEX_NONE;
+			}
+		}
+	}
+
+	// one flood per entrance gives its cost to every other entrance
+	const int32 NodeCount = AbstractChunk->Nodes.Num();
+	AbstractChunk->Distances.Init(-1.f, NodeCount * NodeCount);
+
+	TArray<float> FloodedCosts;
+	for (int32 FromIndex = 0; FromIndex < NodeCount; ++FromIndex)
+	{
+		Pathfinder.FloodCosts(Snapshot, AbstractChunk->Nodes[FromIndex], Costs, Rect, false, FloodedCosts);
+		for (int32 ToIndex = 0; ToIndex < NodeCount; ++ToIndex)
+		{
+			const FGridVector& To = AbstractChunk->Nodes[ToIndex];
+			AbstractChunk->Distances[(FromIndex * NodeCount) + ToIndex] = FloodedCosts[((To.Y - Rect.Min.Y) * Rect.Width()) + (To.X - Rect.Min.X)];
+		}
+	}
+
+	return AbstractChunk;
+}
+
+bool FWorldGridAbstractGraph::FindPath(const FWorldGridSnapshot& Snapshot, const FGridVector& Start, const FGridVector& Goal, FWorldGridPathfinder& Pathfinder, TArray<FGridVector>& OutPath) const
+{
+	OutPath.Reset();
+
+	if (!Snapshot.IsValidPosition(Start) || !Snapshot.IsValidPosition(Goal) || (Snapshot.GetWidth() != Width))
+	{
+		return false;
+	}
+
+	FWorldGridPathQuery LocalQuery;
+	LocalQuery.Costs = Costs;
+
+	// close by, a plain bounded search is cheaper than going through the abstraction
+	const FGridVector StartChunk(Start.X / GridChunkSize, Start.Y / GridChunkSize);
+	const FGridVector GoalChunk(Goal.X / GridChunkSize, Goal.Y / GridChunkSize);
+	if ((FMath::Abs(StartChunk.X - GoalChunk.X) <= 1) && (FMath::Abs(StartChunk.Y - GoalChunk.Y) <= 1))
+	{
+		LocalQuery.Start = Start;
+		LocalQuery.Goal = Goal;
+		LocalQuery.Bounds = FGridRect(
+			FGridVector((FMath::Min(StartChunk.X, GoalChunk.X) - 1) * GridChunkSize, (FMath::Min(StartChunk.Y, GoalChunk.Y) - 1) * GridChunkSize),
+			FGridVector((FMath::Max(StartChunk.X, GoalChunk.X) + 2) * GridChunkSize, (FMath::Max(StartChunk.Y, GoalChunk.Y) + 2) * GridChunkSize));
+
+		if (Pathfinder.FindPath(Snapshot, LocalQuery, OutPath))
+		{
+			return true;
+		}
+	}
+
+	const FWorldGridAbstractChunk& StartAbstractChunk = GetChunkAtGridPosition(Start);
+	const FWorldGridAbstractChunk& GoalAbstractChunk = GetChunkAtGridPosition(Goal);
+
+	// temporary edges from Start into its chunk's entrances and from the goal chunk's entrances to Goal
+	TArray<float> StartCosts;
+	TArray<float> GoalCosts;
+	Pathfinder.FloodCosts(Snapshot, Start, Costs, StartAbstractChunk.Rect, false, StartCosts);
+	Pathfinder.FloodCosts(Snapshot, Goal, Costs, GoalAbstractChunk.Rect, true, GoalCosts);
+
+	auto GetLocalCost = [](const TArray<float>& LocalCosts, const FGridRect& Rect, const FGridVector& Position)
+	{
+		return LocalCosts[((Position.Y - Rect.Min.Y) * Rect.Width()) + (Position.X - Rect.Min.X)];
+	};
+
+	const float MinTerrainCost = Costs.GetMinTerrainCost();
+	const int32 StartCell = (Start.Y * Width) + Start.X;
+	const int32 GoalCell = (Goal.Y * Width) + Goal.X;
+
+	TMap<int32, FAbstractSearchNode> SearchNodes;
+	TArray<FAbstractOpenNode> OpenHeap;
+
+	auto Relax = [&](int32 FromCell, const FGridVector& To, float EdgeCost)
+	{
+		const int32 ToCell = (To.Y * Width) + To.X;
+		FAbstractSearchNode& ToNode = SearchNodes.FindOrAdd(ToCell);
+		const float NewG = SearchNodes[FromCell].G + EdgeCost;
+		if (!ToNode.bClosed && (NewG < ToNode.G))
+		{
+			ToNode.G = NewG;
+			ToNode.Parent = FromCell;
+			OpenHeap.HeapPush({ NewG + Octile(To, Goal, MinTerrainCost), ToCell }, FAbstractOpenNodePredicate());
+		}
+	};
+
+	SearchNodes.Add(StartCell).G = 0.f;
+	OpenHeap.HeapPush({ Octile(Start, Goal, MinTerrainCost), StartCell }, FAbstractOpenNodePredicate());
+
+	bool bFound = false;
+	while (OpenHeap.Num() > 0)
+	{
+		FAbstractOpenNode Current;
+		OpenHeap.HeapPop(Current, FAbstractOpenNodePredicate(), false);
+
+		FAbstractSearchNode& CurrentNode = SearchNodes[Current.CellIndex];
+		if (CurrentNode.bClosed)
+		{
+			continue;
+		}
+		CurrentNode.bClosed = true;
+
+		if (Current.CellIndex == GoalCell)
+		{
+			bFound = true;
+			break;
+		}
+
+		const FGridVector Position(Current.CellIndex % Width, Current.CellIndex / Width);
+		const FWorldGridAbstractChunk& Chunk = GetChunkAtGridPosition(Position);
+
+		if (Current.CellIndex == StartCell)
+		{
+			for (const FGridVector& Node : Chunk.Nodes)
+			{
+				const float Cost = GetLocalCost(StartCosts, Chunk.Rect, Node);
+				if (Cost > 0.f)
+				{
+					Relax(Current.CellIndex, Node, Cost);
+				}
+			}
+		}
+
+		const int32 NodeIndex = Chunk.FindNode(Position);
+		if (NodeIndex != INDEX_NONE)
+		{
+			const int32 NodeCount = Chunk.Nodes.Num();
+			for (int32 ToIndex = 0; ToIndex < NodeCount; ++ToIndex)
+			{
+				const float Distance = Chunk.Distances[(NodeIndex * NodeCount) + ToIndex];
+				if ((ToIndex != NodeIndex) && (Distance >= 0.f))
+				{
+					Relax(Current.CellIndex, Chunk.Nodes[ToIndex], Distance);
+				}
+			}
+
+			for (const FWorldGridAbstractChunk::FInterEdge& Edge : Chunk.InterEdges[NodeIndex])
+			{
+				if (Edge.Cost >= 0.f)
+				{
+					Relax(Current.CellIndex, Edge.To, Edge.Cost);
+				}
+			}
+		}
+
+		if (&Chunk == &GoalAbstractChunk)
+		{
+			const float Cost = GetLocalCost(GoalCosts, Chunk.Rect, Position);
+			if (Cost >= 0.f)
+			{
+				Relax(Current.CellIndex, Goal, Cost);
+			}
+		}
+	}
+
+	if (!bFound)
+	{
+		return false;
+	}
+
+	TArray<FGridVector> Waypoints;
+	for (int32 Cell = GoalCell; Cell != INDEX_NONE; Cell = SearchNodes[Cell].Parent)
+	{
+		Waypoints.Add(FGridVector(Cell % Width, Cell / Width));
+	}
+	Algo::Reverse(Waypoints);
+
+	// refine each hop. hops inside a chunk get a search bounded to it, hops across a border are a single step
+	OutPath.Add(Start);
+	TArray<FGridVector> Segment;
+	for (int32 WaypointIndex = 1; WaypointIndex < Waypoints.Num(); ++WaypointIndex)
+	{
+		const FGridVector& From = Waypoints[WaypointIndex - 1];
+		const FGridVector& To = Waypoints[WaypointIndex];
+
+		const FWorldGridAbstractChunk& FromChunk = GetChunkAtGridPosition(From);
+		if (&FromChunk != &GetChunkAtGridPosition(To))
+		{
+			OutPath.Add(To);
+			continue;
+		}
+
+		LocalQuery.Start = From;
+		LocalQuery.Goal = To;
+		LocalQuery.Bounds = FromChunk.Rect;
+		if (!Pathfinder.FindPath(Snapshot, LocalQuery, Segment))
+		{
+			// the graph and snapshot disagree
+			OutPath.Reset();
+			return false;
+		}
+
+		OutPath.Append(Segment.GetData() + 1, Segment.Num() - 1);
+	}
+
+	return true;
+}
@@ -0,0 +1,83 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGridPathfinder.h"
+#include "WorldGridSnapshot.h"
+#include "WorldGridTypes.h"
+
+// the entrances of one chunk and what they cost to walk between. immutable once built, shared between graphs
+struct ANIMALEFFECT_API FWorldGridAbstractChunk
+{
+	struct FInterEdge
+	{
+		// the entrance cell on the other side of the border
+		FGridVector To;
+		float Cost;
+	};
+
+	// grid versions of this chunk and its east, west, south and north neighbours (-1 off the grid) it was built from
+	TArray<int32, TFixedAllocator<5>> SourceVersions;
+
+	FGridRect Rect;
+
+	// entrance cells of this chunk
+	TArray<FGridVector> Nodes;
+
+	// Nodes.Num() squared, [From * Nodes.Num() + To]. negative if To can't be reached from From without leaving the chunk
+	TArray<float> Distances;
+
+	// per node, the steps across the chunk border
+	TArray<TArray<FInterEdge, TInlineAllocator<2>>> InterEdges;
+
+	int32 FindNode(const FGridVector& Position) const;
+};
+
+using FWorldGridAbstractChunkPtr = TSharedPtr<const FWorldGridAbstractChunk, ESPMode::ThreadSafe>;
+
+/**
+ * HPA* abstraction of the grid, one FWorldGridAbstractChunk per snapshot chunk.
+ * - Entrances are placed on every run of walkable cells along a chunk border, one in the middle of short runs and one at each end of long ones.
+ * - Building from a previous graph only rebuilds chunks whose own or neighbouring grid versions moved, everything else is shared.
+ * - Queries search the entrances and then refine each hop with A* bounded to a single chunk.
+ * Like snapshots, a graph is immutable and can be searched from any thread.
+ */
+class ANIMALEFFECT_API FWorldGridAbstractGraph
+{
+public:
+
+	// rebuilds chunks in parallel. ChunkVersions are the grid's chunk versions over Costs.GetBlockingLayers() when Snapshot was taken,
+	// row-major by chunk, so writes to layers the costs don't care about never cause a rebuild
+	static TSharedRef<const FWorldGridAbstractGraph, ESPMode::ThreadSafe> Build(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const TArray<int32>& ChunkVersions, const FWorldGridAbstractGraph* PreviousGraph);
+
+	// Snapshot should be the one the graph was built from. Pathfinder is used for the local searches and refinement
+	bool FindPath(const FWorldGridSnapshot& Snapshot, const FGridVector& Start, const FGridVector& Goal, FWorldGridPathfinder& Pathfinder, TArray<FGridVector>& OutPath) const;
+
+	FORCEINLINE const FWorldGridPathCostConfig& GetCosts() const { return Costs; }
+
+	// how many chunks Build had to rebuild rather than share, for profiling
+	FORCEINLINE int32 GetRebuiltChunkCount() const { return RebuiltChunkCount; }
+
+private:
+
+	static FWorldGridAbstractChunkPtr BuildChunk(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const FGridVector& Chunk, const TArray<int32, TFixedAllocator<5>>& SourceVersions, FWorldGridPathfinder& Pathfinder);
+
+	static void GetSourceVersions(const TArray<int32>& ChunkVersions, int32 ChunkCountPerSide, const FGridVector& Chunk, TArray<int32, TFixedAllocator<5>>& OutVersions);
+
+	FORCEINLINE const FWorldGridAbstractChunk& GetChunkAtGridPosition(const FGridVector& Position) const
+	{
+		return *Chunks[((Position.Y / GridChunkSize) * ChunkCountPerSide) + (Position.X / GridChunkSize)];
+	}
+
+	int32 Width = 0;
+	int32 ChunkCountPerSide = 0;
+
+	FWorldGridPathCostConfig Costs;
+
+	TArray<FWorldGridAbstractChunkPtr> Chunks;
+
+	int32 RebuiltChunkCount = 0;
+
+};
+
+using FWorldGridAbstractGraphPtr = TSharedPtr<const FWorldGridAbstractGraph, ESPMode::ThreadSafe>;
@@ -0,0 +1,111 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGridTypes.h"
+
+#include "WorldGridCommands.generated.h"
+
+class UDigActualizer;
+
+UENUM()
+enum class EWorldGridCommandResult : uint8
+{
+	Applied,
+	// some part of the rect was off the grid. nothing was written
+	OutOfBounds,
+	// an actor, reservation or buried item was in the way. nothing was written
+	Conflict,
+	// the command itself was malformed
+	Invalid,
+};
+
+enum class EWorldGridCommandType : uint8
+{
+	SetTerrainRect,
+	SetElevationRect,
+	PlaceDigActualizer,
+	ReserveCells,
+	ReleaseCells,
+};
+
+// called on the game thread once the command has been applied (or rejected)
+using FWorldGridCommandCallback = TFunction<void(EWorldGridCommandResult)>;
+
+/**
+ * A grid mutation that can be built on any thread and handed to UWorldGridSubsystem::EnqueueCommand.
+ * Commands are applied in submission order on the game thread, once per frame after actors have ticked.
+ * Build them with the static constructors below.
+ */
+struct ANIMALEFFECT_API FWorldGridCommand
+{
+	EWorldGridCommandType Type = EWorldGridCommandType::SetTerrainRect;
+
+	FGridRect Rect;
+
+	ETerrainType TerrainType = ETerrainType::Sand;
+	int32 Elevation = 0;
+
+	TSoftObjectPtr<UDigActualizer> DigActualizer;
+
+	// if left invalid the game thread looks it up when the command is applied
+	FDigDetectionSummary DigSummary;
+
+	// writes to cells reserved with this token don't conflict. 0 is no token
+	int32 ReservationToken = 0;
+
+	FWorldGridCommandCallback OnApplied;
+
+	static FWorldGridCommand SetTerrainRect(const FGridRect& Rect, ETerrainType TerrainType, int32 ReservationToken = 0, FWorldGridCommandCallback OnApplied = nullptr)
+	{
+		FWorldGridCommand Command;
+		Command.Type = EWorldGridCommandType::SetTerrainRect;
+		Command.Rect = Rect;
+		Command.TerrainType = TerrainType;
+		Command.ReservationToken = ReservationToken;
+		Command.OnApplied = MoveTemp(OnApplied);
+		return Command;
+	}
+
+	static FWorldGridCommand SetElevationRect(const FGridRect& Rect, int32 Elevation, int32 ReservationToken = 0, FWorldGridCommandCallback OnApplied = nullptr)
+	{
+		FWorldGridCommand Command;
+		Command.Type = EWorldGridCommandType::SetElevationRect;
+		Command.Rect = Rect;
+		Command.Elevation = Elevation;
+		Command.ReservationToken = ReservationToken;
+		Command.OnApplied = MoveTemp(OnApplied);
+		return Command;
+	}
+
+	static FWorldGridCommand PlaceDigActualizer(const FGridVector& Position, const TSoftObjectPtr<UDigActualizer>& DigActualizer, const FDigDetectionSummary& DigSummary, FWorldGridCommandCallback OnApplied = nullptr)
+	{
+		FWorldGridCommand Command;
+		Command.Type = EWorldGridCommandType::PlaceDigActualizer;
+		Command.Rect = FGridRect(Position, FGridVector(Position.X + 1, Position.Y + 1));
+		Command.DigActualizer = DigActualizer;
+		Command.DigSummary = DigSummary;
+		Command.OnApplied = MoveTemp(OnApplied);
+		return Command;
+	}
+
+	static FWorldGridCommand ReserveCells(const FGridRect& Rect, int32 ReservationToken, FWorldGridCommandCallback OnApplied = nullptr)
+	{
+		FWorldGridCommand Command;
+		Command.Type = EWorldGridCommandType::ReserveCells;
+		Command.Rect = Rect;
+		Command.ReservationToken = ReservationToken;
+		Command.OnApplied = MoveTemp(OnApplied);
+		return Command;
+	}
+
+	static FWorldGridCommand ReleaseCells(const FGridRect& Rect, int32 ReservationToken, FWorldGridCommandCallback OnApplied = nullptr)
+	{
+		FWorldGridCommand Command;
+		Command.Type = EWorldGridCommandType::ReleaseCells;
+		Command.Rect = Rect;
+		Command.ReservationToken = ReservationToken;
+		Command.OnApplied = MoveTemp(OnApplied);
+		return Command;
+	}
+};
@@ -0,0 +1,121 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WorldGridFlowField.h"
+
+#include "Async/ParallelFor.h"
+
+// same order as the pathfinder, the first four are the straight neighbours
+const int32 FWorldGridFlowField::DirectionOffsetX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+const int32 FWorldGridFlowField::DirectionOffsetY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+TSharedRef<const FWorldGridFlowField, ESPMode::ThreadSafe> FWorldGridFlowField::Build(const FWorldGridSnapshot& Snapshot, const FGridVector& Target, const FWorldGridPathCostConfig& Costs, int64 SourceVersion, const TArray<int32>& ChunkVersions, FWorldGridPathfinder& Pathfinder)
+{
+	TSharedRef<FWorldGridFlowField, ESPMode::ThreadSafe> FlowField = MakeShared<FWorldGridFlowField, ESPMode::ThreadSafe>();
+	FlowField->Target = Target;
+	FlowField->Costs = Costs;
+	FlowField->SourceVersion = SourceVersion;
+	FlowField->Width = Snapshot.GetWidth();
+
+	const int32 Width = FlowField->Width;
+	const FGridRect GridRect(FGridVector(0, 0), FGridVector(Width));
+
+	// integration field. the cost of walking from every cell to Target
+	TArray<float> Integration;
+	Pathfinder.FloodCosts(Snapshot, Target, Costs, GridRect, true, Integration);
+
+	FlowField->Directions.Init(NoDirection, Width * Width);
+
+	// the field only depends on the chunks the flood reached, and the ring around them since a write there can open a new way in.
+	// the target's chunk always counts, it's what an unwalkable target waits on
+	const int32 ChunkCountPerSide = Snapshot.GetChunkCountPerSide();
+	TBitArray<> ReachedChunks(false, ChunkCountPerSide * ChunkCountPerSide);
+	ReachedChunks[((Target.Y / GridChunkSize) * ChunkCountPerSide) + (Target.X / GridChunkSize)] = true;
+	for (int32 CellIndex = 0; CellIndex < Integration.Num(); ++CellIndex)
+	{
+		if (Integration[CellIndex] >= 0.f)
+		{
+			ReachedChunks[(((CellIndex / Width) / GridChunkSize) * ChunkCountPerSide) + ((CellIndex % Width) / GridChunkSize)] = true;
+		}
+	}
+
+	check(ChunkVersions.Num() == ReachedChunks.Num());
+	FlowField->ChunkVersions.Init(INDEX_NONE, ChunkVersions.Num());
+	for (TConstSetBitIterator<> It(ReachedChunks); It; ++It)
+	{
+		const FGridVector Chunk(It.GetIndex() % ChunkCountPerSide, It.GetIndex() / ChunkCountPerSide);
+		for (int32 ChunkY = FMath::Max(Chunk.Y - 1, 0); ChunkY <= FMath::Min(Chunk.Y + 1, ChunkCountPerSide - 1); ++ChunkY)
+		{
+			for (int32 ChunkX = FMath::Max(Chunk.X - 1, 0); ChunkX <= FMath::Min(Chunk.X + 1, ChunkCountPerSide - 1); ++ChunkX)
+			{
+				const int32 ChunkIndex = (ChunkY * ChunkCountPerSide) + ChunkX;
+				FlowField->ChunkVersions[ChunkIndex] = ChunkVersions[ChunkIndex];
+			}
+		}
+	}
+
+	if (Integration.Num() == 0)
+	{
+		return FlowField;
+	}
+
+	// every cell is independent once the integration field is done, so rows go wide
+	const int32 DirectionCount = Costs.bAllowDiagonal ? 8 : 4;
+	ParallelFor(Width, [&](int32 Y)
+	{
+		for (int32 X = 0; X < Width; ++X)
+		{
+			const int32 CellIndex = (Y * Width) + X;
+			if ((Integration[CellIndex] < 0.f) || ((X == Target.X) && (Y == Target.Y)))
+			{
+				// the target itself, or unreachable
+				continue;
+			}
+
+			const FGridVector Position(X, Y);
+			const int32 Elevation = Snapshot.GetElevationAtGridPosition(Position);
+
+			float BestCost = MAX_flt;
+			for (int32 Direction = 0; Direction < DirectionCount; ++Direction)
+			{
+				const FGridVector Neighbour(X + DirectionOffsetX[Direction], Y + DirectionOffsetY[Direction]);
+				if (!GridRect.Contains(Neighbour))
+				{
+					continue;
+				}
+
+				const float NeighbourCost = Integration[(Neighbour.Y * Width) + Neighbour.X];
+				if (NeighbourCost < 0.f)
+				{
+					continue;
+				}
+
+				const float TerrainCost = Costs.GetTerrainCost(Snapshot.GetTerrainTypeAtGridPosition(Neighbour));
+				const float StepCost = FWorldGridPathfinder::GetStepCost(Snapshot, Costs, Position, Neighbour, Elevation, TerrainCost, Direction >= 4);
+				if ((StepCost >= 0.f) && ((NeighbourCost + StepCost) < BestCost))
+				{
+					BestCost = NeighbourCost + StepCost;
+					FlowField->Directions[CellIndex] = static_cast<uint8>(Direction);
+				}
+			}
+		}
+	});
+
+	return FlowField;
+}
+
+bool FWorldGridFlowField::IsCurrent(const TArray<int32>& CurrentChunkVersions) const
+{
+	if (CurrentChunkVersions.Num() != ChunkVersions.Num())
+	{
+		return false;
+	}
+
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkVersions.Num(); ++ChunkIndex)
+	{
+		if ((ChunkVersions[ChunkIndex] != INDEX_NONE) && (ChunkVersions[ChunkIndex] != CurrentChunkVersions[ChunkIndex]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
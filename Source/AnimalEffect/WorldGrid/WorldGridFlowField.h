@@ -0,0 +1,75 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGridPathfinder.h"
+#include "WorldGridSnapshot.h"
+#include "WorldGridTypes.h"
+
+/**
+ * Which way to step from every cell of the grid to reach one target, so any number of agents can share a single search.
+ * - Built from a reverse cost flood out of the target, then one pass that points every reached cell at its cheapest neighbour.
+ * - Only the directions are kept, a byte per cell.
+ * - Like snapshots, a field is immutable and can be read from any thread.
+ * Get one through UWorldGridPathfindingSubsystem::RequestFlowField, which caches them by target.
+ */
+class ANIMALEFFECT_API FWorldGridFlowField
+{
+public:
+
+	// SourceVersion is the grid's region version over Costs.GetBlockingLayers() when Snapshot was taken, and ChunkVersions the
+	// version of every chunk over the same layers, row by row
+	static TSharedRef<const FWorldGridFlowField, ESPMode::ThreadSafe> Build(const FWorldGridSnapshot& Snapshot, const FGridVector& Target, const FWorldGridPathCostConfig& Costs, int64 SourceVersion, const TArray<int32>& ChunkVersions, FWorldGridPathfinder& Pathfinder);
+
+	// false if any chunk the field depends on has been written since it was built. CurrentChunkVersions is laid out like Build's
+	bool IsCurrent(const TArray<int32>& CurrentChunkVersions) const;
+
+	// false at the target and on cells the target can't be reached from
+	FORCEINLINE bool GetNextStep(const FGridVector& Position, FGridVector& OutNextStep) const
+	{
+		if ((Position.X < 0) || (Position.X >= Width) || (Position.Y < 0) || (Position.Y >= Width))
+		{
+			return false;
+		}
+
+		const uint8 Direction = Directions[(Position.Y * Width) + Position.X];
+		if (Direction == NoDirection)
+		{
+			return false;
+		}
+
+		OutNextStep.Set(Position.X + DirectionOffsetX[Direction], Position.Y + DirectionOffsetY[Direction]);
+		return true;
+	}
+
+	FORCEINLINE bool CanReachTarget(const FGridVector& Position) const
+	{
+		FGridVector NextStep;
+		return ((Position.X == Target.X) && (Position.Y == Target.Y)) || GetNextStep(Position, NextStep);
+	}
+
+	FORCEINLINE const FGridVector& GetTarget() const { return Target; }
+	FORCEINLINE const FWorldGridPathCostConfig& GetCosts() const { return Costs; }
+	FORCEINLINE int64 GetSourceVersion() const { return SourceVersion; }
+
+private:
+
+	static constexpr uint8 NoDirection = MAX_uint8;
+
+	static const int32 DirectionOffsetX[8];
+	static const int32 DirectionOffsetY[8];
+
+	FGridVector Target;
+	FWorldGridPathCostConfig Costs;
+	int64 SourceVersion = 0;
+	int32 Width = 0;
+
+	// row-major over the grid, an index into DirectionOffsetX/Y or NoDirection
+	TArray<uint8> Directions;
+
+	// per chunk, the version it was built against or INDEX_NONE if nothing written there can change the field
+	TArray<int32> ChunkVersions;
+
+};
+
+using FWorldGridFlowFieldPtr = TSharedPtr<const FWorldGridFlowField, ESPMode::ThreadSafe>;
@@ -0,0 +1,305 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WorldGridGenerator.h"
+
+#include "WorldGridSubsystem.h"
+
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	// heights and noise are 16.16 fixed point in [0, One)
+	constexpr int32 One = 1 << 16;
+
+	FORCEINLINE int32 ToFixed(float Value)
+	{
+		return FMath::Clamp(FMath::RoundToInt(Value * One), 0, One);
+	}
+
+	// lowbias32 over the seed and lattice coordinates
+	FORCEINLINE uint32 Hash(int32 X, int32 Y, uint32 Seed)
+	{
+		uint32 H = (Seed * 0x9E3779B9u) ^ (static_cast<uint32>(X) * 0x85EBCA6Bu) ^ (static_cast<uint32>(Y) * 0xC2B2AE35u);
+		H ^= H >> 16;
+		H *= 0x7FEB352Du;
+		H ^= H >> 15;
+		H *= 0x846CA68Bu;
+		H ^= H >> 16;
+		return H;
+	}
+
+	FORCEINLINE int32 SmoothStep(int32 T)
+	{
+		return static_cast<int32>((((static_cast<int64>(T) * T) >> 16) * ((3 * One) - (2 * T))) >> 16);
+	}
+
+	FORCEINLINE int32 Lerp(int32 A, int32 B, int32 T)
+	{
+		return A + static_cast<int32>((static_cast<int64>(B - A) * T) >> 16);
+	}
+
+	// X and Y are never negative here
+	int32 ValueNoise(int32 X, int32 Y, int32 CellSize, uint32 Seed)
+	{
+		const int32 LatticeX = X / CellSize;
+		const int32 LatticeY = Y / CellSize;
+		const int32 FractionX = SmoothStep(((X % CellSize) << 16) / CellSize);
+		const int32 FractionY = SmoothStep(((Y % CellSize) << 16) / CellSize);
+
+		const int32 V00 = Hash(LatticeX, LatticeY, Seed) & 0xFFFF;
+		const int32 V10 = Hash(LatticeX + 1, LatticeY, Seed) & 0xFFFF;
+		const int32 V01 = Hash(LatticeX, LatticeY + 1, Seed) & 0xFFFF;
+		const int32 V11 = Hash(LatticeX + 1, LatticeY + 1, Seed) & 0xFFFF;
+
+		return Lerp(Lerp(V00, V10, FractionX), Lerp(V01, V11, FractionX), FractionY);
+	}
+
+	// octaves halve in size and weight down to two cells
+	int32 FractalNoise(int32 X, int32 Y, int32 FeatureSize, uint32 Seed)
+	{
+		int64 Sum = 0;
+		int64 TotalWeight = 0;
+		int32 Weight = 256;
+		for (int32 CellSize = FeatureSize; (CellSize >= 2) && (Weight > 0); CellSize /= 2, Weight /= 2)
+		{
+			Sum += static_cast<int64>(ValueNoise(X, Y, CellSize, Seed + CellSize)) * Weight;
+			TotalWeight += Weight;
+		}
+		return static_cast<int32>(Sum / FMath::Max<int64>(TotalWeight, 1));
+	}
+
+	constexpr int32 NeighbourOffsetX[4] = { 1, -1, 0, 0 };
+	constexpr int32 NeighbourOffsetY[4] = { 0, 0, 1, -1 };
+}
+
+void FWorldGridGenerator::Generate(const FWorldGridGeneratorConfig& Config, int32 Width, FWorldGridGeneratedLayers& OutLayers)
+{
+	const int32 CellCount = Width * Width;
+	OutLayers.Width = Width;
+	OutLayers.Elevation.SetNumUninitialized(CellCount);
+	OutLayers.TerrainType.SetNumUninitialized(CellCount);
+
+	TArray<int32> Heights;
+	Heights.SetNumUninitialized(CellCount);
+
+	const int32 ChunkCountPerSide = FMath::DivideAndRoundUp(Width, GridChunkSize);
+	auto GetChunkRect = [Width, ChunkCountPerSide](int32 ChunkIndex)
+	{
+		const FGridVector Min((ChunkIndex % ChunkCountPerSide) * GridChunkSize, (ChunkIndex / ChunkCountPerSide) * GridChunkSize);
+		return FGridRect(Min, FGridVector(FMath::Min(Min.X + GridChunkSize, Width), FMath::Min(Min.Y + GridChunkSize, Width)));
+	};
+
+	// every chunk only writes its own cells, so the order chunks run in can't change the result
+	ParallelFor(ChunkCountPerSide * ChunkCountPerSide, [&](int32 ChunkIndex)
+	{
+		GenerateChunk(Config, GetChunkRect(ChunkIndex), Width, Heights, OutLayers);
+	});
+
+	// erosion reads neighbours across chunk borders, so each pass reads a copy of the last one
+	TArray<int32> SourceElevation;
+	for (int32 Pass = 0; Pass < Config.ErosionPasses; ++Pass)
+	{
+		SourceElevation = OutLayers.Elevation;
+		ParallelFor(ChunkCountPerSide * ChunkCountPerSide, [&](int32 ChunkIndex)
+		{
+			ErodeChunk(GetChunkRect(ChunkIndex), Width, SourceElevation, OutLayers);
+		});
+	}
+
+	CarveRivers(Config, Width, Heights, OutLayers);
+}
+
+void FWorldGridGenerator::GenerateChunk(const FWorldGridGeneratorConfig& Config, const FGridRect& Rect, int32 Width, TArray<int32>& Heights, FWorldGridGeneratedLayers& OutLayers)
+{
+	const uint32 Seed = static_cast<uint32>(Config.Seed);
+	const int32 FeatureSize = FMath::Max(Config.FeatureSize, 2);
+	const int32 SeaLevel = ToFixed(Config.SeaLevel);
+	const int32 BeachHeight = ToFixed(Config.BeachHeight);
+	const int32 RockThreshold = ToFixed(Config.RockThreshold);
+	const int32 PlateauCount = FMath::Max(Config.PlateauCount, 0);
+
+	const int32 Center = Width / 2;
+	const int64 MaxDistanceSquared = FMath::Max<int64>(static_cast<int64>(Center) * Center, 1);
+
+	for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; ++Y)
+	{
+		for (int32 X = Rect.Min.X; X < Rect.Max.X; ++X)
+		{
+			const int32 Index = (Y * Width) + X;
+
+			// land in the middle, sea at the edges
+			const int64 DeltaX = X - Center;
+			const int64 DeltaY = Y - Center;
+			const int32 Falloff = static_cast<int32>(FMath::Min<int64>((((DeltaX * DeltaX) + (DeltaY * DeltaY)) << 16) / MaxDistanceSquared, One));
+			const int32 Height = FMath::Clamp(((FractalNoise(X, Y, FeatureSize, Seed) * 3) + ((One - Falloff) * 5)) >> 3, 0, One - 1);
+			Heights[Index] = Height;
+
+			if (Height < SeaLevel)
+			{
+				OutLayers.Elevation[Index] = 0;
+				OutLayers.TerrainType[Index] = ETerrainType::Water;
+				continue;
+			}
+
+			const int32 AboveSea = Height - SeaLevel;
+			if (AboveSea < BeachHeight)
+			{
+				OutLayers.Elevation[Index] = 0;
+				OutLayers.TerrainType[Index] = ETerrainType::Sand;
+				continue;
+			}
+
+			// lowland is level 0, then PlateauCount bands of equal height above it
+			const int32 InlandRange = FMath::Max((One - SeaLevel) - BeachHeight, 1);
+			const int32 Level = FMath::Min(static_cast<int32>((static_cast<int64>(AboveSea - BeachHeight) * (PlateauCount + 1)) / InlandRange), PlateauCount);
+			OutLayers.Elevation[Index] = Level;
+
+			const bool bRock = (PlateauCount > 0) && (Level == PlateauCount) && (ValueNoise(X, Y, FMath::Max(FeatureSize / 4, 2), Seed ^ 0x5EED) > RockThreshold);
+			OutLayers.TerrainType[Index] = bRock ? ETerrainType::Rock : ETerrainType::Dirt;
+		}
+	}
+}
+
+void FWorldGridGenerator::ErodeChunk(const FGridRect& Rect, int32 Width, const TArray<int32>& SourceElevation, FWorldGridGeneratedLayers& OutLayers)
+{
+	for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; ++Y)
+	{
+		for (int32 X = Rect.Min.X; X < Rect.Max.X; ++X)
+		{
+			const int32 Index = (Y * Width) + X;
+			const int32 Elevation = SourceElevation[Index];
+			if (Elevation == 0)
+			{
+				continue;
+			}
+
+			// a raised cell needs at least two raised neighbours to stay, anything less is a spike nobody can walk around
+			int32 SupportCount = 0;
+			int32 HighestLower = 0;
+			for (int32 NeighbourIndex = 0; NeighbourIndex < 4; ++NeighbourIndex)
+			{
+				const int32 NeighbourX = X + NeighbourOffsetX[NeighbourIndex];
+				const int32 NeighbourY = Y + NeighbourOffsetY[NeighbourIndex];
+				if ((NeighbourX < 0) || (NeighbourX >= Width) || (NeighbourY < 0) || (NeighbourY >= Width))
+				{
+					continue;
+				}
+
+				const int32 NeighbourElevation = SourceElevation[(NeighbourY * Width) + NeighbourX];
+				if (NeighbourElevation >= Elevation)
+				{
+					++SupportCount;
+				}
+				else
+				{
+					HighestLower = FMath::Max(HighestLower, NeighbourElevation);
+				}
+			}
+
+			if (SupportCount < 2)
+			{
+				OutLayers.Elevation[Index] = HighestLower;
+				if (OutLayers.TerrainType[Index] == ETerrainType::Rock)
+				{
+					OutLayers.TerrainType[Index] = ETerrainType::Dirt;
+				}
+			}
+		}
+	}
+}
+
+void FWorldGridGenerator::CarveRivers(const FWorldGridGeneratorConfig& Config, int32 Width, const TArray<int32>& Heights, FWorldGridGeneratedLayers& OutLayers)
+{
+	const int32 TopLevel = FMath::Max(Config.PlateauCount, 0);
+
+	// a river that can't find a source after this many tries is skipped
+	constexpr int32 SourceAttempts = 64;
+
+	for (int32 RiverIndex = 0; RiverIndex < Config.RiverCount; ++RiverIndex)
+	{
+		FGridVector Source;
+		for (int32 Attempt = 0; Attempt < SourceAttempts; ++Attempt)
+		{
+			const uint32 H = Hash(RiverIndex, Attempt, static_cast<uint32>(Config.Seed) ^ 0x817E5u);
+			const FGridVector Candidate((H & 0xFFFF) % Width, (H >> 16) % Width);
+			const int32 Index = (Candidate.Y * Width) + Candidate.X;
+			if ((OutLayers.Elevation[Index] == TopLevel) && (OutLayers.TerrainType[Index] != ETerrainType::Water))
+			{
+				Source = Candidate;
+				break;
+			}
+		}
+
+		if (!Source.IsValid())
+		{
+			continue;
+		}
+
+		// steepest descent on the raw heights. ties go to the first neighbour in order, which keeps it deterministic
+		FGridVector Current = Source;
+		for (int32 Step = 0; Step < (Width * 2); ++Step)
+		{
+			const int32 CurrentIndex = (Current.Y * Width) + Current.X;
+			if ((Step > 0) && (OutLayers.TerrainType[CurrentIndex] == ETerrainType::Water))
+			{
+				// reached the sea or another river
+				break;
+			}
+			OutLayers.TerrainType[CurrentIndex] = ETerrainType::Water;
+
+			int32 LowestHeight = MAX_int32;
+			FGridVector Next;
+			for (int32 NeighbourIndex = 0; NeighbourIndex < 4; ++NeighbourIndex)
+			{
+				const FGridVector Neighbour(Current.X + NeighbourOffsetX[NeighbourIndex], Current.Y + NeighbourOffsetY[NeighbourIndex]);
+				if ((Neighbour.X < 0) || (Neighbour.X >= Width) || (Neighbour.Y < 0) || (Neighbour.Y >= Width))
+				{
+					continue;
+				}
+
+				const int32 NeighbourIndexInGrid = (Neighbour.Y * Width) + Neighbour.X;
+				const int32 NeighbourHeight = Heights[NeighbourIndexInGrid];
+				if ((NeighbourHeight < LowestHeight) && (OutLayers.TerrainType[NeighbourIndexInGrid] != ETerrainType::Water || NeighbourHeight < Heights[CurrentIndex]))
+				{
+					LowestHeight = NeighbourHeight;
+					Next = Neighbour;
+				}
+			}
+
+			// a pit, the river ends in a pond
+			if (!Next.IsValid() || (LowestHeight > Heights[CurrentIndex]))
+			{
+				break;
+			}
+
+			Current = Next;
+		}
+	}
+}
+
+namespace
+{
+	void GenerateIslandCommand(const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr)
+		{
+			return;
+		}
+
+		UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(World);
+		FWorldGridGeneratorConfig Settings = WorldGrid->GetConfig().Generator;
+		if (Args.Num() > 0)
+		{
+			Settings.Seed = FCString::Atoi(*Args[0]);
+		}
+
+		WorldGrid->GenerateIsland(Settings);
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs GenerateIslandConsoleCommand(
+		TEXT("AE.Grid.Generate"),
+		TEXT("Replaces the current world grid's terrain and elevation with a generated island. Usage: AE.Grid.Generate [Seed]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&GenerateIslandCommand));
+}
@@ -0,0 +1,37 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGridTypes.h"
+
+// row-major, Width * Width cells, ready for UWorldGridSubsystem::ImportLayers
+struct ANIMALEFFECT_API FWorldGridGeneratedLayers
+{
+	int32 Width = 0;
+	TArray<int32> Elevation;
+	TArray<ETerrainType> TerrainType;
+};
+
+/**
+ * Procedural islands.
+ * - Heights are fractal value noise pulled down towards the grid's edges, then cut into sea, beach, lowland and plateaus.
+ * - Erosion passes flatten plateau cells sticking out on their own, rivers run downhill from the highest plateau to the sea.
+ * - Everything is integer math on hashed lattice values, so a seed gives bit-identical output on every platform and run.
+ * - Noise, banding and erosion run per chunk with ParallelFor. Rivers are serial, there are only a few of them.
+ * Doesn't touch the grid, so it can run on any thread.
+ */
+class ANIMALEFFECT_API FWorldGridGenerator
+{
+public:
+
+	static void Generate(const FWorldGridGeneratorConfig& Config, int32 Width, FWorldGridGeneratedLayers& OutLayers);
+
+private:
+
+	static void GenerateChunk(const FWorldGridGeneratorConfig& Config, const FGridRect& Rect, int32 Width, TArray<int32>& Heights, FWorldGridGeneratedLayers& OutLayers);
+
+	static void ErodeChunk(const FGridRect& Rect, int32 Width, const TArray<int32>& SourceElevation, FWorldGridGeneratedLayers& OutLayers);
+
+	static void CarveRivers(const FWorldGridGeneratorConfig& Config, int32 Width, const TArray<int32>& Heights, FWorldGridGeneratedLayers& OutLayers);
+
+};
@@ -0,0 +1,292 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WorldGridPathfinder.h"
+
+#include "Algo/Reverse.h"
+
+namespace
+{
+	constexpr float DiagonalStepLength = 1.41421356f;
+
+	constexpr int32 NeighbourCount = 8;
+
+	// the first four are the straight neighbours
+	constexpr int32 NeighbourOffsetX[NeighbourCount] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	constexpr int32 NeighbourOffsetY[NeighbourCount] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+	FORCEINLINE bool IsBlocked(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const FGridVector& Position)
+	{
+		return Costs.bReservationsBlock ? Snapshot.IsOccupied(Position) : Snapshot.HasActor(Position);
+	}
+}
+
+void FWorldGridPathfinder::PrepareForQuery(int32 CellCount)
+{
+	// cells are indexed relative to the query bounds, so the arrays only ever need to be as big as the biggest bounds searched
+	if (OpenGeneration.Num() < CellCount)
+	{
+		OpenGeneration.Init(0, CellCount);
+		ClosedGeneration.Init(0, CellCount);
+		G.SetNumUninitialized(CellCount);
+		Parent.SetNumUninitialized(CellCount);
+		Generation = 0;
+	}
+
+	// only clear when the stamp wraps around, every ~4 billion queries
+	if (++Generation == 0)
+	{
+		FMemory::Memzero(OpenGeneration.GetData(), OpenGeneration.Num() * sizeof(uint32));
+		FMemory::Memzero(ClosedGeneration.GetData(), ClosedGeneration.Num() * sizeof(uint32));
+		Generation = 1;
+	}
+
+	OpenHeap.Reset();
+	LastExpandedNodeCount = 0;
+}
+
+float FWorldGridPathfinder::Heuristic(int32 X, int32 Y, const FGridVector& Goal, float MinTerrainCost, bool bAllowDiagonal) const
+{
+	const int32 DeltaX = FMath::Abs(X - Goal.X);
+	const int32 DeltaY = FMath::Abs(Y - Goal.Y);
+
+	if (!bAllowDiagonal)
+	{
+		return (DeltaX + DeltaY) * MinTerrainCost;
+	}
+
+	// octile distance
+	const int32 Straight = FMath::Abs(DeltaX - DeltaY);
+	const int32 Diagonal = FMath::Min(DeltaX, DeltaY);
+	return (Straight + (Diagonal * DiagonalStepLength)) * MinTerrainCost;
+}
+
+float FWorldGridPathfinder::GetStepCost(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const FGridVector& From, const FGridVector& To, int32 FromElevation, float ToTerrainCost, bool bDiagonal)
+{
+	const int32 ElevationStep = FMath::Abs(Snapshot.GetElevationAtGridPosition(To) - FromElevation);
+	if (ElevationStep > Costs.MaxElevationStep)
+	{
+		return -1.f;
+	}
+
+	if (bDiagonal)
+	{
+		// no cutting corners past a blocked straight neighbour
+		const FGridVector SideA(To.X, From.Y);
+		const FGridVector SideB(From.X, To.Y);
+		if (IsBlocked(Snapshot, Costs, SideA) || IsBlocked(Snapshot, Costs, SideB)
+			|| (Costs.GetTerrainCost(Snapshot.GetTerrainTypeAtGridPosition(SideA)) < 0.f)
+			|| (Costs.GetTerrainCost(Snapshot.GetTerrainTypeAtGridPosition(SideB)) < 0.f))
+		{
+			return -1.f;
+		}
+	}
+
+	return ((bDiagonal ? DiagonalStepLength : 1.f) * ToTerrainCost) + (ElevationStep * Costs.ElevationStepCost);
+}
+
+void FWorldGridPathfinder::FloodCosts(const FWorldGridSnapshot& Snapshot, const FGridVector& Source, const FWorldGridPathCostConfig& Costs, const FGridRect& InBounds, bool bReverse, TArray<float>& OutCosts)
+{
+	const FGridRect Bounds = InBounds.Intersection(FGridRect(FGridVector(0, 0), FGridVector(Snapshot.GetWidth())));
+	const int32 BoundsWidth = Bounds.Width();
+	const int32 CellCount = Bounds.IsEmpty() ? 0 : (BoundsWidth * Bounds.Height());
+
+	OutCosts.Init(-1.f, CellCount);
+	if (!Bounds.Contains(Source))
+	{
+		return;
+	}
+
+	PrepareForQuery(CellCount);
+
+	const int32 NeighboursToVisit = Costs.bAllowDiagonal ? NeighbourCount : 4;
+	const int32 SourceIndex = ((Source.Y - Bounds.Min.Y) * BoundsWidth) + (Source.X - Bounds.Min.X);
+
+	OpenGeneration[SourceIndex] = Generation;
+	G[SourceIndex] = 0.f;
+	OpenHeap.HeapPush({ 0.f, SourceIndex }, FOpenNodePredicate());
+
+	while (OpenHeap.Num() > 0)
+	{
+		FOpenNode Current;
+		OpenHeap.HeapPop(Current, FOpenNodePredicate(), false);
+
+		if (ClosedGeneration[Current.CellIndex] == Generation)
+		{
+			continue;
+		}
+		ClosedGeneration[Current.CellIndex] = Generation;
+		OutCosts[Current.CellIndex] = G[Current.CellIndex];
+		++LastExpandedNodeCount;
+
+		const FGridVector CurrentPosition(Bounds.Min.X + (Current.CellIndex % BoundsWidth), Bounds.Min.Y + (Current.CellIndex / BoundsWidth));
+		const int32 CurrentElevation = Snapshot.GetElevationAtGridPosition(CurrentPosition);
+		const float CurrentTerrainCost = Costs.GetTerrainCost(Snapshot.GetTerrainTypeAtGridPosition(CurrentPosition));
+
+		for (int32 NeighbourIndex = 0; NeighbourIndex < NeighboursToVisit; ++NeighbourIndex)
+		{
+			const FGridVector NextPosition(CurrentPosition.X + NeighbourOffsetX[NeighbourIndex], CurrentPosition.Y + NeighbourOffsetY[NeighbourIndex]);
+			if (!Bounds.Contains(NextPosition))
+			{
+				continue;
+			}
+
+			const int32 NextIndex = ((NextPosition.Y - Bounds.Min.Y) * BoundsWidth) + (NextPosition.X - Bounds.Min.X);
+			if ((ClosedGeneration[NextIndex] == Generation) || IsBlocked(Snapshot, Costs, NextPosition))
+			{
+				continue;
+			}
+
+			const float NextTerrainCost = Costs.GetTerrainCost(Snapshot.GetTerrainTypeAtGridPosition(NextPosition));
+			if (NextTerrainCost < 0.f)
+			{
+				continue;
+			}
+
+			// in reverse we're walking back from the source, so the step is paid as if moving from Next onto Current
+			const float StepCost = bReverse
+				? GetStepCost(Snapshot, Costs, NextPosition, CurrentPosition, Snapshot.GetElevationAtGridPosition(NextPosition), CurrentTerrainCost, NeighbourIndex >= 4)
+				: GetStepCost(Snapshot, Costs, CurrentPosition, NextPosition, CurrentElevation, NextTerrainCost, NeighbourIndex >= 4);
+			if (StepCost < 0.f)
+			{
+				continue;
+			}
+
+			const float NextG = G[Current.CellIndex] + StepCost;
+			if ((OpenGeneration[NextIndex] == Generation) && (G[NextIndex] <= NextG))
+			{
+				continue;
+			}
+
+			OpenGeneration[NextIndex] = Generation;
+			G[NextIndex] = NextG;
+			OpenHeap.HeapPush({ NextG, NextIndex }, FOpenNodePredicate());
+		}
+	}
+}
+
+bool FWorldGridPathfinder::FindPath(const FWorldGridSnapshot& Snapshot, const FWorldGridPathQuery& Query, TArray<FGridVector>& OutPath)
+{
+	OutPath.Reset();
+
+	const int32 Width = Snapshot.GetWidth();
+	const FGridRect GridRect(FGridVector(0, 0), FGridVector(Width));
+	const FGridRect Bounds = Query.Bounds.IsEmpty() ? GridRect : Query.Bounds.Intersection(GridRect);
+
+	if (!Bounds.Contains(Query.Start) || !Bounds.Contains(Query.Goal))
+	{
+		return false;
+	}
+
+	if ((Query.Start.X == Query.Goal.X) && (Query.Start.Y == Query.Goal.Y))
+	{
+		LastPathCost = 0.f;
+		OutPath.Add(Query.Start);
+		return true;
+	}
+
+	if (Query.Costs.GetTerrainCost(Snapshot.GetTerrainTypeAtGridPosition(Query.Goal)) < 0.f)
+	{
+		return false;
+	}
+
+	const int32 BoundsWidth = Bounds.Width();
+	PrepareForQuery(BoundsWidth * Bounds.Height());
+
+	const FWorldGridPathCostConfig& Costs = Query.Costs;
+	const float MinTerrainCost = Costs.GetMinTerrainCost();
+	const int32 NeighboursToVisit = Costs.bAllowDiagonal ? NeighbourCount : 4;
+	const int32 StartIndex = ((Query.Start.Y - Bounds.Min.Y) * BoundsWidth) + (Query.Start.X - Bounds.Min.X);
+	const int32 GoalIndex = ((Query.Goal.Y - Bounds.Min.Y) * BoundsWidth) + (Query.Goal.X - Bounds.Min.X);
+
+	OpenGeneration[StartIndex] = Generation;
+	G[StartIndex] = 0.f;
+	Parent[StartIndex] = INDEX_NONE;
+	OpenHeap.HeapPush({ Heuristic(Query.Start.X, Query.Start.Y, Query.Goal, MinTerrainCost, Costs.bAllowDiagonal), StartIndex }, FOpenNodePredicate());
+
+	bool bFound = false;
+	while (OpenHeap.Num() > 0)
+	{
+		FOpenNode Current;
+		OpenHeap.HeapPop(Current, FOpenNodePredicate(), false);
+
+		// stale entry for a cell we've since reached more cheaply
+		if (ClosedGeneration[Current.CellIndex] == Generation)
+		{
+			continue;
+		}
+		ClosedGeneration[Current.CellIndex] = Generation;
+
+		if (Current.CellIndex == GoalIndex)
+		{
+			bFound = true;
+			break;
+		}
+
+		++LastExpandedNodeCount;
+		if ((Query.MaxExpandedNodes > 0) && (LastExpandedNodeCount > Query.MaxExpandedNodes))
+		{
+			break;
+		}
+
+		const FGridVector CurrentPosition(Bounds.Min.X + (Current.CellIndex % BoundsWidth), Bounds.Min.Y + (Current.CellIndex / BoundsWidth));
+		const int32 CurrentElevation = Snapshot.GetElevationAtGridPosition(CurrentPosition);
+
+		for (int32 NeighbourIndex = 0; NeighbourIndex < NeighboursToVisit; ++NeighbourIndex)
+		{
+			const FGridVector NextPosition(CurrentPosition.X + NeighbourOffsetX[NeighbourIndex], CurrentPosition.Y + NeighbourOffsetY[NeighbourIndex]);
+			if (!Bounds.Contains(NextPosition))
+			{
+				continue;
+			}
+
+			const int32 NextIndex = ((NextPosition.Y - Bounds.Min.Y) * BoundsWidth) + (NextPosition.X - Bounds.Min.X);
+			if (ClosedGeneration[NextIndex] == Generation)
+			{
+				continue;
+			}
+
+			if ((NextIndex != GoalIndex) && IsBlocked(Snapshot, Query.Costs, NextPosition))
+			{
+				continue;
+			}
+
+			const float TerrainCost = Costs.GetTerrainCost(Snapshot.GetTerrainTypeAtGridPosition(NextPosition));
+			if (TerrainCost < 0.f)
+			{
+				continue;
+			}
+
+			const float StepCost = GetStepCost(Snapshot, Costs, CurrentPosition, NextPosition, CurrentElevation, TerrainCost, NeighbourIndex >= 4);
+			if (StepCost < 0.f)
+			{
+				continue;
+			}
+
+			const float NextG = G[Current.CellIndex] + StepCost;
+
+			if ((OpenGeneration[NextIndex] == Generation) && (G[NextIndex] <= NextG))
+			{
+				continue;
+			}
+
+			OpenGeneration[NextIndex] = Generation;
+			G[NextIndex] = NextG;
+			Parent[NextIndex] = Current.CellIndex;
+			OpenHeap.HeapPush({ NextG + Heuristic(NextPosition.X, NextPosition.Y, Query.Goal, MinTerrainCost, Costs.bAllowDiagonal), NextIndex }, FOpenNodePredicate());
+		}
+	}
+
+	if (!bFound)
+	{
+		return false;
+	}
+
+	LastPathCost = G[GoalIndex];
+	for (int32 CellIndex = GoalIndex; CellIndex != INDEX_NONE; CellIndex = Parent[CellIndex])
+	{
+		OutPath.Add(FGridVector(Bounds.Min.X + (CellIndex % BoundsWidth), Bounds.Min.Y + (CellIndex / BoundsWidth)));
+	}
+	Algo::Reverse(OutPath);
+
+	return true;
+}
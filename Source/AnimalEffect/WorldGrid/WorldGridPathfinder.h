@@ -0,0 +1,82 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGridSnapshot.h"
+#include "WorldGridTypes.h"
+
+struct ANIMALEFFECT_API FWorldGridPathQuery
+{
+	FGridVector Start;
+	FGridVector Goal;
+
+	FWorldGridPathCostConfig Costs;
+
+	// the search never leaves these cells. empty means the whole grid
+	FGridRect Bounds;
+
+	// give up after expanding this many cells. 0 is no limit
+	int32 MaxExpandedNodes = 0;
+};
+
+/**
+ * A* over a grid snapshot, so it can run on any thread.
+ * - The open list is a binary heap, nodes are never removed from it early, stale entries are skipped when popped.
+ * - Per-cell state is stamped with a query generation so nothing is cleared between queries.
+ * - Per-cell state is indexed relative to the query bounds, so small bounded searches only need small arrays.
+ * - Occupied cells are impassable, except Start and Goal.
+ * An instance keeps its per-cell arrays between queries, so reuse one per thread rather than making one per query.
+ * It is not safe to use one instance from two threads at once.
+ */
+class ANIMALEFFECT_API FWorldGridPathfinder
+{
+public:
+
+	// OutPath goes from Start to Goal inclusive. returns false if there's no path (within Bounds/MaxExpandedNodes)
+	bool FindPath(const FWorldGridSnapshot& Snapshot, const FWorldGridPathQuery& Query, TArray<FGridVector>& OutPath);
+
+	// Dijkstra from Source over Bounds. OutCosts is row-major over Bounds, negative for cells that can't be reached.
+	// with bReverse the costs are of walking from each cell to Source instead of from Source to each cell
+	void FloodCosts(const FWorldGridSnapshot& Snapshot, const FGridVector& Source, const FWorldGridPathCostConfig& Costs, const FGridRect& Bounds, bool bReverse, TArray<float>& OutCosts);
+
+	// nodes expanded by the last query, for profiling
+	FORCEINLINE int32 GetLastExpandedNodeCount() const { return LastExpandedNodeCount; }
+
+	// cost of the path found by the last successful FindPath
+	FORCEINLINE float GetLastPathCost() const { return LastPathCost; }
+
+	// cost of stepping From onto its neighbour To, negative if the step isn't allowed. doesn't check To's occupancy or terrain
+	static float GetStepCost(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const FGridVector& From, const FGridVector& To, int32 FromElevation, float ToTerrainCost, bool bDiagonal);
+
+private:
+
+	struct FOpenNode
+	{
+		float F;
+		int32 CellIndex;
+	};
+
+	struct FOpenNodePredicate
+	{
+		FORCEINLINE bool operator()(const FOpenNode& A, const FOpenNode& B) const { return A.F < B.F; }
+	};
+
+	void PrepareForQuery(int32 CellCount);
+
+	float Heuristic(int32 X, int32 Y, const FGridVector& Goal, float MinTerrainCost, bool bAllowDiagonal) const;
+
+	uint32 Generation = 0;
+
+	// a cell's G and Parent are only meaningful if its OpenGeneration matches Generation
+	TArray<uint32> OpenGeneration;
+	TArray<uint32> ClosedGeneration;
+	TArray<float> G;
+	TArray<int32> Parent;
+
+	TArray<FOpenNode> OpenHeap;
+
+	int32 LastExpandedNodeCount = 0;
+
+	float LastPathCost = 0.f;
+
+};
@@ -0,0 +1,437 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WorldGridPathfindingSubsystem.h"
+
+#include "WorldGridSubsystem.h"
+
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogWorldGridPathfinding, Log, All);
+
+namespace
+{
+	// each field is a byte per grid cell
+	constexpr int32 MaxCachedFlowFields = 32;
+}
+
+// shared with in-flight queries so a query finishing after the world is torn down still has somewhere to return its pathfinder
+class FWorldGridPathfinderPool
+{
+public:
+
+	TUniquePtr<FWorldGridPathfinder> Acquire()
+	{
+		FScopeLock Lock(&CriticalSection);
+		return (FreePathfinders.Num() > 0) ? FreePathfinders.Pop(false) : MakeUnique<FWorldGridPathfinder>();
+	}
+
+	void Release(TUniquePtr<FWorldGridPathfinder>&& Pathfinder)
+	{
+		FScopeLock Lock(&CriticalSection);
+		FreePathfinders.Add(MoveTemp(Pathfinder));
+	}
+
+private:
+
+	FCriticalSection CriticalSection;
+	TArray<TUniquePtr<FWorldGridPathfinder>> FreePathfinders;
+
+};
+
+UWorldGridPathfindingSubsystem* UWorldGridPathfindingSubsystem::Get(const UObject* WorldContextObject)
+{
+	auto PathfindingSubsystem = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::Assert)->GetSubsystem<UWorldGridPathfindingSubsystem>();
+	check(PathfindingSubsystem);
+	return PathfindingSubsystem;
+}
+
+void UWorldGridPathfindingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Collection.InitializeDependency(UWorldGridSubsystem::StaticClass());
+
+	Super::Initialize(Collection);
+
+	PathfinderPool = MakeShared<FWorldGridPathfinderPool, ESPMode::ThreadSafe>();
+
+	// label the whole grid now, after that only the chunks that change
+	UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(this);
+	const FWorldGridPathCostConfig Costs = GetCachedSearchCosts();
+	Reachability.Update(*WorldGrid->GetSnapshot(), Costs, TArray<int32>());
+
+	const FGridRect GridRect(FGridVector(0, 0), FGridVector(WorldGrid->GetConfig().Width));
+	GridChangedHandle = WorldGrid->Subscribe(GridRect, Costs.GetBlockingLayers(), FOnWorldGridChanged::CreateUObject(this, &UWorldGridPathfindingSubsystem::OnGridChanged));
+}
+
+void UWorldGridPathfindingSubsystem::Deinitialize()
+{
+	UWorldGridSubsystem::Get(this)->Unsubscribe(GridChangedHandle);
+	Reachability.Reset();
+
+	PathfinderPool.Reset();
+	AbstractGraph.Reset();
+	AbstractGraphSnapshot.Reset();
+	FlowFields.Empty();
+
+	Super::Deinitialize();
+}
+
+FWorldGridPathQuery UWorldGridPathfindingSubsystem::MakeQuery(const FGridVector& Start, const FGridVector& Goal) const
+{
+	FWorldGridPathQuery Query;
+	Query.Start = Start;
+	Query.Goal = Goal;
+	Query.Costs = UWorldGridSubsystem::Get(this)->GetConfig().PathCosts;
+	return Query;
+}
+
+bool UWorldGridPathfindingSubsystem::FindPath(const FWorldGridPathQuery& Query, TArray<FGridVector>& OutPath)
+{
+	FWorldGridSnapshotPtr Snapshot = UWorldGridSubsystem::Get(this)->GetSnapshot();
+
+	TUniquePtr<FWorldGridPathfinder> Pathfinder = PathfinderPool->Acquire();
+	const bool bFound = Pathfinder->FindPath(*Snapshot, Query, OutPath);
+	PathfinderPool->Release(MoveTemp(Pathfinder));
+
+	return bFound;
+}
+
+void UWorldGridPathfindingSubsystem::FindPathAsync(const FWorldGridPathQuery& Query, FOnWorldGridPathFound OnPathFound)
+{
+	FWorldGridSnapshotPtr Snapshot = UWorldGridSubsystem::Get(this)->GetSnapshot();
+	TSharedPtr<FWorldGridPathfinderPool, ESPMode::ThreadSafe> Pool = PathfinderPool;
+	TWeakObjectPtr<UWorldGridPathfindingSubsystem> WeakThis(this);
+
+	Async(EAsyncExecution::ThreadPool, [Snapshot, Pool, Query, WeakThis, OnPathFound]()
+	{
+		TUniquePtr<FWorldGridPathfinder> Pathfinder = Pool->Acquire();
+
+		TArray<FGridVector> Path;
+		const bool bFound = Pathfinder->FindPath(*Snapshot, Query, Path);
+
+		Pool->Release(MoveTemp(Pathfinder));
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, OnPathFound, bFound, Path = MoveTemp(Path)]()
+		{
+			// the world went away while we were searching
+			if (WeakThis.IsValid())
+			{
+				OnPathFound.ExecuteIfBound(bFound, Path);
+			}
+		});
+	});
+}
+
+FWorldGridAbstractGraphPtr UWorldGridPathfindingSubsystem::GetAbstractGraph(FWorldGridSnapshotPtr& OutSnapshot)
+{
+	UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(this);
+	FWorldGridSnapshotPtr Snapshot = WorldGrid->GetSnapshot();
+
+	// the snapshot is only replaced when something changed, so this is the cheap common case
+	if (!AbstractGraph.IsValid() || (Snapshot != AbstractGraphSnapshot))
+	{
+		const FWorldGridPathCostConfig Costs = GetCachedSearchCosts();
+
+		TArray<int32> ChunkVersions;
+		WorldGrid->GetChunkVersions(FGridRect(FGridVector(0, 0), FGridVector(WorldGrid->GetConfig().Width)), Costs.GetBlockingLayers(), ChunkVersions);
+
+		AbstractGraph = FWorldGridAbstractGraph::Build(*Snapshot, Costs, ChunkVersions, AbstractGraph.Get());
+		AbstractGraphSnapshot = Snapshot;
+
+		UE_LOG(LogWorldGridPathfinding, Verbose, TEXT("rebuilt %d chunks of the abstract graph"), AbstractGraph->GetRebuiltChunkCount());
+	}
+
+	OutSnapshot = AbstractGraphSnapshot;
+	return AbstractGraph;
+}
+
+bool UWorldGridPathfindingSubsystem::FindPathHierarchical(const FGridVector& Start, const FGridVector& Goal, TArray<FGridVector>& OutPath)
+{
+	FWorldGridSnapshotPtr Snapshot;
+	FWorldGridAbstractGraphPtr Graph = GetAbstractGraph(Snapshot);
+
+	TUniquePtr<FWorldGridPathfinder> Pathfinder = PathfinderPool->Acquire();
+	const bool bFound = Graph->FindPath(*Snapshot, Start, Goal, *Pathfinder, OutPath);
+	PathfinderPool->Release(MoveTemp(Pathfinder));
+
+	return bFound;
+}
+
+void UWorldGridPathfindingSubsystem::FindPathHierarchicalAsync(const FGridVector& Start, const FGridVector& Goal, FOnWorldGridPathFound OnPathFound)
+{
+	// the graph is brought up to date here rather than on the worker so every query shares the rebuild
+	FWorldGridSnapshotPtr Snapshot;
+	FWorldGridAbstractGraphPtr Graph = GetAbstractGraph(Snapshot);
+	TSharedPtr<FWorldGridPathfinderPool, ESPMode::ThreadSafe> Pool = PathfinderPool;
+	TWeakObjectPtr<UWorldGridPathfindingSubsystem> WeakThis(this);
+
+	Async(EAsyncExecution::ThreadPool, [Snapshot, Graph, Pool, Start, Goal, WeakThis, OnPathFound]()
+	{
+		TUniquePtr<FWorldGridPathfinder> Pathfinder = Pool->Acquire();
+
+		TArray<FGridVector> Path;
+		const bool bFound = Graph->FindPath(*Snapshot, Start, Goal, *Pathfinder, Path);
+
+		Pool->Release(MoveTemp(Pathfinder));
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, OnPathFound, bFound, Path = MoveTemp(Path)]()
+		{
+			if (WeakThis.IsValid())
+			{
+				OnPathFound.ExecuteIfBound(bFound, Path);
+			}
+		});
+	});
+}
+
+void UWorldGridPathfindingSubsystem::OnGridChanged(const TArray<FWorldGridChange>& Changes)
+{
+	UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(this);
+	const int32 ChunkCountPerSide = WorldGrid->GetChunkCountPerSide();
+
+	// changes are already coalesced per chunk, but a change can still span a few
+	TArray<int32> DirtyChunks;
+	for (const FWorldGridChange& Change : Changes)
+	{
+		const FGridVector FirstChunk = WorldGrid->GetChunkForGridPosition(Change.Rect.Min);
+		const FGridVector LastChunk = WorldGrid->GetChunkForGridPosition(FGridVector(Change.Rect.Max.X - 1, Change.Rect.Max.Y - 1));
+		for (int32 ChunkY = FirstChunk.Y; ChunkY <= LastChunk.Y; ++ChunkY)
+		{
+			for (int32 ChunkX = FirstChunk.X; ChunkX <= LastChunk.X; ++ChunkX)
+			{
+				DirtyChunks.AddUnique((ChunkY * ChunkCountPerSide) + ChunkX);
+			}
+		}
+	}
+
+	Reachability.Update(*WorldGrid->GetSnapshot(), GetCachedSearchCosts(), DirtyChunks);
+}
+
+FWorldGridPathCostConfig UWorldGridPathfindingSubsystem::GetCachedSearchCosts() const
+{
+	// agents reserve cells as they walk, cached searches would be invalidated every step if reservations blocked them
+	FWorldGridPathCostConfig Costs = UWorldGridSubsystem::Get(this)->GetConfig().PathCosts;
+	Costs.bReservationsBlock = false;
+	return Costs;
+}
+
+int64 UWorldGridPathfindingSubsystem::GetFlowFieldSourceVersion()
+{
+	if (CachedFlowFieldSourceVersionFrame != GFrameCounter)
+	{
+		UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(this);
+		const int32 Width = WorldGrid->GetConfig().Width;
+		WorldGrid->GetChunkVersions(FGridRect(FGridVector(0, 0), FGridVector(Width)), GetCachedSearchCosts().GetBlockingLayers(), CachedFlowFieldChunkVersions);
+
+		// summed here rather than read again so the two always agree
+		CachedFlowFieldSourceVersion = 0;
+		for (int32 ChunkVersion : CachedFlowFieldChunkVersions)
+		{
+			CachedFlowFieldSourceVersion += ChunkVersion;
+		}
+		CachedFlowFieldSourceVersionFrame = GFrameCounter;
+	}
+
+	return CachedFlowFieldSourceVersion;
+}
+
+bool UWorldGridPathfindingSubsystem::IsFlowFieldCurrent(FFlowFieldEntry& Entry)
+{
+	if (!Entry.FlowField.IsValid())
+	{
+		return false;
+	}
+
+	const int64 SourceVersion = GetFlowFieldSourceVersion();
+	if (Entry.CheckedVersion == SourceVersion)
+	{
+		return true;
+	}
+
+	// a write anywhere moves the source version, but the field only goes stale if it landed somewhere the field reached
+	if (!Entry.FlowField->IsCurrent(CachedFlowFieldChunkVersions))
+	{
+		return false;
+	}
+
+	Entry.CheckedVersion = SourceVersion;
+	return true;
+}
+
+FWorldGridFlowFieldPtr UWorldGridPathfindingSubsystem::RequestFlowField(const FGridVector& Target)
+{
+	check(IsInGameThread());
+
+	UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(this);
+	if (!WorldGrid->IsValidPosition(Target))
+	{
+		return nullptr;
+	}
+
+	const int32 TargetKey = (Target.Y * WorldGrid->GetConfig().Width) + Target.X;
+	const int64 SourceVersion = GetFlowFieldSourceVersion();
+
+	FFlowFieldEntry* Entry = FlowFields.Find(TargetKey);
+	if (Entry == nullptr)
+	{
+		FlowFields.Add(TargetKey);
+		TrimFlowFields(TargetKey);
+		Entry = FlowFields.Find(TargetKey);
+	}
+
+	Entry->LastRequestFrame = GFrameCounter;
+
+	if (!IsFlowFieldCurrent(*Entry) && (Entry->PendingVersion != SourceVersion))
+	{
+		Entry->PendingVersion = SourceVersion;
+
+		FWorldGridSnapshotPtr Snapshot = WorldGrid->GetSnapshot();
+		TSharedPtr<FWorldGridPathfinderPool, ESPMode::ThreadSafe> Pool = PathfinderPool;
+		TWeakObjectPtr<UWorldGridPathfindingSubsystem> WeakThis(this);
+		const FWorldGridPathCostConfig Costs = GetCachedSearchCosts();
+		const TArray<int32> ChunkVersions = CachedFlowFieldChunkVersions;
+
+		Async(EAsyncExecution::ThreadPool, [Snapshot, Pool, Target, Costs, SourceVersion, ChunkVersions, WeakThis]()
+		{
+			TUniquePtr<FWorldGridPathfinder> Pathfinder = Pool->Acquire();
+			FWorldGridFlowFieldPtr FlowField = FWorldGridFlowField::Build(*Snapshot, Target, Costs, SourceVersion, ChunkVersions, *Pathfinder);
+			Pool->Release(MoveTemp(Pathfinder));
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, FlowField]()
+			{
+				if (WeakThis.IsValid())
+				{
+					WeakThis->OnFlowFieldBuildComplete(FlowField);
+				}
+			});
+		});
+	}
+
+	return Entry->FlowField;
+}
+
+bool UWorldGridPathfindingSubsystem::IsFlowFieldCurrent(const FGridVector& Target)
+{
+	const int32 Width = UWorldGridSubsystem::Get(this)->GetConfig().Width;
+	FFlowFieldEntry* Entry = FlowFields.Find((Target.Y * Width) + Target.X);
+	return Entry && IsFlowFieldCurrent(*Entry);
+}
+
+void UWorldGridPathfindingSubsystem::OnFlowFieldBuildComplete(const FWorldGridFlowFieldPtr& FlowField)
+{
+	const FGridVector& Target = FlowField->GetTarget();
+	const int32 Width = UWorldGridSubsystem::Get(this)->GetConfig().Width;
+
+	// trimmed while it was building
+	FFlowFieldEntry* Entry = FlowFields.Find((Target.Y * Width) + Target.X);
+	if (Entry == nullptr)
+	{
+		return;
+	}
+
+	// builds can finish out of order, never replace a newer field with an older one
+	if (!Entry->FlowField.IsValid() || (Entry->FlowField->GetSourceVersion() < FlowField->GetSourceVersion()))
+	{
+		Entry->FlowField = FlowField;
+		Entry->CheckedVersion = FlowField->GetSourceVersion();
+	}
+
+	if (Entry->PendingVersion == FlowField->GetSourceVersion())
+	{
+		Entry->PendingVersion = INDEX_NONE;
+	}
+
+	OnFlowFieldBuilt.Broadcast(FlowField);
+}
+
+void UWorldGridPathfindingSubsystem::TrimFlowFields(int32 KeepKey)
+{
+	while (FlowFields.Num() > MaxCachedFlowFields)
+	{
+		int32 OldestKey = INDEX_NONE;
+		uint64 OldestFrame = MAX_uint64;
+		for (const TPair<int32, FFlowFieldEntry>& Pair : FlowFields)
+		{
+			if ((Pair.Key != KeepKey) && (Pair.Value.LastRequestFrame < OldestFrame))
+			{
+				OldestKey = Pair.Key;
+				OldestFrame = Pair.Value.LastRequestFrame;
+			}
+		}
+
+		FlowFields.Remove(OldestKey);
+	}
+}
+
+namespace
+{
+	// AE.Grid.BenchmarkPathfinding [Queries] [Seed] [Hierarchical]
+	void BenchmarkPathfinding(const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr)
+		{
+			return;
+		}
+
+		const int32 QueryCount = (Args.Num() > 0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+		const int32 Seed = (Args.Num() > 1) ? FCString::Atoi(*Args[1]) : 1337;
+		const bool bHierarchical = (Args.Num() > 2) && FCString::ToBool(*Args[2]);
+
+		UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(World);
+		FWorldGridSnapshotPtr Snapshot = WorldGrid->GetSnapshot();
+		const FWorldGridPathCostConfig& Costs = WorldGrid->GetConfig().PathCosts;
+		const int32 Width = Snapshot->GetWidth();
+
+		// pick the endpoints up front so only the searches are timed
+		FRandomStream RandomStream(Seed);
+		TArray<FWorldGridPathQuery> Queries;
+		Queries.Reserve(QueryCount);
+		for (int32 QueryIndex = 0; QueryIndex < QueryCount; ++QueryIndex)
+		{
+			FWorldGridPathQuery& Query = Queries.AddDefaulted_GetRef();
+			Query.Start = FGridVector(RandomStream.RandRange(0, Width - 1), RandomStream.RandRange(0, Width - 1));
+			Query.Goal = FGridVector(RandomStream.RandRange(0, Width - 1), RandomStream.RandRange(0, Width - 1));
+			Query.Costs = Costs;
+		}
+
+		// the graph is built (or updated) outside the timed section, like it would be between frames
+		FWorldGridAbstractGraphPtr Graph;
+		if (bHierarchical)
+		{
+			FWorldGridSnapshotPtr GraphSnapshot;
+			const double BuildStartTime = FPlatformTime::Seconds();
+			Graph = UWorldGridPathfindingSubsystem::Get(World)->GetAbstractGraph(GraphSnapshot);
+			Snapshot = GraphSnapshot;
+			UE_LOG(LogWorldGridPathfinding, Display, TEXT("abstract graph up to date in %.2fms"), (FPlatformTime::Seconds() - BuildStartTime) * 1000.0);
+		}
+
+		FWorldGridPathfinder Pathfinder;
+		TArray<FGridVector> Path;
+		int32 FoundCount = 0;
+		int64 ExpandedCount = 0;
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (const FWorldGridPathQuery& Query : Queries)
+		{
+			if (bHierarchical)
+			{
+				FoundCount += Graph->FindPath(*Snapshot, Query.Start, Query.Goal, Pathfinder, Path) ? 1 : 0;
+			}
+			else
+			{
+				FoundCount += Pathfinder.FindPath(*Snapshot, Query, Path) ? 1 : 0;
+			}
+			ExpandedCount += Pathfinder.GetLastExpandedNodeCount();
+		}
+		const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+
+		UE_LOG(LogWorldGridPathfinding, Display, TEXT("%s%d queries on a %dx%d grid in %.2fms: %.0f queries/s, %.3fms avg, %lld cells expanded avg, %d found"),
+			bHierarchical ? TEXT("hierarchical: ") : TEXT(""), QueryCount, Width, Width, ElapsedSeconds * 1000.0, QueryCount / FMath::Max(ElapsedSeconds, SMALL_NUMBER),
+			(ElapsedSeconds * 1000.0) / QueryCount, ExpandedCount / QueryCount, FoundCount);
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs BenchmarkPathfindingCommand(
+		TEXT("AE.Grid.BenchmarkPathfinding"),
+		TEXT("Runs random path queries on the current world grid on the game thread and logs throughput. Usage: AE.Grid.BenchmarkPathfinding [Queries=1000] [Seed=1337] [Hierarchical=0]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkPathfinding));
+}
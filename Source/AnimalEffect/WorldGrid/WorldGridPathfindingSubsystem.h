@@ -0,0 +1,117 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGridAbstractGraph.h"
+#include "WorldGridFlowField.h"
+#include "WorldGridPathfinder.h"
+#include "WorldGridReachability.h"
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "WorldGridPathfindingSubsystem.generated.h"
+
+class FWorldGridPathfinderPool;
+
+// always called on the game thread
+DECLARE_DELEGATE_TwoParams(FOnWorldGridPathFound, bool /*bFound*/, const TArray<FGridVector>& /*Path*/);
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnWorldGridFlowFieldBuilt, const FWorldGridFlowFieldPtr& /*FlowField*/);
+
+/**
+ * Runs FWorldGridPathfinder queries against grid snapshots.
+ * Async queries take a snapshot on the calling (game) thread, search on a worker and call back on the game thread.
+ * Pathfinders are pooled so their per-cell arrays are only allocated once per worker.
+ * Hierarchical queries go through an FWorldGridAbstractGraph that's brought up to date with the grid whenever one is asked for.
+ * Flow fields are cached by target and rebuilt on a worker once the grid's version over their blocking layers moves.
+ * Reachability labels are kept up to date through a grid subscription, so they lag writes by at most a frame.
+ */
+UCLASS()
+class ANIMALEFFECT_API UWorldGridPathfindingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	static UWorldGridPathfindingSubsystem* Get(const UObject* WorldContextObject);
+
+	void Initialize(FSubsystemCollectionBase& Collection) override;
+	void Deinitialize() override;
+
+	// a query between the two cells using the grid's configured costs
+	FWorldGridPathQuery MakeQuery(const FGridVector& Start, const FGridVector& Goal) const;
+
+	// searches right away on the game thread against the latest snapshot
+	bool FindPath(const FWorldGridPathQuery& Query, TArray<FGridVector>& OutPath);
+
+	void FindPathAsync(const FWorldGridPathQuery& Query, FOnWorldGridPathFound OnPathFound);
+
+	// long range queries through the abstract graph with the grid's configured costs. paths are near optimal rather than optimal,
+	// and go through reserved cells since reservations come and go faster than the graph should be rebuilt
+	bool FindPathHierarchical(const FGridVector& Start, const FGridVector& Goal, TArray<FGridVector>& OutPath);
+
+	void FindPathHierarchicalAsync(const FGridVector& Start, const FGridVector& Goal, FOnWorldGridPathFound OnPathFound);
+
+	// rebuilds the chunks that changed since the last call, if any. OutSnapshot is the snapshot the graph matches
+	FWorldGridAbstractGraphPtr GetAbstractGraph(FWorldGridSnapshotPtr& OutSnapshot);
+
+	// O(1). whether a path exists between the two cells, as of the last grid flush. reservations don't count
+	FORCEINLINE bool IsReachable(const FGridVector& A, const FGridVector& B) const { return Reachability.IsReachable(A, B); }
+
+	FORCEINLINE const FWorldGridReachability& GetReachability() const { return Reachability; }
+
+	// the latest field towards Target, null until the first one is built. starts a rebuild if the grid changed under it,
+	// the stale field is still returned meanwhile since it's almost always still right. cheap enough to call per agent per update
+	FWorldGridFlowFieldPtr RequestFlowField(const FGridVector& Target);
+
+	// true if the cached field towards Target is up to date with the grid
+	bool IsFlowFieldCurrent(const FGridVector& Target);
+
+	// broadcast on the game thread whenever a field finishes building
+	FOnWorldGridFlowFieldBuilt OnFlowFieldBuilt;
+
+private:
+
+	struct FFlowFieldEntry
+	{
+		FWorldGridFlowFieldPtr FlowField;
+		// the version a build is in flight for, INDEX_NONE if none
+		int64 PendingVersion = INDEX_NONE;
+		// the source version FlowField was last found current at, so its chunks are only compared again once the grid moves
+		int64 CheckedVersion = INDEX_NONE;
+		uint64 LastRequestFrame = 0;
+	};
+
+	// the grid's region version over the flow field blocking layers, read at most once per frame along with every chunk's version
+	int64 GetFlowFieldSourceVersion();
+
+	// true if nothing the entry's field depends on has been written since it was built
+	bool IsFlowFieldCurrent(FFlowFieldEntry& Entry);
+
+	void OnFlowFieldBuildComplete(const FWorldGridFlowFieldPtr& FlowField);
+
+	// drops the least recently requested fields, other than KeepKey's, until the cache is back under its limit
+	void TrimFlowFields(int32 KeepKey);
+
+	void OnGridChanged(const TArray<FWorldGridChange>& Changes);
+
+	// the grid's costs, minus reservations, for the abstract graph, flow fields and reachability
+	FWorldGridPathCostConfig GetCachedSearchCosts() const;
+
+	TSharedPtr<FWorldGridPathfinderPool, ESPMode::ThreadSafe> PathfinderPool;
+
+	FWorldGridAbstractGraphPtr AbstractGraph;
+	FWorldGridSnapshotPtr AbstractGraphSnapshot;
+
+	FWorldGridReachability Reachability;
+
+	FDelegateHandle GridChangedHandle;
+
+	// keyed by target cell index
+	TMap<int32, FFlowFieldEntry> FlowFields;
+
+	int64 CachedFlowFieldSourceVersion = 0;
+	TArray<int32> CachedFlowFieldChunkVersions;
+	uint64 CachedFlowFieldSourceVersionFrame = MAX_uint64;
+
+};
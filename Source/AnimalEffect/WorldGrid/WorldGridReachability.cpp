@@ -0,0 +1,275 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WorldGridReachability.h"
+
+#include "WorldGridPathfinder.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	// the first four are the straight neighbours
+	constexpr int32 NeighbourOffsetX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	constexpr int32 NeighbourOffsetY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+	bool IsWalkable(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const FGridVector& Position)
+	{
+		return !(Costs.bReservationsBlock ? Snapshot.IsOccupied(Position) : Snapshot.HasActor(Position))
+			&& (Costs.GetTerrainCost(Snapshot.GetTerrainTypeAtGridPosition(Position)) >= 0.f);
+	}
+
+	// both cells are known to be walkable. the step rules are symmetric so this works for union-find
+	bool CanStep(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const FGridVector& From, const FGridVector& To, int32 NeighbourIndex)
+	{
+		const float TerrainCost = Costs.GetTerrainCost(Snapshot.GetTerrainTypeAtGridPosition(To));
+		return FWorldGridPathfinder::GetStepCost(Snapshot, Costs, From, To, Snapshot.GetElevationAtGridPosition(From), TerrainCost, NeighbourIndex >= 4) >= 0.f;
+	}
+
+	int32 FindRoot(TArray<int32>& Parents, int32 Index)
+	{
+		while (Parents[Index] != Index)
+		{
+			// path halving
+			Parents[Index] = Parents[Parents[Index]];
+			Index = Parents[Index];
+		}
+		return Index;
+	}
+}
+
+void FWorldGridReachability::Reset()
+{
+	Width = 0;
+	ChunkCountPerSide = 0;
+	Chunks.Empty();
+	ComponentBases.Empty();
+	Roots.Empty();
+}
+
+void FWorldGridReachability::Update(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const TArray<int32>& DirtyChunks)
+{
+	const int32 ChunkCount = Snapshot.GetChunkCountPerSide() * Snapshot.GetChunkCountPerSide();
+
+	TArray<int32> ChunksToLabel;
+	if ((Width != Snapshot.GetWidth()) || (Chunks.Num() != ChunkCount))
+	{
+		Width = Snapshot.GetWidth();
+		ChunkCountPerSide = Snapshot.GetChunkCountPerSide();
+		Chunks.Reset();
+		Chunks.SetNum(ChunkCount);
+
+		for (int32 ChunkIndex = 0; ChunkIndex < ChunkCount; ++ChunkIndex)
+		{
+			Chunks[ChunkIndex].Rect = Snapshot.GetChunk(FGridVector(ChunkIndex % ChunkCountPerSide, ChunkIndex / ChunkCountPerSide))->Rect;
+			ChunksToLabel.Add(ChunkIndex);
+		}
+	}
+	else
+	{
+		ChunksToLabel = DirtyChunks;
+	}
+
+	if (ChunksToLabel.Num() == 0)
+	{
+		return;
+	}
+
+	ParallelFor(ChunksToLabel.Num(), [&](int32 Index)
+	{
+		LabelChunk(Snapshot, Costs, ChunksToLabel[Index]);
+	});
+
+	// a relabelled chunk's links are stale, and so is every link that touches one of its cells. that's not just the links its
+	// lower neighbours keep to it: a diagonal link between two other chunks can cut the corner of this one, e.g. (X+1,Y) to (X,Y+1).
+	// every such link is owned by a chunk in the 3x3 around it
+	TBitArray<> ChunksToLink(false, ChunkCount);
+	for (int32 ChunkIndex : ChunksToLabel)
+	{
+		const FGridVector Chunk(ChunkIndex % ChunkCountPerSide, ChunkIndex / ChunkCountPerSide);
+		for (int32 OffsetY = -1; OffsetY <= 1; ++OffsetY)
+		{
+			for (int32 OffsetX = -1; OffsetX <= 1; ++OffsetX)
+			{
+				const FGridVector Neighbour(Chunk.X + OffsetX, Chunk.Y + OffsetY);
+				if ((Neighbour.X >= 0) && (Neighbour.X < ChunkCountPerSide) && (Neighbour.Y >= 0) && (Neighbour.Y < ChunkCountPerSide))
+				{
+					ChunksToLink[(Neighbour.Y * ChunkCountPerSide) + Neighbour.X] = true;
+				}
+			}
+		}
+	}
+
+	TArray<int32> ChunksToLinkList;
+	for (TConstSetBitIterator<> It(ChunksToLink); It; ++It)
+	{
+		ChunksToLinkList.Add(It.GetIndex());
+	}
+
+	ParallelFor(ChunksToLinkList.Num(), [&](int32 Index)
+	{
+		LinkChunk(Snapshot, Costs, ChunksToLinkList[Index]);
+	});
+
+	RebuildRoots();
+
+	LastRelabelledChunkCount = ChunksToLabel.Num();
+}
+
+void FWorldGridReachability::LabelChunk(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, int32 ChunkIndex)
+{
+	FChunkLabels& Chunk = Chunks[ChunkIndex];
+	const FGridRect& Rect = Chunk.Rect;
+	const int32 RectWidth = Rect.Width();
+
+	Chunk.Labels.Init(0, RectWidth * Rect.Height());
+	Chunk.ComponentCount = 0;
+
+	// walkability once per cell rather than once per visit
+	TBitArray<> Walkable(false, Chunk.Labels.Num());
+	for (int32 LocalIndex = 0; LocalIndex < Chunk.Labels.Num(); ++LocalIndex)
+	{
+		Walkable[LocalIndex] = IsWalkable(Snapshot, Costs, FGridVector(Rect.Min.X + (LocalIndex % RectWidth), Rect.Min.Y + (LocalIndex / RectWidth)));
+	}
+
+	const int32 NeighboursToVisit = Costs.bAllowDiagonal ? 8 : 4;
+
+	TArray<int32, TInlineAllocator<GridChunkSize * GridChunkSize>> Stack;
+	for (int32 SeedIndex = 0; SeedIndex < Chunk.Labels.Num(); ++SeedIndex)
+	{
+		if (!Walkable[SeedIndex] || (Chunk.Labels[SeedIndex] != 0))
+		{
+			continue;
+		}
+
+		const uint16 Label = static_cast<uint16>(++Chunk.ComponentCount);
+		Chunk.Labels[SeedIndex] = Label;
+		Stack.Add(SeedIndex);
+
+		while (Stack.Num() > 0)
+		{
+			const int32 LocalIndex = Stack.Pop(false);
+			const FGridVector Position(Rect.Min.X + (LocalIndex % RectWidth), Rect.Min.Y + (LocalIndex / RectWidth));
+
+			for (int32 NeighbourIndex = 0; NeighbourIndex < NeighboursToVisit; ++NeighbourIndex)
+			{
+				const FGridVector Neighbour(Position.X + NeighbourOffsetX[NeighbourIndex], Position.Y + NeighbourOffsetY[NeighbourIndex]);
+				if (!Rect.Contains(Neighbour))
+				{
+					continue;
+				}
+
+				const int32 NeighbourLocalIndex = ((Neighbour.Y - Rect.Min.Y) * RectWidth) + (Neighbour.X - Rect.Min.X);
+				if (!Walkable[NeighbourLocalIndex] || (Chunk.Labels[NeighbourLocalIndex] != 0) || !CanStep(Snapshot, Costs, Position, Neighbour, NeighbourIndex))
+				{
+					continue;
+				}
+
+				Chunk.Labels[NeighbourLocalIndex] = Label;
+				Stack.Add(NeighbourLocalIndex);
+			}
+		}
+	}
+}
+
+void FWorldGridReachability::LinkChunk(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, int32 ChunkIndex)
+{
+	FChunkLabels& Chunk = Chunks[ChunkIndex];
+	const FGridRect& Rect = Chunk.Rect;
+	const int32 NeighboursToVisit = Costs.bAllowDiagonal ? 8 : 4;
+
+	Chunk.Links.Reset();
+
+	// only border cells can step into another chunk
+	for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; ++Y)
+	{
+		const bool bBorderRow = (Y == Rect.Min.Y) || (Y == (Rect.Max.Y - 1));
+		for (int32 X = Rect.Min.X; X < Rect.Max.X; X += (bBorderRow || (X == (Rect.Max.X - 1))) ? 1 : FMath::Max(1, Rect.Width() - 1))
+		{
+			const FGridVector Position(X, Y);
+			const uint16 Label = Chunk.Labels[((Y - Rect.Min.Y) * Rect.Width()) + (X - Rect.Min.X)];
+			if (Label == 0)
+			{
+				continue;
+			}
+
+			for (int32 NeighbourIndex = 0; NeighbourIndex < NeighboursToVisit; ++NeighbourIndex)
+			{
+				const FGridVector Neighbour(X + NeighbourOffsetX[NeighbourIndex], Y + NeighbourOffsetY[NeighbourIndex]);
+				if (!Snapshot.IsValidPosition(Neighbour))
+				{
+					continue;
+				}
+
+				const int32 OtherChunk = ((Neighbour.Y / GridChunkSize) * ChunkCountPerSide) + (Neighbour.X / GridChunkSize);
+				if (OtherChunk <= ChunkIndex)
+				{
+					continue;
+				}
+
+				const uint16 OtherLabel = GetLocalLabel(Neighbour);
+				if ((OtherLabel == 0) || !CanStep(Snapshot, Costs, Position, Neighbour, NeighbourIndex))
+				{
+					continue;
+				}
+
+				Chunk.Links.AddUnique({ Label, OtherLabel, OtherChunk });
+			}
+		}
+	}
+}
+
+void FWorldGridReachability::RebuildRoots()
+{
+	const int32 ChunkCount = Chunks.Num();
+
+	ComponentBases.SetNumUninitialized(ChunkCount);
+	int32 ComponentCount = 0;
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkCount; ++ChunkIndex)
+	{
+		ComponentBases[ChunkIndex] = ComponentCount;
+		ComponentCount += Chunks[ChunkIndex].ComponentCount;
+	}
+
+	Roots.SetNumUninitialized(ComponentCount);
+	for (int32 ComponentIndex = 0; ComponentIndex < ComponentCount; ++ComponentIndex)
+	{
+		Roots[ComponentIndex] = ComponentIndex;
+	}
+
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkCount; ++ChunkIndex)
+	{
+		for (const FBorderLink& Link : Chunks[ChunkIndex].Links)
+		{
+			const int32 RootA = FindRoot(Roots, ComponentBases[ChunkIndex] + Link.Label - 1);
+			const int32 RootB = FindRoot(Roots, ComponentBases[Link.OtherChunk] + Link.OtherLabel - 1);
+			if (RootA != RootB)
+			{
+				// the lower root wins so labels don't depend on link order
+				Roots[FMath::Max(RootA, RootB)] = FMath::Min(RootA, RootB);
+			}
+		}
+	}
+
+	// flatten so lookups never have to walk
+	for (int32 ComponentIndex = 0; ComponentIndex < ComponentCount; ++ComponentIndex)
+	{
+		Roots[ComponentIndex] = Roots[Roots[ComponentIndex]];
+	}
+}
+
+int32 FWorldGridReachability::GetLabel(const FGridVector& Position) const
+{
+	if ((Position.X < 0) || (Position.X >= Width) || (Position.Y < 0) || (Position.Y >= Width))
+	{
+		return INDEX_NONE;
+	}
+
+	const uint16 LocalLabel = GetLocalLabel(Position);
+	if (LocalLabel == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 ChunkIndex = ((Position.Y / GridChunkSize) * ChunkCountPerSide) + (Position.X / GridChunkSize);
+	return Roots[ComponentBases[ChunkIndex] + LocalLabel - 1];
+}
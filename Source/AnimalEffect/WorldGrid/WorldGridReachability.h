@@ -0,0 +1,89 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGridSnapshot.h"
+#include "WorldGridTypes.h"
+
+/**
+ * Connected regions of walkable cells, so "can I walk from A to B" is two label lookups instead of a search.
+ * - Each chunk labels its own walkable cells into local components with a flood fill.
+ * - Links between components of neighbouring chunks are kept per chunk, and a union-find over every local component
+ *   merges them into the global regions.
+ * - An update only relabels the chunks it's given and relinks their borders. The union-find is rebuilt from the kept links,
+ *   which is a pass over components rather than cells.
+ * Connectivity follows the pathfinder's step rules for the costs it's updated with, so labels and paths agree.
+ */
+class ANIMALEFFECT_API FWorldGridReachability
+{
+public:
+
+	// relabels DirtyChunks (row-major chunk indices) and relinks around them. the first update labels every chunk regardless
+	void Update(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, const TArray<int32>& DirtyChunks);
+
+	void Reset();
+
+	FORCEINLINE bool IsInitialized() const { return Chunks.Num() > 0; }
+
+	// INDEX_NONE if the cell isn't walkable. cells are reachable from one another iff their labels match
+	int32 GetLabel(const FGridVector& Position) const;
+
+	FORCEINLINE bool IsReachable(const FGridVector& A, const FGridVector& B) const
+	{
+		const int32 LabelA = GetLabel(A);
+		return (LabelA != INDEX_NONE) && (LabelA == GetLabel(B));
+	}
+
+	// for profiling
+	FORCEINLINE int32 GetLastRelabelledChunkCount() const { return LastRelabelledChunkCount; }
+
+private:
+
+	// local labels are 1-based, 0 is a cell that isn't walkable. cliffs can split a chunk into a component per cell, so a byte isn't enough
+	struct FBorderLink
+	{
+		uint16 Label;
+		uint16 OtherLabel;
+		int32 OtherChunk;
+
+		FORCEINLINE bool operator==(const FBorderLink& Other) const
+		{
+			return (Label == Other.Label) && (OtherLabel == Other.OtherLabel) && (OtherChunk == Other.OtherChunk);
+		}
+	};
+
+	struct FChunkLabels
+	{
+		FGridRect Rect;
+		// row-major over Rect
+		TArray<uint16> Labels;
+		int32 ComponentCount = 0;
+		// only to chunks with a higher index (east and the row below), so every border is owned by one chunk
+		TArray<FBorderLink> Links;
+	};
+
+	void LabelChunk(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, int32 ChunkIndex);
+	void LinkChunk(const FWorldGridSnapshot& Snapshot, const FWorldGridPathCostConfig& Costs, int32 ChunkIndex);
+
+	void RebuildRoots();
+
+	FORCEINLINE uint16 GetLocalLabel(const FGridVector& Position) const
+	{
+		const FChunkLabels& Chunk = Chunks[((Position.Y / GridChunkSize) * ChunkCountPerSide) + (Position.X / GridChunkSize)];
+		return Chunk.Labels[((Position.Y - Chunk.Rect.Min.Y) * Chunk.Rect.Width()) + (Position.X - Chunk.Rect.Min.X)];
+	}
+
+	int32 Width = 0;
+	int32 ChunkCountPerSide = 0;
+
+	TArray<FChunkLabels> Chunks;
+
+	// per chunk, the global index of its first component
+	TArray<int32> ComponentBases;
+
+	// per global component, the component its region is labelled by
+	TArray<int32> Roots;
+
+	int32 LastRelabelledChunkCount = 0;
+
+};
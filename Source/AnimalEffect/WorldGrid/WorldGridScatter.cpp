@@ -0,0 +1,251 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WorldGridScatter.h"
+
+#include "WorldGridSubsystem.h"
+
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	// candidates tried around each active sample before it's retired
+	constexpr int32 CandidatesPerSample = 30;
+
+	const TArray<FGridVector> NoExistingPositions;
+}
+
+void FWorldGridScatter::Scatter(const FWorldGridSnapshot& Snapshot, const TArray<FWorldGridScatterRule>& Rules, const TArray<FGridVector>& Sizes, int32 Seed,
+	TArray<TArray<FGridVector>>& OutPositions, const TArray<TArray<FGridVector>>* ExistingPositions)
+{
+	check(Rules.Num() == Sizes.Num());
+	check((ExistingPositions == nullptr) || (ExistingPositions->Num() == Rules.Num()));
+
+	OutPositions.Reset();
+	OutPositions.SetNum(Rules.Num());
+
+	ParallelFor(Rules.Num(), [&](int32 RuleIndex)
+	{
+		const TArray<FGridVector>& Existing = ExistingPositions ? (*ExistingPositions)[RuleIndex] : NoExistingPositions;
+		SampleRule(Snapshot, Rules[RuleIndex], Sizes[RuleIndex], HashCombine(GetTypeHash(Seed), GetTypeHash(RuleIndex)), Existing, OutPositions[RuleIndex]);
+	});
+
+	// spacing is between sample origins, not footprints, so a rule whose Spacing is under its footprint can overlap itself, and two
+	// rules aren't spaced against each other at all. this pass is what keeps placements apart, in rule order then sample order
+	const int32 Width = Snapshot.GetWidth();
+	TBitArray<> Claimed(false, Width * Width);
+	for (int32 RuleIndex = 0; RuleIndex < Rules.Num(); ++RuleIndex)
+	{
+		const FGridVector& Size = Sizes[RuleIndex];
+		const int32 MaxCount = Rules[RuleIndex].MaxCount;
+		TArray<FGridVector>& Positions = OutPositions[RuleIndex];
+
+		int32 KeptCount = 0;
+		for (const FGridVector& Position : Positions)
+		{
+			if ((MaxCount > 0) && (KeptCount >= MaxCount))
+			{
+				break;
+			}
+
+			bool bFree = true;
+			for (int32 Y = Position.Y; bFree && (Y < Position.Y + Size.Y); ++Y)
+			{
+				for (int32 X = Position.X; X < Position.X + Size.X; ++X)
+				{
+					if (Claimed[(Y * Width) + X])
+					{
+						bFree = false;
+						break;
+					}
+				}
+			}
+
+			if (!bFree)
+			{
+				continue;
+			}
+
+			for (int32 Y = Position.Y; Y < Position.Y + Size.Y; ++Y)
+			{
+				for (int32 X = Position.X; X < Position.X + Size.X; ++X)
+				{
+					Claimed[(Y * Width) + X] = true;
+				}
+			}
+
+			Positions[KeptCount++] = Position;
+		}
+
+		Positions.SetNum(KeptCount, false);
+	}
+}
+
+void FWorldGridScatter::SampleRule(const FWorldGridSnapshot& Snapshot, const FWorldGridScatterRule& Rule, const FGridVector& Size, int32 Seed,
+	const TArray<FGridVector>& ExistingPositions, TArray<FGridVector>& OutPositions)
+{
+	const float Width = Snapshot.GetWidth();
+	const float Spacing = FMath::Max(Rule.Spacing, 1.5f);
+	const float SpacingSquared = Spacing * Spacing;
+
+	// a background cell is small enough that it can hold at most one sample
+	const float BackgroundCellSize = Spacing / FMath::Sqrt(2.f);
+	const int32 BackgroundWidth = FMath::CeilToInt(Width / BackgroundCellSize);
+	TArray<int32> Background;
+	Background.Init(INDEX_NONE, BackgroundWidth * BackgroundWidth);
+
+	auto GetBackgroundIndex = [BackgroundCellSize, BackgroundWidth](const FVector2D& Sample)
+	{
+		const int32 X = FMath::Min(FMath::FloorToInt(Sample.X / BackgroundCellSize), BackgroundWidth - 1);
+		const int32 Y = FMath::Min(FMath::FloorToInt(Sample.Y / BackgroundCellSize), BackgroundWidth - 1);
+		return (Y * BackgroundWidth) + X;
+	};
+
+	FRandomStream RandomStream(Seed);
+	TArray<FVector2D> Samples;
+	TArray<int32> Active;
+
+	// existing placements are samples like any other, except they're never output. two closer than Spacing keep the first
+	for (const FGridVector& Position : ExistingPositions)
+	{
+		const FVector2D Sample(Position.X + 0.5f, Position.Y + 0.5f);
+		int32& BackgroundSample = Background[GetBackgroundIndex(Sample)];
+		if (BackgroundSample == INDEX_NONE)
+		{
+			BackgroundSample = Samples.Add(Sample);
+			Active.Add(BackgroundSample);
+		}
+	}
+	const int32 ExistingCount = Samples.Num();
+
+	if (ExistingCount == 0)
+	{
+		Samples.Add(FVector2D(RandomStream.FRand() * Width, RandomStream.FRand() * Width));
+		Background[GetBackgroundIndex(Samples[0])] = 0;
+		Active.Add(0);
+	}
+
+	while (Active.Num() > 0)
+	{
+		const int32 ActiveIndex = RandomStream.RandHelper(Active.Num());
+		const FVector2D Origin = Samples[Active[ActiveIndex]];
+
+		bool bFound = false;
+		for (int32 Attempt = 0; Attempt < CandidatesPerSample; ++Attempt)
+		{
+			// uniform over the annulus between Spacing and twice Spacing
+			const float Angle = RandomStream.FRand() * 2.f * PI;
+			const float Radius = FMath::Sqrt(FMath::Lerp(SpacingSquared, 4.f * SpacingSquared, RandomStream.FRand()));
+			const FVector2D Candidate = Origin + FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)) * Radius;
+			if ((Candidate.X < 0.f) || (Candidate.X >= Width) || (Candidate.Y < 0.f) || (Candidate.Y >= Width))
+			{
+				continue;
+			}
+
+			const int32 CandidateX = FMath::FloorToInt(Candidate.X / BackgroundCellSize);
+			const int32 CandidateY = FMath::FloorToInt(Candidate.Y / BackgroundCellSize);
+
+			bool bTooClose = false;
+			for (int32 Y = FMath::Max(CandidateY - 2, 0); !bTooClose && (Y <= FMath::Min(CandidateY + 2, BackgroundWidth - 1)); ++Y)
+			{
+				for (int32 X = FMath::Max(CandidateX - 2, 0); X <= FMath::Min(CandidateX + 2, BackgroundWidth - 1); ++X)
+				{
+					const int32 SampleIndex = Background[(Y * BackgroundWidth) + X];
+					if ((SampleIndex != INDEX_NONE) && (FVector2D::DistSquared(Samples[SampleIndex], Candidate) < SpacingSquared))
+					{
+						bTooClose = true;
+						break;
+					}
+				}
+			}
+
+			if (!bTooClose)
+			{
+				const int32 SampleIndex = Samples.Add(Candidate);
+				Background[GetBackgroundIndex(Candidate)] = SampleIndex;
+				Active.Add(SampleIndex);
+				bFound = true;
+				break;
+			}
+		}
+
+		if (!bFound)
+		{
+			Active.RemoveAtSwap(ActiveIndex, 1, false);
+		}
+	}
+
+	// samples are spread over the whole grid first and filtered after, so they stay evenly spaced up to the edge of whatever they're allowed on
+	const float Density = FMath::Clamp(Rule.Density, 0.f, 1.f);
+	OutPositions.Reset(Samples.Num() - ExistingCount);
+	for (int32 SampleIndex = ExistingCount; SampleIndex < Samples.Num(); ++SampleIndex)
+	{
+		const FVector2D& Sample = Samples[SampleIndex];
+		// drawn for every sample so the kept set doesn't depend on which cells are vacant
+		const bool bKeep = RandomStream.FRand() < Density;
+
+		const FGridVector Position(FMath::FloorToInt(Sample.X), FMath::FloorToInt(Sample.Y));
+		if (bKeep && CanPlace(Snapshot, Rule, Position, Size))
+		{
+			OutPositions.Add(Position);
+		}
+	}
+}
+
+bool FWorldGridScatter::CanPlace(const FWorldGridSnapshot& Snapshot, const FWorldGridScatterRule& Rule, const FGridVector& Position, const FGridVector& Size)
+{
+	if (!Snapshot.IsValidPosition(FGridVector(Position.X + Size.X - 1, Position.Y + Size.Y - 1)))
+	{
+		return false;
+	}
+
+	// same rules as UWorldGridSubsystem::IsSpaceUniformAndVacant, plus the rule's own
+	const int32 Elevation = Snapshot.GetElevationAtGridPosition(Position);
+	const ETerrainType TerrainType = Snapshot.GetTerrainTypeAtGridPosition(Position);
+	if ((Elevation < Rule.MinElevation) || (Elevation > Rule.MaxElevation) || !Rule.AllowsTerrain(TerrainType))
+	{
+		return false;
+	}
+
+	for (int32 Y = Position.Y; Y < Position.Y + Size.Y; ++Y)
+	{
+		for (int32 X = Position.X; X < Position.X + Size.X; ++X)
+		{
+			const FGridVector Cell(X, Y);
+			if ((Snapshot.GetElevationAtGridPosition(Cell) != Elevation)
+				|| (Snapshot.GetTerrainTypeAtGridPosition(Cell) != TerrainType)
+				|| Snapshot.IsOccupied(Cell))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+namespace
+{
+	void ScatterCommand(const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr)
+		{
+			return;
+		}
+
+		UWorldGridSubsystem* WorldGrid = UWorldGridSubsystem::Get(World);
+		FWorldGridScatterConfig Settings = WorldGrid->GetConfig().Scatter;
+		if (Args.Num() > 0)
+		{
+			Settings.Seed = FCString::Atoi(*Args[0]);
+		}
+
+		WorldGrid->ScatterFromRules(Settings.Rules, Settings.Seed);
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs ScatterConsoleCommand(
+		TEXT("AE.Grid.Scatter"),
+		TEXT("Places the world settings' scatter rules on the current world grid, around whatever is already there. Usage: AE.Grid.Scatter [Seed]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ScatterCommand));
+}
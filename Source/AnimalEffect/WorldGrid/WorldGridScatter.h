@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGridSnapshot.h"
+#include "WorldGridTypes.h"
+
+/**
+ * Blue noise placement for FWorldGridScatterRules.
+ * - Each rule gets its own Bridson Poisson-disk sampling over the whole grid, accelerated by a background grid with
+ *   one sample per cell, so a candidate only has to be checked against the 5x5 cells around it.
+ * - Samples are kept if every cell under the rule's footprint matches its terrain and elevation and is vacant in the snapshot.
+ * - Rules sample in parallel, then one serial pass in rule order drops placements overlapping an earlier one.
+ * - Placements a rule already has on the grid can be passed in. Sampling grows out from them and keeps its spacing to them,
+ *   so topping a rule up fills the gaps instead of crowding what's there.
+ * Only reads the snapshot, so it can run on any thread. The same snapshot, rules and seed always give the same placements.
+ */
+class ANIMALEFFECT_API FWorldGridScatter
+{
+public:
+
+	// Sizes are the footprint of each rule, 1x1 for buried items. OutPositions matches Rules, each in placement order.
+	// ExistingPositions, if given, matches Rules too and is never part of OutPositions
+	static void Scatter(const FWorldGridSnapshot& Snapshot, const TArray<FWorldGridScatterRule>& Rules, const TArray<FGridVector>& Sizes, int32 Seed,
+		TArray<TArray<FGridVector>>& OutPositions, const TArray<TArray<FGridVector>>* ExistingPositions = nullptr);
+
+private:
+
+	static void SampleRule(const FWorldGridSnapshot& Snapshot, const FWorldGridScatterRule& Rule, const FGridVector& Size, int32 Seed,
+		const TArray<FGridVector>& ExistingPositions, TArray<FGridVector>& OutPositions);
+
+	static bool CanPlace(const FWorldGridSnapshot& Snapshot, const FWorldGridScatterRule& Rule, const FGridVector& Position, const FGridVector& Size);
+
+};
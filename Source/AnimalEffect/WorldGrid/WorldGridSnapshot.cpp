@@ -0,0 +1,59 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "WorldGridSnapshot.h"
+
+int32 FWorldGridSnapshot::GetElevationAtGridPosition(const FGridVector& Position) const
+{
+	const FWorldGridSnapshotChunk* Chunk = GetChunkAtGridPosition(Position);
+	return Chunk ? Chunk->Elevation[Chunk->GetLocalIndex(Position)] : 0;
+}
+
+ETerrainType FWorldGridSnapshot::GetTerrainTypeAtGridPosition(const FGridVector& Position) const
+{
+	const FWorldGridSnapshotChunk* Chunk = GetChunkAtGridPosition(Position);
+	return Chunk ? Chunk->TerrainType[Chunk->GetLocalIndex(Position)] : ETerrainType::OutOfBounds;
+}
+
+bool FWorldGridSnapshot::IsOccupied(const FGridVector& Position) const
+{
+	const FWorldGridSnapshotChunk* Chunk = GetChunkAtGridPosition(Position);
+	return Chunk ? Chunk->Occupied[Chunk->GetLocalIndex(Position)] : true;
+}
+
+bool FWorldGridSnapshot::HasActor(const FGridVector& Position) const
+{
+	const FWorldGridSnapshotChunk* Chunk = GetChunkAtGridPosition(Position);
+	return Chunk ? Chunk->HasActor[Chunk->GetLocalIndex(Position)] : true;
+}
+
+TTuple<int32, int32> FWorldGridSnapshot::GetDetectionDataAtPosition(const FGridVector& Position) const
+{
+	const FWorldGridSnapshotChunk* Chunk = GetChunkAtGridPosition(Position);
+	return Chunk ? Chunk->DetectionData[Chunk->GetLocalIndex(Position)] : TTuple<int32, int32>(0, 0);
+}
+
+const FWorldGridSnapshotChunk* FWorldGridSnapshot::GetChunkAtGridPosition(const FGridVector& Position) const
+{
+	if (!IsValidPosition(Position))
+	{
+		return nullptr;
+	}
+
+	return Chunks[((Position.Y / GridChunkSize) * ChunkCountPerSide) + (Position.X / GridChunkSize)].Get();
+}
+
+const FWorldGridSnapshotChunk* FWorldGridSnapshot::GetChunk(const FGridVector& Chunk) const
+{
+	if ((Chunk.X < 0) || (Chunk.X >= ChunkCountPerSide) || (Chunk.Y < 0) || (Chunk.Y >= ChunkCountPerSide))
+	{
+		return nullptr;
+	}
+
+	return Chunks[(Chunk.Y * ChunkCountPerSide) + Chunk.X].Get();
+}
+
+int32 FWorldGridSnapshot::GetChunkVersion(const FGridVector& Chunk) const
+{
+	const FWorldGridSnapshotChunk* SnapshotChunk = GetChunk(Chunk);
+	return SnapshotChunk ? SnapshotChunk->Version : 0;
+}
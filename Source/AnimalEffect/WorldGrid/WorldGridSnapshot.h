@@ -0,0 +1,83 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "WorldGridTypes.h"
+
+// one immutable chunk of grid layers. never written after it's built, so any number of threads can read it
+struct ANIMALEFFECT_API FWorldGridSnapshotChunk
+{
+	// the cells this chunk covers, clipped to the grid
+	FGridRect Rect;
+
+	// the chunk's grid version (over the snapshot layers) when it was built
+	int32 Version = 0;
+
+	// row-major over Rect
+	TArray<int32> Elevation;
+	TArray<ETerrainType> TerrainType;
+	// an actor is on the cell or it's reserved
+	TBitArray<> Occupied;
+	// an actor is on the cell, reservations aside
+	TBitArray<> HasActor;
+	TArray<TTuple<int32, int32>> DetectionData;
+
+	FORCEINLINE int32 GetLocalIndex(const FGridVector& Position) const
+	{
+		return ((Position.Y - Rect.Min.Y) * Rect.Width()) + (Position.X - Rect.Min.X);
+	}
+};
+
+using FWorldGridSnapshotChunkPtr = TSharedPtr<const FWorldGridSnapshotChunk, ESPMode::ThreadSafe>;
+
+/**
+ * A read-only view of the grid at the moment it was taken, safe to query from any thread.
+ * - Chunks are shared between snapshots. A chunk is only rebuilt (into a new object) when the grid wrote to it,
+ *   so taking a snapshot is a pointer copy per chunk plus a copy of whatever changed since the last one.
+ * - Chunks are freed when the last snapshot referencing them goes away.
+ * - Dig actualizers aren't included, they're soft object pointers and only meaningful on the game thread.
+ * Get one through UWorldGridSubsystem::GetSnapshot.
+ */
+class ANIMALEFFECT_API FWorldGridSnapshot
+{
+public:
+
+	// the grid layers a snapshot copies. chunk versions are read over these
+	static constexpr EWorldGridLayer Layers = EWorldGridLayer::Elevation | EWorldGridLayer::Terrain | EWorldGridLayer::Actor | EWorldGridLayer::Detection | EWorldGridLayer::Reservation;
+
+	FORCEINLINE int32 GetWidth() const { return Width; }
+	FORCEINLINE int32 GetChunkCountPerSide() const { return ChunkCountPerSide; }
+
+	FORCEINLINE bool IsValidPosition(const FGridVector& Position) const
+	{
+		return (Position.X >= 0 && Position.X < Width)
+			&& (Position.Y >= 0 && Position.Y < Width);
+	}
+
+	int32 GetElevationAtGridPosition(const FGridVector& Position) const;
+	ETerrainType GetTerrainTypeAtGridPosition(const FGridVector& Position) const;
+	bool IsOccupied(const FGridVector& Position) const;
+	bool HasActor(const FGridVector& Position) const;
+	TTuple<int32, int32> GetDetectionDataAtPosition(const FGridVector& Position) const;
+
+	// the chunk containing Position. null if Position is off the grid
+	const FWorldGridSnapshotChunk* GetChunkAtGridPosition(const FGridVector& Position) const;
+
+	const FWorldGridSnapshotChunk* GetChunk(const FGridVector& Chunk) const;
+
+	// 0 for chunks off the grid
+	int32 GetChunkVersion(const FGridVector& Chunk) const;
+
+private:
+
+	friend class UWorldGridSubsystem;
+
+	int32 Width = 0;
+	int32 ChunkCountPerSide = 0;
+
+	// row-major by chunk
+	TArray<FWorldGridSnapshotChunkPtr> Chunks;
+
+};
+
+using FWorldGridSnapshotPtr = TSharedPtr<const FWorldGridSnapshot, ESPMode::ThreadSafe>;
@@ -2,11 +2,15 @@
 
 #include "WorldGridSubsystem.h"
 
+#include "WorldGridGenerator.h"
 #include "WorldGridInterface.h"
+#include "WorldGridScatter.h"
 #include "Data/AEDataAsset.h"
 #include "Data/DigActualizer.h"
 
+#include "Async/ParallelFor.h"
 #include "DrawDebugHelpers.h"
+#include "Engine/World.h"
 
 
 DECLARE_LOG_CATEGORY_CLASS(LogWorldGridSubsystem, Log, All);
@@ -62,13 +66,43 @@ void UWorldGridSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	ElevationGrid.SetNum(GridSize);
 	DigGrid.SetNum(GridSize);
 	DetectionGrid.SetNum(GridSize);
+	ReservationGrid.SetNumZeroed(GridSize);
+
+	ChunkCountPerSide = FMath::DivideAndRoundUp(Config.Width, GridChunkSize);
+	DirtyChunkRects.SetNum(ChunkCountPerSide * ChunkCountPerSide);
+	DirtyChunkLayers.SetNumZeroed(ChunkCountPerSide * ChunkCountPerSide);
+	ChunkLayerVersions.SetNumZeroed(ChunkCountPerSide * ChunkCountPerSide * WorldGridLayerCount);
+	ChunkOccupants.SetNum(ChunkCountPerSide * ChunkCountPerSide);
 
 	GridActorAnnotations.Reserve(1000);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UWorldGridSubsystem::OnWorldPostActorTick);
+
+	if (Config.Generator.bGenerateOnStartup)
+	{
+		GenerateIsland(Config.Generator);
+	}
+
+	// actors can't be spawned this early, scattering waits until the level's own actors are in
+	if (Config.Scatter.bScatterOnBeginPlay)
+	{
+		InitializedActorsHandle = FWorldDelegates::OnWorldInitializedActors.AddUObject(this, &UWorldGridSubsystem::OnWorldInitializedActors);
+	}
 }
 
 void UWorldGridSubsystem::Deinitialize()
 {
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	FWorldDelegates::OnWorldInitializedActors.Remove(InitializedActorsHandle);
+
 	GridActorAnnotations.RemoveAllAnnotations();
+	ChunkOccupants.Empty();
+	DigSummaries.Empty();
+	Subscriptions.Empty();
+	PendingSubscriptions.Empty();
+	LatestSnapshot.Reset();
+	PendingCommands.Empty();
+	ClearHistory();
 }
 
 bool UWorldGridSubsystem::IsValidPosition(const FGridVector& Position) const
@@ -140,7 +174,8 @@ bool UWorldGridSubsystem::IsSpaceUniformAndVacant(const FGridVector& StartPositi
 			if (!IsValidPosition(CurrentPosition) ||
 				(GetElevationAtGridPosition(CurrentPosition) != RequiredElevation) ||
 				(GetTerrainTypeAtGridPosition(CurrentPosition) != RequiredTerrainType) ||
-				(GetActorAtGridPosition(CurrentPosition) != nullptr))
+				(GetActorAtGridPosition(CurrentPosition) != nullptr) ||
+				(GetReservationAtPosition(CurrentPosition) != 0))
 			{
 				return false;
 			}
@@ -279,6 +314,65 @@ AActor* UWorldGridSubsystem::TrySpawnSmallActorOnGrid(TSubclassOf<AActor> ActorC
 		: nullptr;
 }
 
+int32 UWorldGridSubsystem::SpawnActorsOnGridBatch(const UAEMetaAsset* ActorAsset, TArrayView<const FGridVector> Positions, TArray<AActor*>* OutActors)
+{
+	if (ActorAsset == nullptr)
+	{
+		UE_LOG(LogWorldGridSubsystem, Error, TEXT("Can't spawn null actor asset on grid"));
+		return 0;
+	}
+
+	if (!ActorAsset->Implements<UWorldGridInterface>())
+	{
+		UE_LOG(LogWorldGridSubsystem, Error, TEXT("Can't spawn '%s' on grid because it doesn't implement WorldGridInterface"), *ActorAsset->GetName());
+		return 0;
+	}
+
+	const FGridVector ActorSize = Cast<IWorldGridInterface>(ActorAsset)->GetWorldGridSize();
+	if (ActorSize.X < 1 || ActorSize.Y < 1)
+	{
+		UE_LOG(LogWorldGridSubsystem, Error, TEXT("Can't place '%s' on grid because its size is less than 1"), *ActorAsset->GetName());
+		return 0;
+	}
+
+	// a batch is hundreds of spawns, a synchronous load in the middle of that is a hitch we can't afford
+	const TSubclassOf<AActor> ActorClass = ActorAsset->GetLoadedActorClass();
+	if (ActorClass == nullptr)
+	{
+		UE_LOG(LogWorldGridSubsystem, Warning, TEXT("Can't batch spawn '%s' because its actor class isn't loaded yet"), *ActorAsset->GetName());
+		return 0;
+	}
+
+	int32 SpawnedCount = 0;
+	FGridRect SpawnedBounds;
+	{
+		TGuardValue<bool> BatchGuard(bBatchingOccupants, true);
+
+		for (const FGridVector& Position : Positions)
+		{
+			if (!IsValidPosition(Position) || !IsSpaceUniformAndVacant(Position, Position + ActorSize))
+			{
+				continue;
+			}
+
+			AActor* SpawnedActor = SpawnActorOnGrid_Internal(ActorClass, Position, ActorSize, nullptr, nullptr);
+			if (OutActors)
+			{
+				OutActors->Add(SpawnedActor);
+			}
+			SpawnedBounds = SpawnedBounds.Union(FGridRect(Position, Position + ActorSize));
+			++SpawnedCount;
+		}
+	}
+
+	if (SpawnedCount > 0)
+	{
+		OnOccupantsChanged.Broadcast(SpawnedBounds.Min, SpawnedBounds.Max, nullptr);
+	}
+
+	return SpawnedCount;
+}
+
 AActor* UWorldGridSubsystem::SpawnActorOnGrid_Internal(TSubclassOf<AActor> ActorClass, const FGridVector& GridPosition, const FGridVector& ActorSize, AActor* Owner, TFunction<void(AActor*)> PreFinalizeConstructionCallback)
 {
 	check(ActorClass);
@@ -300,6 +394,7 @@ AActor* UWorldGridSubsystem::SpawnActorOnGrid_Internal(TSubclassOf<AActor> Actor
 	}
 
 	GridActorAnnotations.AddAnnotation(SpawnedActor, { GridPosition, ActorSize });
+	AddChunkOccupant(SpawnedActor, FGridRect(GridPosition, GridPosition + ActorSize));
 	SetActorAtPositions(SpawnedActor, GridPosition, GridPosition + ActorSize);
 
 	return SpawnedActor;
@@ -322,47 +417,181 @@ bool UWorldGridSubsystem::RemoveActorFromGrid(AActor* Actor)
 	FGridActorAnnotation ActorGridAnnotation = GridActorAnnotations.GetAndRemoveAnnotation(Actor);
 
 	check(ActorGridAnnotation.IsValid());
+	RemoveChunkOccupant(Actor, FGridRect(ActorGridAnnotation.Position, ActorGridAnnotation.Position + ActorGridAnnotation.Size));
 	SetActorAtPositions(nullptr, ActorGridAnnotation.Position, ActorGridAnnotation.Position + ActorGridAnnotation.Size);
 
 	return true;
 }
 
+void UWorldGridSubsystem::AddChunkOccupant(AActor* Actor, const FGridRect& Rect)
+{
+	const FGridVector FirstChunk = GetChunkForGridPosition(Rect.Min);
+	const FGridVector LastChunk = GetChunkForGridPosition(FGridVector(Rect.Max.X - 1, Rect.Max.Y - 1));
+
+	for (int32 ChunkY = FirstChunk.Y; ChunkY <= LastChunk.Y; ++ChunkY)
+	{
+		for (int32 ChunkX = FirstChunk.X; ChunkX <= LastChunk.X; ++ChunkX)
+		{
+			ChunkOccupants[(ChunkY * ChunkCountPerSide) + ChunkX].Add({ Actor, Rect });
+		}
+	}
+}
+
+void UWorldGridSubsystem::RemoveChunkOccupant(AActor* Actor, const FGridRect& Rect)
+{
+	const FGridVector FirstChunk = GetChunkForGridPosition(Rect.Min);
+	const FGridVector LastChunk = GetChunkForGridPosition(FGridVector(Rect.Max.X - 1, Rect.Max.Y - 1));
+
+	for (int32 ChunkY = FirstChunk.Y; ChunkY <= LastChunk.Y; ++ChunkY)
+	{
+		for (int32 ChunkX = FirstChunk.X; ChunkX <= LastChunk.X; ++ChunkX)
+		{
+			// order within a chunk doesn't matter
+			ChunkOccupants[(ChunkY * ChunkCountPerSide) + ChunkX].RemoveAllSwap([Actor](const FChunkOccupant& Occupant) { return Occupant.Actor == Actor; }, false);
+		}
+	}
+}
+
+template<typename PredicateType>
+void UWorldGridSubsystem::ForEachActorInRect(const FGridRect& Rect, PredicateType Predicate) const
+{
+	const FGridRect ClippedRect = Rect.Intersection(FGridRect(FGridVector(0, 0), FGridVector(Config.Width)));
+	if (ClippedRect.IsEmpty())
+	{
+		return;
+	}
+
+	const FGridVector FirstChunk = GetChunkForGridPosition(ClippedRect.Min);
+	const FGridVector LastChunk = GetChunkForGridPosition(FGridVector(ClippedRect.Max.X - 1, ClippedRect.Max.Y - 1));
+
+	for (int32 ChunkY = FirstChunk.Y; ChunkY <= LastChunk.Y; ++ChunkY)
+	{
+		for (int32 ChunkX = FirstChunk.X; ChunkX <= LastChunk.X; ++ChunkX)
+		{
+			for (const FChunkOccupant& Occupant : ChunkOccupants[(ChunkY * ChunkCountPerSide) + ChunkX])
+			{
+				const FGridRect Overlap = Occupant.Rect.Intersection(ClippedRect);
+				if (Overlap.IsEmpty())
+				{
+					continue;
+				}
+
+				// an actor spanning chunks is listed in each of them. only the chunk its overlap starts in reports it, so no set is needed
+				const FGridVector OwningChunk = GetChunkForGridPosition(Overlap.Min);
+				if ((OwningChunk.X == ChunkX) && (OwningChunk.Y == ChunkY))
+				{
+					Predicate(Occupant.Actor, Occupant.Rect);
+				}
+			}
+		}
+	}
+}
+
+namespace
+{
+	bool PassesActorFilters(const AActor* Actor, TSubclassOf<AActor> ClassFilter, TSubclassOf<UInterface> InterfaceFilter)
+	{
+		return ((ClassFilter == nullptr) || Actor->IsA(ClassFilter))
+			&& ((InterfaceFilter == nullptr) || Actor->GetClass()->ImplementsInterface(InterfaceFilter));
+	}
+}
+
+void UWorldGridSubsystem::GetActorsInRect(const FGridRect& Rect, TArray<AActor*>& OutActors, TSubclassOf<AActor> ClassFilter, TSubclassOf<UInterface> InterfaceFilter) const
+{
+	OutActors.Reset();
+
+	ForEachActorInRect(Rect, [&](AActor* Actor, const FGridRect& ActorRect)
+	{
+		if (PassesActorFilters(Actor, ClassFilter, InterfaceFilter))
+		{
+			OutActors.Add(Actor);
+		}
+	});
+}
+
+void UWorldGridSubsystem::GetActorsInRadius(const FGridVector& Center, int32 Radius, TArray<AActor*>& OutActors, TSubclassOf<AActor> ClassFilter, TSubclassOf<UInterface> InterfaceFilter) const
+{
+	OutActors.Reset();
+
+	const FGridRect Bounds(FGridVector(Center.X - Radius, Center.Y - Radius), FGridVector(Center.X + Radius + 1, Center.Y + Radius + 1));
+	const int32 RadiusSquared = Radius * Radius;
+
+	ForEachActorInRect(Bounds, [&](AActor* Actor, const FGridRect& ActorRect)
+	{
+		// distance from Center to the actor's closest cell
+		const int32 DeltaX = FMath::Max3(ActorRect.Min.X - Center.X, 0, Center.X - (ActorRect.Max.X - 1));
+		const int32 DeltaY = FMath::Max3(ActorRect.Min.Y - Center.Y, 0, Center.Y - (ActorRect.Max.Y - 1));
+
+		if ((((DeltaX * DeltaX) + (DeltaY * DeltaY)) <= RadiusSquared) && PassesActorFilters(Actor, ClassFilter, InterfaceFilter))
+		{
+			OutActors.Add(Actor);
+		}
+	});
+}
+
 bool UWorldGridSubsystem::TryPlaceDigActualizerOnGrid(TSoftObjectPtr<UDigActualizer> Actualizer, const FGridVector& DesiredPosition)
 {
-	// we need to load this to know how to place it. #fixme
-	Actualizer.LoadSynchronous();
+	FDigDetectionSummary Summary;
+	if (!UDigActualizer::GetDetectionSummary(Actualizer, Summary))
+	{
+		UE_LOG(LogWorldGridSubsystem, Error, TEXT("Can't place DigActualizer '%s' on grid without a detection summary"), *Actualizer.ToString());
+		return false;
+	}
+
+	return TryPlaceDigActualizerOnGrid(Actualizer, Summary, DesiredPosition);
+}
 
-	if (!Actualizer.IsValid())
+bool UWorldGridSubsystem::TryPlaceDigActualizerOnGrid(TSoftObjectPtr<UDigActualizer> Actualizer, const FDigDetectionSummary& Summary, const FGridVector& DesiredPosition)
+{
+	if (Actualizer.IsNull() || !Summary.IsValid())
 	{
-		UE_LOG(LogWorldGridSubsystem, Error, TEXT("Can't place invalid DigActualizer on grid"));
+		UE_LOG(LogWorldGridSubsystem, Error, TEXT("Can't place invalid DigActualizer '%s' on grid"), *Actualizer.ToString());
 		return false;
 	}
 
 	if (!IsValidPosition(DesiredPosition))
 	{
-		UE_LOG(LogWorldGridSubsystem, Error, TEXT("Can't place '%s' on grid at invalid position '%s'"), *Actualizer->GetName(), *DesiredPosition.ToString());
+		UE_LOG(LogWorldGridSubsystem, Error, TEXT("Can't place '%s' on grid at invalid position '%s'"), *Actualizer.ToString(), *DesiredPosition.ToString());
 		return false;
 	}
 
 	SetDigActualizerAtPosition(Actualizer, DesiredPosition);
+	DigSummaries.Add(GetArrayIndexForGridPosition(DesiredPosition), Summary);
 
 	// #hack: set detection data. this will mess up detection for overlapping detection data
-	for (int32 Y = -Actualizer->DetectionRadius; Y <= Actualizer->DetectionRadius; ++Y)
+	SetDetectionDataInRadius(Summary.Rarity, Summary.Radius, DesiredPosition);
+
+	return true;
+}
+
+int32 UWorldGridSubsystem::PlaceDigActualizersOnGridBatch(TSoftObjectPtr<UDigActualizer> Actualizer, TArrayView<const FGridVector> Positions)
+{
+	FDigDetectionSummary Summary;
+	if (!UDigActualizer::GetDetectionSummary(Actualizer, Summary))
+	{
+		UE_LOG(LogWorldGridSubsystem, Error, TEXT("Can't place DigActualizer '%s' on grid without a detection summary"), *Actualizer.ToString());
+		return 0;
+	}
+
+	int32 PlacedCount = 0;
+	for (const FGridVector& Position : Positions)
 	{
-		for (int32 X = -Actualizer->DetectionRadius; X <= Actualizer->DetectionRadius; ++X)
+		if (IsValidPosition(Position) && GetDigActualizerAtPosition(Position).IsNull() && TryPlaceDigActualizerOnGrid(Actualizer, Summary, Position))
 		{
-			const FGridVector CurrentPosition = DesiredPosition + FGridVector(X, Y);
-			if (IsValidPosition(CurrentPosition))
-			{
-				// maybe come up with a smarter way to calculate distance
-				const int32 Distance = FMath::Max(FMath::Abs(X), FMath::Abs(Y));
-				const TTuple<int32, int32> DetectionData(Actualizer->DetectionRarity, Distance);
-				SetDetectionDataAtPosition(DetectionData, CurrentPosition);
-			}
+			++PlacedCount;
 		}
 	}
 
-	return true;
+	return PlacedCount;
+}
+
+void UWorldGridSubsystem::GetDigActualizerPositions(TArray<FGridVector>& OutPositions) const
+{
+	OutPositions.Reset(DigSummaries.Num());
+	for (const TPair<int32, FDigDetectionSummary>& Pair : DigSummaries)
+	{
+		OutPositions.Add(FGridVector(Pair.Key % Config.Width, Pair.Key / Config.Width));
+	}
 }
 
 TSoftObjectPtr<UDigActualizer> UWorldGridSubsystem::TryRemoveDigActualizerFromGrid(const FGridVector& Position)
@@ -370,26 +599,22 @@ TSoftObjectPtr<UDigActualizer> UWorldGridSubsystem::TryRemoveDigActualizerFromGr
 	if (!IsValidPosition(Position))
 	{
 		UE_LOG(LogWorldGridSubsystem, Error, TEXT("Can't remove from grid at invalid position '%s'"), *Position.ToString());
-		return false;
+		return nullptr;
 	}
 
 	TSoftObjectPtr<UDigActualizer> Actualizer = GetDigActualizerAtPosition(Position);
+	if (Actualizer.IsNull())
+	{
+		return nullptr;
+	}
+
+	SetDigActualizerAtPosition(nullptr, Position);
 
 	// #hack: nuke the detection grid. this will mess up detection for overlapping detection data
-	if (Actualizer.IsValid())
+	FDigDetectionSummary Summary;
+	if (DigSummaries.RemoveAndCopyValue(GetArrayIndexForGridPosition(Position), Summary))
 	{
-		const TTuple<int32, int32> EmptyData(0, 0);
-		for (int32 Y = -Actualizer->DetectionRadius; Y <= Actualizer->DetectionRadius; ++Y)
-		{
-			for (int32 X = -Actualizer->DetectionRadius; X <= Actualizer->DetectionRadius; ++X)
-			{
-				const FGridVector CurrentPosition = Position + FGridVector(X, Y);
-				if (IsValidPosition(CurrentPosition))
-				{
-					SetDetectionDataAtPosition(EmptyData, CurrentPosition);
-				}
-			}
-		}
+		SetDetectionDataInRadius(0, Summary.Radius, Position);
 	}
 
 	return Actualizer;
@@ -401,10 +626,121 @@ void UWorldGridSubsystem::DebugDrawPosition(const FGridVector& Position, float D
 	DrawDebugSphere(GetWorld(), DrawLocation, 50.f, 8, Color, false, DisplayTime);
 }
 
+bool UWorldGridSubsystem::GridRaycast(const FGridRay& Ray, FGridRaycastHit& OutHit) const
+{
+	OutHit = FGridRaycastHit();
+
+	// everything below is in cells, where cell X,Y covers [X, X + 1)
+	const FVector2D From(Ray.Start.X / Config.WorldScale, Ray.Start.Y / Config.WorldScale);
+	const FVector2D To(Ray.End.X / Config.WorldScale, Ray.End.Y / Config.WorldScale);
+	const FVector2D Direction = To - From;
+
+	FGridVector Cell(FMath::FloorToInt(From.X), FMath::FloorToInt(From.Y));
+	const FGridVector EndCell(FMath::FloorToInt(To.X), FMath::FloorToInt(To.Y));
+
+	const int32 StepX = (Direction.X > 0.f) ? 1 : -1;
+	const int32 StepY = (Direction.Y > 0.f) ? 1 : -1;
+
+	// how far along the segment (0 to 1) the next vertical/horizontal cell border is, and how far apart those borders are
+	const float DeltaX = (Direction.X != 0.f) ? (1.f / FMath::Abs(Direction.X)) : MAX_flt;
+	const float DeltaY = (Direction.Y != 0.f) ? (1.f / FMath::Abs(Direction.Y)) : MAX_flt;
+	float NextX = (Direction.X != 0.f) ? (((StepX > 0) ? ((Cell.X + 1) - From.X) : (From.X - Cell.X)) * DeltaX) : MAX_flt;
+	float NextY = (Direction.Y != 0.f) ? (((StepY > 0) ? ((Cell.Y + 1) - From.Y) : (From.Y - Cell.Y)) * DeltaY) : MAX_flt;
+
+	const int32 StartElevation = GetElevationAtGridPosition(Cell);
+	const int32 CellCount = FMath::Abs(EndCell.X - Cell.X) + FMath::Abs(EndCell.Y - Cell.Y);
+
+	OutHit.Cell = Cell;
+	OutHit.Location = Ray.End;
+	OutHit.VisitedCellCount = 1;
+
+	for (int32 StepIndex = 0; StepIndex < CellCount; ++StepIndex)
+	{
+		float Time;
+		const FGridVector PreviousCell = Cell;
+		if (NextX < NextY)
+		{
+			Cell.X += StepX;
+			Time = NextX;
+			NextX += DeltaX;
+		}
+		else
+		{
+			Cell.Y += StepY;
+			Time = NextY;
+			NextY += DeltaY;
+		}
+
+		if (!IsValidPosition(Cell))
+		{
+			// rays can start off the grid and come onto it, but once they've been on it and leave there's nothing more to hit
+			if (IsValidPosition(PreviousCell))
+			{
+				break;
+			}
+			continue;
+		}
+
+		++OutHit.VisitedCellCount;
+		OutHit.PreviousCell = IsValidPosition(PreviousCell) ? PreviousCell : FGridVector();
+		OutHit.Cell = Cell;
+
+		const int32 ArrayIndex = GetArrayIndexForGridPosition(Cell);
+
+		EGridRayBlock BlockedBy = EGridRayBlock::None;
+		if (EnumHasAnyFlags(Ray.BlockOn, EGridRayBlock::Occupied) && (ActorGrid[ArrayIndex] != nullptr) && (ActorGrid[ArrayIndex] != Ray.IgnoreActor))
+		{
+			BlockedBy = EGridRayBlock::Occupied;
+		}
+		else if (EnumHasAnyFlags(Ray.BlockOn, EGridRayBlock::ElevationStep) && (ElevationGrid[ArrayIndex] > StartElevation))
+		{
+			BlockedBy = EGridRayBlock::ElevationStep;
+		}
+		else if (EnumHasAnyFlags(Ray.BlockOn, EGridRayBlock::Water) && (TerrainTypeGrid[ArrayIndex] == ETerrainType::Water))
+		{
+			BlockedBy = EGridRayBlock::Water;
+		}
+
+		if (BlockedBy != EGridRayBlock::None)
+		{
+			OutHit.bBlocked = true;
+			OutHit.BlockedBy = BlockedBy;
+			OutHit.Location = FMath::Lerp(Ray.Start, Ray.End, Time);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UWorldGridSubsystem::GridRaycastBatch(const TArray<FGridRay>& Rays, TArray<FGridRaycastHit>& OutHits) const
+{
+	OutHits.SetNum(Rays.Num());
+
+	// a ray is only a few dozen cells, it takes a fair few before going wide pays for itself
+	const bool bSingleThreaded = Rays.Num() < 64;
+	ParallelFor(Rays.Num(), [this, &Rays, &OutHits](int32 RayIndex)
+	{
+		GridRaycast(Rays[RayIndex], OutHits[RayIndex]);
+	}, bSingleThreaded);
+}
+
+bool UWorldGridSubsystem::HasLineOfSight(const FGridVector& From, const FGridVector& To) const
+{
+	FGridRay Ray;
+	Ray.Start = GetWorldLocationAtGridPosition(From);
+	Ray.End = GetWorldLocationAtGridPosition(To);
+	Ray.BlockOn = EGridRayBlock::Occupied | EGridRayBlock::ElevationStep;
+
+	// whatever stands on To, or To being a cliff top, is what's being looked at, not in the way
+	FGridRaycastHit Hit;
+	return !GridRaycast(Ray, Hit) || ((Hit.Cell.X == To.X) && (Hit.Cell.Y == To.Y));
+}
+
 void UWorldGridSubsystem::SetActorAtPositions(AActor* Actor, const FGridVector& StartPosition, const FGridVector& EndPosition)
 {
 	check(IsValidPosition(StartPosition));
-	check(IsValidPosition(EndPosition));
+	check(IsValidPosition(FGridVector(EndPosition.X - 1, EndPosition.Y - 1)));
 	check(StartPosition.X < EndPosition.X);
 	check(StartPosition.Y < EndPosition.Y);
 
@@ -416,15 +752,24 @@ void UWorldGridSubsystem::SetActorAtPositions(AActor* Actor, const FGridVector&
 			ActorGrid[GetArrayIndexForGridPosition(CurrentPosition)] = Actor;
 		}
 	}
+
+	MarkRegionDirty(StartPosition, EndPosition, EWorldGridLayer::Actor);
+
+	if (!bBatchingOccupants)
+	{
+		OnOccupantsChanged.Broadcast(StartPosition, EndPosition, Actor);
+	}
 }
 
 void UWorldGridSubsystem::SetTerrainTypeAtPositions(ETerrainType TerrainType, const FGridVector& StartPosition, const FGridVector& EndPosition)
 {
 	check(IsValidPosition(StartPosition));
-	check(IsValidPosition(EndPosition));
+	check(IsValidPosition(FGridVector(EndPosition.X - 1, EndPosition.Y - 1)));
 	check(StartPosition.X < EndPosition.X);
 	check(StartPosition.Y < EndPosition.Y);
 
+	RecordTransactionWrite(StartPosition, EndPosition);
+
 	for (int32 Y = StartPosition.Y; Y < EndPosition.Y; ++Y)
 	{
 		for (int32 X = StartPosition.X; X < EndPosition.X; ++X)
@@ -433,15 +778,19 @@ void UWorldGridSubsystem::SetTerrainTypeAtPositions(ETerrainType TerrainType, co
 			TerrainTypeGrid[GetArrayIndexForGridPosition(CurrentPosition)] = TerrainType;
 		}
 	}
+
+	MarkRegionDirty(StartPosition, EndPosition, EWorldGridLayer::Terrain);
 }
 
 void UWorldGridSubsystem::SetElevationAtPositions(int32 Elevation, const FGridVector& StartPosition, const FGridVector& EndPosition)
 {
 	check(IsValidPosition(StartPosition));
-	check(IsValidPosition(EndPosition));
+	check(IsValidPosition(FGridVector(EndPosition.X - 1, EndPosition.Y - 1)));
 	check(StartPosition.X < EndPosition.X);
 	check(StartPosition.Y < EndPosition.Y);
 
+	RecordTransactionWrite(StartPosition, EndPosition);
+
 	for (int32 Y = StartPosition.Y; Y < EndPosition.Y; ++Y)
 	{
 		for (int32 X = StartPosition.X; X < EndPosition.X; ++X)
@@ -450,6 +799,24 @@ void UWorldGridSubsystem::SetElevationAtPositions(int32 Elevation, const FGridVe
 			ElevationGrid[GetArrayIndexForGridPosition(CurrentPosition)] = Elevation;
 		}
 	}
+
+	MarkRegionDirty(StartPosition, EndPosition, EWorldGridLayer::Elevation);
+}
+
+void UWorldGridSubsystem::SetReservationAtPositions(int32 ReservationToken, const FGridVector& StartPosition, const FGridVector& EndPosition)
+{
+	check(IsValidPosition(StartPosition));
+	check(IsValidPosition(FGridVector(EndPosition.X - 1, EndPosition.Y - 1)));
+
+	for (int32 Y = StartPosition.Y; Y < EndPosition.Y; ++Y)
+	{
+		for (int32 X = StartPosition.X; X < EndPosition.X; ++X)
+		{
+			ReservationGrid[GetArrayIndexForGridPosition(FGridVector(X, Y))] = ReservationToken;
+		}
+	}
+
+	MarkRegionDirty(StartPosition, EndPosition, EWorldGridLayer::Reservation);
 }
 
 void UWorldGridSubsystem::SetDigActualizerAtPosition(TSoftObjectPtr<UDigActualizer> DigActualizer, const FGridVector& Position)
@@ -457,6 +824,7 @@ void UWorldGridSubsystem::SetDigActualizerAtPosition(TSoftObjectPtr<UDigActualiz
 	check(IsValidPosition(Position));
 
 	DigGrid[GetArrayIndexForGridPosition(Position)] = DigActualizer;
+	MarkRegionDirty(Position, Position + FGridVector(1), EWorldGridLayer::Dig);
 }
 
 void UWorldGridSubsystem::SetDetectionDataAtPosition(const TTuple<int32, int32>& DetectionData, const FGridVector& Position)
@@ -464,6 +832,24 @@ void UWorldGridSubsystem::SetDetectionDataAtPosition(const TTuple<int32, int32>&
 	check(IsValidPosition(Position));
 
 	DetectionGrid[GetArrayIndexForGridPosition(Position)] = DetectionData;
+	MarkRegionDirty(Position, Position + FGridVector(1), EWorldGridLayer::Detection);
+}
+
+void UWorldGridSubsystem::SetDetectionDataInRadius(int32 Rarity, int32 Radius, const FGridVector& Position)
+{
+	for (int32 Y = -Radius; Y <= Radius; ++Y)
+	{
+		for (int32 X = -Radius; X <= Radius; ++X)
+		{
+			const FGridVector CurrentPosition = Position + FGridVector(X, Y);
+			if (IsValidPosition(CurrentPosition))
+			{
+				// maybe come up with a smarter way to calculate distance
+				const int32 Distance = (Rarity > 0) ? FMath::Max(FMath::Abs(X), FMath::Abs(Y)) : 0;
+				SetDetectionDataAtPosition(TTuple<int32, int32>(Rarity, Distance), CurrentPosition);
+			}
+		}
+	}
 }
 
 int32 UWorldGridSubsystem::GetArrayIndexForGridPosition(const FGridVector& Position) const
@@ -478,3 +864,843 @@ int32 UWorldGridSubsystem::GetArrayIndexForGridPosition(const FGridVector& Posit
 	}
 }
 
+FGridRect UWorldGridSubsystem::GetChunkRect(const FGridVector& Chunk) const
+{
+	const FGridVector Min(Chunk.X * GridChunkSize, Chunk.Y * GridChunkSize);
+	const FGridVector Max(FMath::Min(Min.X + GridChunkSize, Config.Width), FMath::Min(Min.Y + GridChunkSize, Config.Width));
+	return { Min, Max };
+}
+
+void UWorldGridSubsystem::MarkRegionDirty(const FGridVector& StartPosition, const FGridVector& EndPosition, EWorldGridLayer Layer)
+{
+	const FGridRect Region(StartPosition, EndPosition);
+	const int32 LayerIndex = FMath::CountTrailingZeros(static_cast<uint32>(Layer));
+	check(LayerIndex < WorldGridLayerCount);
+
+	const FGridVector FirstChunk = GetChunkForGridPosition(StartPosition);
+	const FGridVector LastChunk = GetChunkForGridPosition(FGridVector(EndPosition.X - 1, EndPosition.Y - 1));
+
+	for (int32 ChunkY = FirstChunk.Y; ChunkY <= LastChunk.Y; ++ChunkY)
+	{
+		for (int32 ChunkX = FirstChunk.X; ChunkX <= LastChunk.X; ++ChunkX)
+		{
+			const int32 ChunkIndex = (ChunkY * ChunkCountPerSide) + ChunkX;
+			if (DirtyChunkLayers[ChunkIndex] == EWorldGridLayer::None)
+			{
+				DirtyChunks.Add(ChunkIndex);
+				DirtyChunkRects[ChunkIndex] = FGridRect();
+			}
+
+			DirtyChunkRects[ChunkIndex] = DirtyChunkRects[ChunkIndex].Union(Region.Intersection(GetChunkRect(FGridVector(ChunkX, ChunkY))));
+			DirtyChunkLayers[ChunkIndex] |= Layer;
+
+			FPlatformAtomics::InterlockedIncrement(&ChunkLayerVersions[(ChunkIndex * WorldGridLayerCount) + LayerIndex]);
+		}
+	}
+}
+
+int32 UWorldGridSubsystem::GetChunkVersion(const FGridVector& Chunk, EWorldGridLayer Layers) const
+{
+	if ((Chunk.X < 0) || (Chunk.X >= ChunkCountPerSide) || (Chunk.Y < 0) || (Chunk.Y >= ChunkCountPerSide))
+	{
+		return 0;
+	}
+
+	const int32* Versions = &ChunkLayerVersions[((Chunk.Y * ChunkCountPerSide) + Chunk.X) * WorldGridLayerCount];
+
+	int32 Version = 0;
+	for (int32 LayerIndex = 0; LayerIndex < WorldGridLayerCount; ++LayerIndex)
+	{
+		if (EnumHasAnyFlags(Layers, static_cast<EWorldGridLayer>(1 << LayerIndex)))
+		{
+			Version += FPlatformAtomics::AtomicRead(&Versions[LayerIndex]);
+		}
+	}
+	return Version;
+}
+
+int64 UWorldGridSubsystem::GetRegionVersion(const FGridRect& Region, EWorldGridLayer Layers) const
+{
+	const FGridRect ClippedRegion = Region.Intersection(FGridRect(FGridVector(0, 0), FGridVector(Config.Width)));
+	if (ClippedRegion.IsEmpty())
+	{
+		return 0;
+	}
+
+	const FGridVector FirstChunk = GetChunkForGridPosition(ClippedRegion.Min);
+	const FGridVector LastChunk = GetChunkForGridPosition(FGridVector(ClippedRegion.Max.X - 1, ClippedRegion.Max.Y - 1));
+
+	int64 Version = 0;
+	for (int32 ChunkY = FirstChunk.Y; ChunkY <= LastChunk.Y; ++ChunkY)
+	{
+		for (int32 ChunkX = FirstChunk.X; ChunkX <= LastChunk.X; ++ChunkX)
+		{
+			Version += GetChunkVersion(FGridVector(ChunkX, ChunkY), Layers);
+		}
+	}
+	return Version;
+}
+
+void UWorldGridSubsystem::GetChunkVersions(const FGridRect& Region, EWorldGridLayer Layers, TArray<int32>& OutVersions) const
+{
+	OutVersions.Reset();
+
+	const FGridRect ClippedRegion = Region.Intersection(FGridRect(FGridVector(0, 0), FGridVector(Config.Width)));
+	if (ClippedRegion.IsEmpty())
+	{
+		return;
+	}
+
+	const FGridVector FirstChunk = GetChunkForGridPosition(ClippedRegion.Min);
+	const FGridVector LastChunk = GetChunkForGridPosition(FGridVector(ClippedRegion.Max.X - 1, ClippedRegion.Max.Y - 1));
+
+	OutVersions.Reserve((LastChunk.X - FirstChunk.X + 1) * (LastChunk.Y - FirstChunk.Y + 1));
+	for (int32 ChunkY = FirstChunk.Y; ChunkY <= LastChunk.Y; ++ChunkY)
+	{
+		for (int32 ChunkX = FirstChunk.X; ChunkX <= LastChunk.X; ++ChunkX)
+		{
+			OutVersions.Add(GetChunkVersion(FGridVector(ChunkX, ChunkY), Layers));
+		}
+	}
+}
+
+FWorldGridSnapshotPtr UWorldGridSubsystem::GetSnapshot()
+{
+	check(IsInGameThread());
+
+	const int32 ChunkCount = ChunkCountPerSide * ChunkCountPerSide;
+
+	TSharedPtr<FWorldGridSnapshot, ESPMode::ThreadSafe> Snapshot;
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkCount; ++ChunkIndex)
+	{
+		const FGridVector Chunk(ChunkIndex % ChunkCountPerSide, ChunkIndex / ChunkCountPerSide);
+		const int32 Version = GetChunkVersion(Chunk, FWorldGridSnapshot::Layers);
+
+		const FWorldGridSnapshotChunkPtr* PreviousChunk = LatestSnapshot.IsValid() ? &LatestSnapshot->Chunks[ChunkIndex] : nullptr;
+		if (PreviousChunk && ((*PreviousChunk)->Version == Version))
+		{
+			if (Snapshot.IsValid())
+			{
+				Snapshot->Chunks[ChunkIndex] = *PreviousChunk;
+			}
+			continue;
+		}
+
+		// first stale chunk. everything before it is shared with the previous snapshot
+		if (!Snapshot.IsValid())
+		{
+			Snapshot = MakeShared<FWorldGridSnapshot, ESPMode::ThreadSafe>();
+			Snapshot->Width = Config.Width;
+			Snapshot->ChunkCountPerSide = ChunkCountPerSide;
+			Snapshot->Chunks.SetNum(ChunkCount);
+			for (int32 SharedIndex = 0; SharedIndex < ChunkIndex; ++SharedIndex)
+			{
+				Snapshot->Chunks[SharedIndex] = LatestSnapshot->Chunks[SharedIndex];
+			}
+		}
+
+		Snapshot->Chunks[ChunkIndex] = BuildSnapshotChunk(Chunk, Version);
+	}
+
+	// nothing was written since the last snapshot, hand out the same one
+	if (Snapshot.IsValid())
+	{
+		LatestSnapshot = Snapshot;
+	}
+
+	return LatestSnapshot;
+}
+
+FWorldGridSnapshotChunkPtr UWorldGridSubsystem::BuildSnapshotChunk(const FGridVector& Chunk, int32 Version) const
+{
+	TSharedRef<FWorldGridSnapshotChunk, ESPMode::ThreadSafe> SnapshotChunk = MakeShared<FWorldGridSnapshotChunk, ESPMode::ThreadSafe>();
+	SnapshotChunk->Rect = GetChunkRect(Chunk);
+	SnapshotChunk->Version = Version;
+
+	const FGridRect& Rect = SnapshotChunk->Rect;
+	const int32 RowWidth = Rect.Width();
+	const int32 CellCount = RowWidth * Rect.Height();
+
+	SnapshotChunk->Elevation.SetNumUninitialized(CellCount);
+	SnapshotChunk->TerrainType.SetNumUninitialized(CellCount);
+	SnapshotChunk->DetectionData.SetNumUninitialized(CellCount);
+	SnapshotChunk->Occupied.Init(false, CellCount);
+	SnapshotChunk->HasActor.Init(false, CellCount);
+
+	for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; ++Y)
+	{
+		const int32 SourceIndex = GetArrayIndexForGridPosition(FGridVector(Rect.Min.X, Y));
+		const int32 LocalIndex = (Y - Rect.Min.Y) * RowWidth;
+
+		FMemory::Memcpy(&SnapshotChunk->Elevation[LocalIndex], &ElevationGrid[SourceIndex], RowWidth * sizeof(int32));
+		FMemory::Memcpy(&SnapshotChunk->TerrainType[LocalIndex], &TerrainTypeGrid[SourceIndex], RowWidth * sizeof(ETerrainType));
+
+		for (int32 X = 0; X < RowWidth; ++X)
+		{
+			SnapshotChunk->DetectionData[LocalIndex + X] = DetectionGrid[SourceIndex + X];
+			if ((ActorGrid[SourceIndex + X] != nullptr) || (ReservationGrid[SourceIndex + X] != 0))
+			{
+				SnapshotChunk->Occupied[LocalIndex + X] = true;
+				SnapshotChunk->HasActor[LocalIndex + X] = (ActorGrid[SourceIndex + X] != nullptr);
+			}
+		}
+	}
+
+	return SnapshotChunk;
+}
+
+void UWorldGridSubsystem::EnqueueCommand(FWorldGridCommand&& Command)
+{
+	PendingCommands.Enqueue(MoveTemp(Command));
+}
+
+int32 UWorldGridSubsystem::NewReservationToken()
+{
+	static int32 LastReservationToken = 0;
+
+	int32 Token = FPlatformAtomics::InterlockedIncrement(&LastReservationToken);
+	while (Token == 0)
+	{
+		Token = FPlatformAtomics::InterlockedIncrement(&LastReservationToken);
+	}
+	return Token;
+}
+
+EWorldGridCommandResult UWorldGridSubsystem::ApplyCommandImmediate(const FWorldGridCommand& Command)
+{
+	check(IsInGameThread());
+
+	const EWorldGridCommandResult Result = ApplyCommand(Command);
+	if (Command.OnApplied)
+	{
+		Command.OnApplied(Result);
+	}
+	return Result;
+}
+
+namespace
+{
+	// terrain restored under an actor placed since would leave it standing on something it couldn't have been placed on
+	const EWorldGridLayer UndoConflictLayers = EWorldGridLayer::Elevation | EWorldGridLayer::Terrain | EWorldGridLayer::Actor;
+}
+
+void UWorldGridSubsystem::BeginTransaction()
+{
+	check(IsInGameThread());
+
+	if (TransactionDepth++ == 0)
+	{
+		OpenTransaction = FTransaction();
+		OpenTransactionChunks.Init(false, ChunkCountPerSide * ChunkCountPerSide);
+	}
+}
+
+void UWorldGridSubsystem::EndTransaction()
+{
+	check(TransactionDepth > 0);
+
+	if (--TransactionDepth > 0)
+	{
+		return;
+	}
+
+	if (OpenTransaction.Before.Num() == 0)
+	{
+		return;
+	}
+
+	// after-images are taken once at the end so redo is a copy as well
+	OpenTransaction.After.SetNum(OpenTransaction.Before.Num());
+	for (int32 ImageIndex = 0; ImageIndex < OpenTransaction.Before.Num(); ++ImageIndex)
+	{
+		CaptureChunkImage(OpenTransaction.Before[ImageIndex].ChunkIndex, OpenTransaction.After[ImageIndex]);
+		OpenTransaction.AllocatedSize += OpenTransaction.Before[ImageIndex].GetAllocatedSize() + OpenTransaction.After[ImageIndex].GetAllocatedSize();
+	}
+	StampChunkImageVersions(OpenTransaction.After);
+
+	for (const FTransaction& Transaction : RedoStack)
+	{
+		HistorySize -= Transaction.AllocatedSize;
+	}
+	RedoStack.Reset();
+
+	HistorySize += OpenTransaction.AllocatedSize;
+	UndoStack.Add(MoveTemp(OpenTransaction));
+	OpenTransaction = FTransaction();
+
+	TrimHistory();
+}
+
+bool UWorldGridSubsystem::Undo()
+{
+	if ((TransactionDepth > 0) || (UndoStack.Num() == 0))
+	{
+		return false;
+	}
+
+	if (!AreChunkImagesCurrent(UndoStack.Last().After))
+	{
+		UE_LOG(LogWorldGridSubsystem, Warning, TEXT("Can't undo, the grid has changed under the last transaction since it was made"));
+		return false;
+	}
+
+	FTransaction Transaction = UndoStack.Pop(false);
+	RestoreTransactionImages(Transaction.Before, UndoStack, true);
+	RedoStack.Add(MoveTemp(Transaction));
+	return true;
+}
+
+bool UWorldGridSubsystem::Redo()
+{
+	if ((TransactionDepth > 0) || (RedoStack.Num() == 0))
+	{
+		return false;
+	}
+
+	if (!AreChunkImagesCurrent(RedoStack.Last().Before))
+	{
+		UE_LOG(LogWorldGridSubsystem, Warning, TEXT("Can't redo, the grid has changed under the last undone transaction since it was undone"));
+		return false;
+	}
+
+	FTransaction Transaction = RedoStack.Pop(false);
+	RestoreTransactionImages(Transaction.After, RedoStack, false);
+	UndoStack.Add(MoveTemp(Transaction));
+	return true;
+}
+
+bool UWorldGridSubsystem::ImportLayers(const TArray<int32>& Elevation, const TArray<ETerrainType>& TerrainType)
+{
+	check(IsInGameThread());
+
+	const int32 GridSize = Config.Width * Config.Width;
+	if ((Elevation.Num() != GridSize) || (TerrainType.Num() != GridSize))
+	{
+		UE_LOG(LogWorldGridSubsystem, Error, TEXT("ImportLayers: expected %d cells, got %d elevation and %d terrain."), GridSize, Elevation.Num(), TerrainType.Num());
+		return false;
+	}
+
+	if (TransactionDepth > 0)
+	{
+		UE_LOG(LogWorldGridSubsystem, Error, TEXT("ImportLayers: can't import inside a transaction."));
+		return false;
+	}
+
+	FMemory::Memcpy(ElevationGrid.GetData(), Elevation.GetData(), GridSize * sizeof(int32));
+	FMemory::Memcpy(TerrainTypeGrid.GetData(), TerrainType.GetData(), GridSize * sizeof(ETerrainType));
+
+	MarkRegionDirty(FGridVector(0, 0), FGridVector(Config.Width), EWorldGridLayer::Elevation);
+	MarkRegionDirty(FGridVector(0, 0), FGridVector(Config.Width), EWorldGridLayer::Terrain);
+
+	ClearHistory();
+	return true;
+}
+
+bool UWorldGridSubsystem::GenerateIsland(const FWorldGridGeneratorConfig& Settings)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	FWorldGridGeneratedLayers Layers;
+	FWorldGridGenerator::Generate(Settings, Config.Width, Layers);
+
+	const double GeneratedTime = FPlatformTime::Seconds();
+	if (!ImportLayers(Layers.Elevation, Layers.TerrainType))
+	{
+		return false;
+	}
+
+	UE_LOG(LogWorldGridSubsystem, Log, TEXT("Generated a %dx%d island from seed %d in %.2fms, imported in %.2fms."),
+		Config.Width, Config.Width, Settings.Seed, (GeneratedTime - StartTime) * 1000.0, (FPlatformTime::Seconds() - GeneratedTime) * 1000.0);
+	return true;
+}
+
+int32 UWorldGridSubsystem::ScatterFromRules(const TArray<FWorldGridScatterRule>& Rules, int32 Seed)
+{
+	check(IsInGameThread());
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// footprints are read here since the sampler can't touch assets
+	TArray<FGridVector> Sizes;
+	Sizes.Reserve(Rules.Num());
+	for (const FWorldGridScatterRule& Rule : Rules)
+	{
+		const IWorldGridInterface* WorldGridInterface = Cast<IWorldGridInterface>(Rule.Asset);
+		Sizes.Add(WorldGridInterface ? WorldGridInterface->GetWorldGridSize() : FGridVector(1));
+	}
+
+	TArray<TArray<FGridVector>> Positions;
+	FWorldGridScatter::Scatter(*GetSnapshot(), Rules, Sizes, Seed, Positions);
+
+	const double SampledTime = FPlatformTime::Seconds();
+
+	int32 PlacedCount = 0;
+	for (int32 RuleIndex = 0; RuleIndex < Rules.Num(); ++RuleIndex)
+	{
+		const FWorldGridScatterRule& Rule = Rules[RuleIndex];
+		if (Rule.Asset)
+		{
+			if (Rule.Asset->GetLoadedActorClass())
+			{
+				PlacedCount += SpawnActorsOnGridBatch(Rule.Asset, Positions[RuleIndex]);
+				continue;
+			}
+
+			// positions are checked again when they're spawned, so anything placed there in the meantime just wins
+			PlacedCount += Positions[RuleIndex].Num();
+			TWeakObjectPtr<UWorldGridSubsystem> WeakThis(this);
+			TWeakObjectPtr<const UAEMetaAsset> WeakAsset(Rule.Asset);
+			Rule.Asset->GetActorClassAsync(FOnActorClassLoaded::CreateLambda([WeakThis, WeakAsset, RulePositions = MoveTemp(Positions[RuleIndex])](TSubclassOf<AActor> ActorClass)
+			{
+				UWorldGridSubsystem* WorldGrid = WeakThis.Get();
+				if ((WorldGrid == nullptr) || !WeakAsset.IsValid())
+				{
+					return;
+				}
+
+				if (ActorClass == nullptr)
+				{
+					UE_LOG(LogWorldGridSubsystem, Warning, TEXT("Couldn't scatter '%s', its actor class failed to load"), *WeakAsset->GetName());
+					return;
+				}
+				WorldGrid->SpawnActorsOnGridBatch(WeakAsset.Get(), RulePositions);
+			}));
+		}
+		else if (!Rule.Actualizer.IsNull())
+		{
+			PlacedCount += PlaceDigActualizersOnGridBatch(Rule.Actualizer, Positions[RuleIndex]);
+		}
+		else
+		{
+			UE_LOG(LogWorldGridSubsystem, Warning, TEXT("Scatter rule %d has neither an asset nor an actualizer."), RuleIndex);
+		}
+	}
+
+	UE_LOG(LogWorldGridSubsystem, Log, TEXT("Scattered %d things from %d rules with seed %d: sampled in %.2fms, placed in %.2fms."),
+		PlacedCount, Rules.Num(), Seed, (SampledTime - StartTime) * 1000.0, (FPlatformTime::Seconds() - SampledTime) * 1000.0);
+	return PlacedCount;
+}
+
+void UWorldGridSubsystem::OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params)
+{
+	if (Params.World != GetWorld())
+	{
+		return;
+	}
+
+	FWorldDelegates::OnWorldInitializedActors.Remove(InitializedActorsHandle);
+	InitializedActorsHandle.Reset();
+
+	ScatterFromRules(Config.Scatter.Rules, Config.Scatter.Seed);
+}
+
+void UWorldGridSubsystem::ClearHistory()
+{
+	UndoStack.Empty();
+	RedoStack.Empty();
+	HistorySize = 0;
+}
+
+void UWorldGridSubsystem::RecordTransactionWrite(const FGridVector& StartPosition, const FGridVector& EndPosition)
+{
+	if (TransactionDepth == 0)
+	{
+		// #note: writes outside of a transaction aren't recorded. they bump the chunk version though, so undo won't revert them
+		return;
+	}
+
+	const FGridVector FirstChunk = GetChunkForGridPosition(StartPosition);
+	const FGridVector LastChunk = GetChunkForGridPosition(FGridVector(EndPosition.X - 1, EndPosition.Y - 1));
+
+	for (int32 ChunkY = FirstChunk.Y; ChunkY <= LastChunk.Y; ++ChunkY)
+	{
+		for (int32 ChunkX = FirstChunk.X; ChunkX <= LastChunk.X; ++ChunkX)
+		{
+			const int32 ChunkIndex = (ChunkY * ChunkCountPerSide) + ChunkX;
+			if (!OpenTransactionChunks[ChunkIndex])
+			{
+				OpenTransactionChunks[ChunkIndex] = true;
+				FChunkImage& Image = OpenTransaction.Before.AddDefaulted_GetRef();
+				CaptureChunkImage(ChunkIndex, Image);
+				Image.Version = GetChunkVersion(FGridVector(ChunkX, ChunkY), UndoConflictLayers);
+			}
+		}
+	}
+}
+
+void UWorldGridSubsystem::CaptureChunkImage(int32 ChunkIndex, FChunkImage& OutImage) const
+{
+	const FGridRect Rect = GetChunkRect(FGridVector(ChunkIndex % ChunkCountPerSide, ChunkIndex / ChunkCountPerSide));
+	const int32 RowWidth = Rect.Width();
+
+	OutImage.ChunkIndex = ChunkIndex;
+	OutImage.Elevation.SetNumUninitialized(RowWidth * Rect.Height());
+	OutImage.TerrainType.SetNumUninitialized(RowWidth * Rect.Height());
+
+	for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; ++Y)
+	{
+		const int32 SourceIndex = GetArrayIndexForGridPosition(FGridVector(Rect.Min.X, Y));
+		const int32 LocalIndex = (Y - Rect.Min.Y) * RowWidth;
+		FMemory::Memcpy(&OutImage.Elevation[LocalIndex], &ElevationGrid[SourceIndex], RowWidth * sizeof(int32));
+		FMemory::Memcpy(&OutImage.TerrainType[LocalIndex], &TerrainTypeGrid[SourceIndex], RowWidth * sizeof(ETerrainType));
+	}
+}
+
+void UWorldGridSubsystem::RestoreChunkImages(const TArray<FChunkImage>& Images)
+{
+	for (const FChunkImage& Image : Images)
+	{
+		const FGridRect Rect = GetChunkRect(FGridVector(Image.ChunkIndex % ChunkCountPerSide, Image.ChunkIndex / ChunkCountPerSide));
+		const int32 RowWidth = Rect.Width();
+
+		for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; ++Y)
+		{
+			const int32 DestIndex = GetArrayIndexForGridPosition(FGridVector(Rect.Min.X, Y));
+			const int32 LocalIndex = (Y - Rect.Min.Y) * RowWidth;
+			FMemory::Memcpy(&ElevationGrid[DestIndex], &Image.Elevation[LocalIndex], RowWidth * sizeof(int32));
+			FMemory::Memcpy(&TerrainTypeGrid[DestIndex], &Image.TerrainType[LocalIndex], RowWidth * sizeof(ETerrainType));
+		}
+
+		MarkRegionDirty(Rect.Min, Rect.Max, EWorldGridLayer::Elevation);
+		MarkRegionDirty(Rect.Min, Rect.Max, EWorldGridLayer::Terrain);
+	}
+}
+
+bool UWorldGridSubsystem::AreChunkImagesCurrent(const TArray<FChunkImage>& Images) const
+{
+	for (const FChunkImage& Image : Images)
+	{
+		const FGridVector Chunk(Image.ChunkIndex % ChunkCountPerSide, Image.ChunkIndex / ChunkCountPerSide);
+		if (GetChunkVersion(Chunk, UndoConflictLayers) != Image.Version)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void UWorldGridSubsystem::StampChunkImageVersions(TArray<FChunkImage>& Images) const
+{
+	for (FChunkImage& Image : Images)
+	{
+		const FGridVector Chunk(Image.ChunkIndex % ChunkCountPerSide, Image.ChunkIndex / ChunkCountPerSide);
+		Image.Version = GetChunkVersion(Chunk, UndoConflictLayers);
+	}
+}
+
+void UWorldGridSubsystem::RestoreTransactionImages(TArray<FChunkImage>& Images, TArray<FTransaction>& Stack, bool bStackAfterImages)
+{
+	RestoreChunkImages(Images);
+
+	for (FChunkImage& Image : Images)
+	{
+		const int32 NewVersion = GetChunkVersion(FGridVector(Image.ChunkIndex % ChunkCountPerSide, Image.ChunkIndex / ChunkCountPerSide), UndoConflictLayers);
+
+		// the chunk is back to what it was at Image.Version. whichever transaction last left it there now expects the new version
+		for (int32 StackIndex = Stack.Num() - 1; StackIndex >= 0; --StackIndex)
+		{
+			TArray<FChunkImage>& StackImages = bStackAfterImages ? Stack[StackIndex].After : Stack[StackIndex].Before;
+			if (FChunkImage* StackImage = StackImages.FindByPredicate([&Image](const FChunkImage& Other) { return Other.ChunkIndex == Image.ChunkIndex; }))
+			{
+				if (StackImage->Version == Image.Version)
+				{
+					StackImage->Version = NewVersion;
+				}
+				break;
+			}
+		}
+
+		Image.Version = NewVersion;
+	}
+}
+
+void UWorldGridSubsystem::TrimHistory()
+{
+	const SIZE_T Budget = static_cast<SIZE_T>(Config.UndoMemoryBudgetKB) * 1024;
+
+	int32 TrimCount = 0;
+	while ((HistorySize > Budget) && (TrimCount < UndoStack.Num()))
+	{
+		HistorySize -= UndoStack[TrimCount].AllocatedSize;
+		++TrimCount;
+	}
+
+	if (TrimCount > 0)
+	{
+		UE_LOG(LogWorldGridSubsystem, Verbose, TEXT("Trimmed %d undo transactions to stay in budget"), TrimCount);
+		UndoStack.RemoveAt(0, TrimCount);
+	}
+}
+
+bool UWorldGridSubsystem::TryReserveCells(const FGridRect& Rect, int32 ReservationToken)
+{
+	check(IsInGameThread());
+	return ApplyCommand(FWorldGridCommand::ReserveCells(Rect, ReservationToken)) == EWorldGridCommandResult::Applied;
+}
+
+void UWorldGridSubsystem::ReleaseCells(const FGridRect& Rect, int32 ReservationToken)
+{
+	check(IsInGameThread());
+	ApplyCommand(FWorldGridCommand::ReleaseCells(Rect, ReservationToken));
+}
+
+int32 UWorldGridSubsystem::GetReservationAtPosition(const FGridVector& Position) const
+{
+	return IsValidPosition(Position) ? ReservationGrid[GetArrayIndexForGridPosition(Position)] : 0;
+}
+
+void UWorldGridSubsystem::ApplyCommands()
+{
+	FWorldGridCommand Command;
+	while (PendingCommands.Dequeue(Command))
+	{
+		const EWorldGridCommandResult Result = ApplyCommand(Command);
+		if (Result != EWorldGridCommandResult::Applied)
+		{
+			UE_LOG(LogWorldGridSubsystem, Verbose, TEXT("Grid command on '%s' rejected with '%s'"), *Command.Rect.ToString(), *UEnum::GetValueAsString(Result));
+		}
+
+		if (Command.OnApplied)
+		{
+			Command.OnApplied(Result);
+		}
+	}
+}
+
+EWorldGridCommandResult UWorldGridSubsystem::ApplyCommand(const FWorldGridCommand& Command)
+{
+	const FGridRect& Rect = Command.Rect;
+	if (Rect.IsEmpty())
+	{
+		return EWorldGridCommandResult::Invalid;
+	}
+
+	if (!IsValidPosition(Rect.Min) || !IsValidPosition(FGridVector(Rect.Max.X - 1, Rect.Max.Y - 1)))
+	{
+		return EWorldGridCommandResult::OutOfBounds;
+	}
+
+	switch (Command.Type)
+	{
+	case EWorldGridCommandType::SetTerrainRect:
+		if (IsRectBlocked(Rect, Command.ReservationToken))
+		{
+			return EWorldGridCommandResult::Conflict;
+		}
+		SetTerrainTypeAtPositions(Command.TerrainType, Rect.Min, Rect.Max);
+		return EWorldGridCommandResult::Applied;
+
+	case EWorldGridCommandType::SetElevationRect:
+		if (IsRectBlocked(Rect, Command.ReservationToken))
+		{
+			return EWorldGridCommandResult::Conflict;
+		}
+		SetElevationAtPositions(Command.Elevation, Rect.Min, Rect.Max);
+		return EWorldGridCommandResult::Applied;
+
+	case EWorldGridCommandType::PlaceDigActualizer:
+		if (!GetDigActualizerAtPosition(Rect.Min).IsNull() || (GetActorAtGridPosition(Rect.Min) != nullptr))
+		{
+			return EWorldGridCommandResult::Conflict;
+		}
+		{
+			// the summary may come from the asset registry, which only the game thread can ask
+			const bool bPlaced = Command.DigSummary.IsValid()
+				? TryPlaceDigActualizerOnGrid(Command.DigActualizer, Command.DigSummary, Rect.Min)
+				: TryPlaceDigActualizerOnGrid(Command.DigActualizer, Rect.Min);
+			return bPlaced ? EWorldGridCommandResult::Applied : EWorldGridCommandResult::Invalid;
+		}
+
+	case EWorldGridCommandType::ReserveCells:
+		if (Command.ReservationToken == 0)
+		{
+			return EWorldGridCommandResult::Invalid;
+		}
+		if (IsRectBlocked(Rect, Command.ReservationToken))
+		{
+			return EWorldGridCommandResult::Conflict;
+		}
+		SetReservationAtPositions(Command.ReservationToken, Rect.Min, Rect.Max);
+		return EWorldGridCommandResult::Applied;
+
+	case EWorldGridCommandType::ReleaseCells:
+	{
+		if (Command.ReservationToken == 0)
+		{
+			return EWorldGridCommandResult::Invalid;
+		}
+
+		// only release what this token holds, someone else may have reserved part of the rect since
+		bool bReleasedAny = false;
+		for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; ++Y)
+		{
+			for (int32 X = Rect.Min.X; X < Rect.Max.X; ++X)
+			{
+				const FGridVector CurrentPosition(X, Y);
+				if (GetReservationAtPosition(CurrentPosition) == Command.ReservationToken)
+				{
+					SetReservationAtPositions(0, CurrentPosition, FGridVector(X + 1, Y + 1));
+					bReleasedAny = true;
+				}
+			}
+		}
+		return bReleasedAny ? EWorldGridCommandResult::Applied : EWorldGridCommandResult::Conflict;
+	}
+
+	default:
+		return EWorldGridCommandResult::Invalid;
+	}
+}
+
+bool UWorldGridSubsystem::IsRectBlocked(const FGridRect& Rect, int32 AllowedToken) const
+{
+	for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; ++Y)
+	{
+		for (int32 X = Rect.Min.X; X < Rect.Max.X; ++X)
+		{
+			const int32 ArrayIndex = GetArrayIndexForGridPosition(FGridVector(X, Y));
+			const int32 Reservation = ReservationGrid[ArrayIndex];
+			if ((ActorGrid[ArrayIndex] != nullptr) || ((Reservation != 0) && (Reservation != AllowedToken)))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+FDelegateHandle UWorldGridSubsystem::Subscribe(const FGridRect& Region, EWorldGridLayer Layers, FOnWorldGridChanged Delegate)
+{
+	FSubscription Subscription;
+	Subscription.Region = Region;
+	Subscription.Layers = Layers;
+	Subscription.Delegate = MoveTemp(Delegate);
+	return AddSubscription(MoveTemp(Subscription));
+}
+
+FDelegateHandle UWorldGridSubsystem::SubscribeToChunks(const TArray<FGridVector>& Chunks, EWorldGridLayer Layers, FOnWorldGridChanged Delegate)
+{
+	FSubscription Subscription;
+	Subscription.Layers = Layers;
+	Subscription.Delegate = MoveTemp(Delegate);
+	Subscription.ChunkMask.Init(false, ChunkCountPerSide * ChunkCountPerSide);
+
+	for (const FGridVector& Chunk : Chunks)
+	{
+		if ((Chunk.X >= 0) && (Chunk.X < ChunkCountPerSide) && (Chunk.Y >= 0) && (Chunk.Y < ChunkCountPerSide))
+		{
+			Subscription.ChunkMask[(Chunk.Y * ChunkCountPerSide) + Chunk.X] = true;
+			Subscription.Region = Subscription.Region.Union(GetChunkRect(Chunk));
+		}
+	}
+
+	return AddSubscription(MoveTemp(Subscription));
+}
+
+FDelegateHandle UWorldGridSubsystem::AddSubscription(FSubscription&& Subscription)
+{
+	Subscription.Handle = FDelegateHandle(FDelegateHandle::GenerateNewHandle);
+	const FDelegateHandle Handle = Subscription.Handle;
+
+	// picked up after the flush. it didn't exist when this flush's changes were made anyway
+	TArray<FSubscription>& Target = bFlushingChanges ? PendingSubscriptions : Subscriptions;
+	Target.Add(MoveTemp(Subscription));
+
+	return Handle;
+}
+
+void UWorldGridSubsystem::Unsubscribe(FDelegateHandle& Handle)
+{
+	if (bFlushingChanges)
+	{
+		// the entry may be the one being called right now, so it's only disarmed here
+		for (FSubscription& Subscription : Subscriptions)
+		{
+			if (Subscription.Handle == Handle)
+			{
+				Subscription.Handle.Reset();
+			}
+		}
+		PendingSubscriptions.RemoveAll([&Handle](const FSubscription& Subscription) { return Subscription.Handle == Handle; });
+	}
+	else
+	{
+		Subscriptions.RemoveAll([&Handle](const FSubscription& Subscription) { return Subscription.Handle == Handle; });
+	}
+	Handle.Reset();
+}
+
+void UWorldGridSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		// commands first so their writes go out in this frame's flush
+		ApplyCommands();
+		FlushChanges();
+	}
+}
+
+void UWorldGridSubsystem::FlushChanges()
+{
+	if (DirtyChunks.Num() == 0)
+	{
+		return;
+	}
+
+	// gather and reset first so writes made by listeners land in the next flush
+	TArray<FWorldGridChange> Changes;
+	TArray<int32> ChangedChunks;
+	Changes.Reserve(DirtyChunks.Num());
+	ChangedChunks.Reserve(DirtyChunks.Num());
+	for (int32 ChunkIndex : DirtyChunks)
+	{
+		Changes.Add({ DirtyChunkRects[ChunkIndex], DirtyChunkLayers[ChunkIndex] });
+		ChangedChunks.Add(ChunkIndex);
+		DirtyChunkLayers[ChunkIndex] = EWorldGridLayer::None;
+	}
+	DirtyChunks.Reset();
+
+	{
+		// listeners may subscribe and unsubscribe from inside their callback, neither moves the array until the guard is released
+		TGuardValue<bool> FlushGuard(bFlushingChanges, true);
+
+		TArray<FWorldGridChange> SubscriberChanges;
+		for (int32 SubscriptionIndex = 0; SubscriptionIndex < Subscriptions.Num(); ++SubscriptionIndex)
+		{
+			const FSubscription& Subscription = Subscriptions[SubscriptionIndex];
+			if (!Subscription.Handle.IsValid())
+			{
+				continue;
+			}
+
+			SubscriberChanges.Reset();
+			for (int32 ChangeIndex = 0; ChangeIndex < Changes.Num(); ++ChangeIndex)
+			{
+				const FWorldGridChange& Change = Changes[ChangeIndex];
+
+				const EWorldGridLayer Layers = Change.Layers & Subscription.Layers;
+				if ((Layers == EWorldGridLayer::None) || !Change.Rect.Intersects(Subscription.Region))
+				{
+					continue;
+				}
+
+				if ((Subscription.ChunkMask.Num() > 0) && !Subscription.ChunkMask[ChangedChunks[ChangeIndex]])
+				{
+					continue;
+				}
+
+				SubscriberChanges.Add({ Change.Rect.Intersection(Subscription.Region), Layers });
+			}
+
+			if (SubscriberChanges.Num() > 0)
+			{
+				Subscription.Delegate.ExecuteIfBound(SubscriberChanges);
+			}
+		}
+	}
+
+	Subscriptions.RemoveAll([](const FSubscription& Subscription) { return !Subscription.Handle.IsValid(); });
+	Subscriptions.Append(MoveTemp(PendingSubscriptions));
+	PendingSubscriptions.Reset();
+}
+
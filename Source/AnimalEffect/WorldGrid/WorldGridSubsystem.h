@@ -2,8 +2,12 @@
 
 #pragma once
 
+#include "WorldGridCommands.h"
+#include "WorldGridSnapshot.h"
 #include "WorldGridTypes.h"
 
+#include "Containers/Queue.h"
+#include "Engine/World.h"
 #include "Subsystems/WorldSubsystem.h"
 
 #include "WorldGridSubsystem.generated.h"
@@ -21,6 +25,24 @@ struct FWorldGridConfig
 	UPROPERTY(EditAnywhere, meta = (ClampMin = 10, ClampMax = 500))
 	float WorldScale = 100.f;
 
+	// undo history is trimmed oldest first once its before and after images go over this
+	UPROPERTY(EditAnywhere, meta = (ClampMin = 0))
+	int32 UndoMemoryBudgetKB = 16 * 1024;
+
+	// default costs for pathfinding on this grid
+	UPROPERTY(EditAnywhere)
+	FWorldGridPathCostConfig PathCosts;
+
+	UPROPERTY(EditAnywhere)
+	FGridAgentConfig Agents;
+
+	UPROPERTY(EditAnywhere)
+	FWorldGridGeneratorConfig Generator;
+
+	// resources placed by the grid itself rather than by spawner actors in the level
+	UPROPERTY(EditAnywhere)
+	FWorldGridScatterConfig Scatter;
+
 };
 
 USTRUCT(BlueprintType)
@@ -41,6 +63,10 @@ struct FWorldGridActorSpawnParameters
 
 class UDigActualizer;
 
+// Start is inclusive, End is exclusive. NewOccupant is null when the cells were vacated.
+// a batch spawn broadcasts once for the bounds of everything it spawned, with a null NewOccupant
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnGridOccupantsChanged, const FGridVector& /*StartPosition*/, const FGridVector& /*EndPosition*/, AActor* /*NewOccupant*/);
+
 /**
  * Breaks the world up into a grid.
  * - At a given grid position, there can only ever be one elevation, one terrain type, and at most one actor.
@@ -64,6 +90,8 @@ public:
 	void Initialize(FSubsystemCollectionBase& Collection) override;
 	void Deinitialize() override;
 
+	FORCEINLINE const FWorldGridConfig& GetConfig() const { return Config; }
+
 	bool IsValidPosition(const FGridVector& Position) const;
 
 	// 0 is sea level. 1 would be 1 cliff height above level, not the difference in height between sand and dirt.
@@ -82,6 +110,7 @@ public:
 	// returns true if the position is a valid position on the grid. to see if the actor is actually stored on the grid, use IsActorOnGrid
 	bool GetActorGridPosition(AActor* Actor, FGridVector& OutPosition) const;
 
+	// reserved cells aren't vacant
 	bool IsSpaceUniformAndVacant(const FGridVector& StartPosition, const FGridVector& EndPosition) const;
 	bool GetVacantPositionAtOrNearPosition(const FGridVector& CurrentPosition, const FGridVector& Size, FGridVector& VacantPosition);
 
@@ -94,27 +123,206 @@ public:
 	AActor* TrySpawnActorOnGrid(const UAEMetaAsset* ActorAsset, const FWorldGridActorSpawnParameters& GridSpawnParams, TFunction<void(AActor*)> PreFinalizeConstructionCallback = nullptr);
 	AActor* TrySpawnSmallActorOnGrid(TSubclassOf<AActor> ActorClass, const FWorldGridActorSpawnParameters& GridSpawnParams, TFunction<void(AActor*)> PreFinalizeConstructionCallback = nullptr);
 
+	// spawns ActorAsset at each position that's still uniform and vacant, in order, without adjusting. returns how many were spawned.
+	// never loads. spawns nothing if the actor class isn't loaded yet, preload it through UMetaAssetPreloader or GetActorClassAsync first
+	int32 SpawnActorsOnGridBatch(const UAEMetaAsset* ActorAsset, TArrayView<const FGridVector> Positions, TArray<AActor*>* OutActors = nullptr);
+
 	bool RemoveActorFromGrid(AActor* Actor);
 
+	// every actor on the grid with at least one cell in Rect, each once no matter how many cells or chunks it spans.
+	// filters are optional, an actor has to pass both
+	void GetActorsInRect(const FGridRect& Rect, TArray<AActor*>& OutActors, TSubclassOf<AActor> ClassFilter = nullptr, TSubclassOf<UInterface> InterfaceFilter = nullptr) const;
+
+	// same as above for actors with at least one cell within Radius cells of Center
+	void GetActorsInRadius(const FGridVector& Center, int32 Radius, TArray<AActor*>& OutActors, TSubclassOf<AActor> ClassFilter = nullptr, TSubclassOf<UInterface> InterfaceFilter = nullptr) const;
+
+	// never loads the actualizer. the summary is read from the loaded asset or its asset registry tags
 	bool TryPlaceDigActualizerOnGrid(TSoftObjectPtr<UDigActualizer> Actualizer, const FGridVector& DesiredPosition);
+	bool TryPlaceDigActualizerOnGrid(TSoftObjectPtr<UDigActualizer> Actualizer, const FDigDetectionSummary& Summary, const FGridVector& DesiredPosition);
+
+	// buries Actualizer at each position that doesn't already have something buried. the summary is looked up once. returns how many were buried
+	int32 PlaceDigActualizersOnGridBatch(TSoftObjectPtr<UDigActualizer> Actualizer, TArrayView<const FGridVector> Positions);
+
+	// every cell with something buried in it, in no particular order
+	void GetDigActualizerPositions(TArray<FGridVector>& OutPositions) const;
+
+	// clears the dig cell and its detection data. the returned actualizer may not be loaded yet
 	TSoftObjectPtr<UDigActualizer> TryRemoveDigActualizerFromGrid(const FGridVector& Position);
 
 	void DebugDrawPosition(const FGridVector& Position, float DisplayTime, const FColor& Color);
 
+	// walks every cell Ray passes through in order (Amanatides-Woo) and stops at the first one matching Ray.BlockOn.
+	// the cell the ray starts in never blocks. returns true if blocked
+	bool GridRaycast(const FGridRay& Ray, FGridRaycastHit& OutHit) const;
+
+	// same as GridRaycast for every ray, spread over worker threads when there are enough of them. OutHits matches Rays
+	void GridRaycastBatch(const TArray<FGridRay>& Rays, TArray<FGridRaycastHit>& OutHits) const;
+
+	// cell centre to cell centre, blocked by actors (other than on From and To), higher ground and nothing else
+	bool HasLineOfSight(const FGridVector& From, const FGridVector& To) const;
+
+	// broadcast whenever the actor occupying a block of cells changes
+	FOnGridOccupantsChanged OnOccupantsChanged;
+
+	// Delegate is called once per frame at most, after actors have ticked, with every change since the last call
+	// that touches Region on one of Layers. changes are clipped to Region and coalesced per chunk
+	FDelegateHandle Subscribe(const FGridRect& Region, EWorldGridLayer Layers, FOnWorldGridChanged Delegate);
+
+	// same as above but only for changes inside the given chunks
+	FDelegateHandle SubscribeToChunks(const TArray<FGridVector>& Chunks, EWorldGridLayer Layers, FOnWorldGridChanged Delegate);
+
+	void Unsubscribe(FDelegateHandle& Handle);
+
+	FORCEINLINE int32 GetChunkCountPerSide() const { return ChunkCountPerSide; }
+	FORCEINLINE FGridVector GetChunkForGridPosition(const FGridVector& Position) const { return FGridVector(Position.X / GridChunkSize, Position.Y / GridChunkSize); }
+
+	// the cells of Chunk, clipped to the grid
+	FGridRect GetChunkRect(const FGridVector& Chunk) const;
+
+	// versions only ever go up and are bumped on every write, whether or not the value changed.
+	// they're safe to read from any thread without locking, but a read racing a write may see either version
+	int32 GetChunkVersion(const FGridVector& Chunk, EWorldGridLayer Layers = EWorldGridLayer::All) const;
+
+	// the sum of the versions of every chunk overlapping Region. differs from a previous read iff something under it was written
+	int64 GetRegionVersion(const FGridRect& Region, EWorldGridLayer Layers = EWorldGridLayer::All) const;
+
+	// the version of every chunk overlapping Region, row by row
+	void GetChunkVersions(const FGridRect& Region, EWorldGridLayer Layers, TArray<int32>& OutVersions) const;
+
+	// safe from any thread and never blocks. Command is applied on the game thread after actors tick, before changes are flushed
+	void EnqueueCommand(FWorldGridCommand&& Command);
+
+	// game thread only. applies Command right away instead of queueing it, so it can be part of a transaction
+	EWorldGridCommandResult ApplyCommandImmediate(const FWorldGridCommand& Command);
+
+	// game thread only. every terrain and elevation write between the outermost Begin and End is undone or redone as one.
+	// actors aren't recorded, they have to be put back through spawning.
+	// Undo and Redo refuse (and return false) if anything else has written terrain, elevation or actors to one of the chunks since
+	void BeginTransaction();
+	void EndTransaction();
+
+	bool Undo();
+	bool Redo();
+
+	FORCEINLINE bool CanUndo() const { return UndoStack.Num() > 0; }
+	FORCEINLINE bool CanRedo() const { return RedoStack.Num() > 0; }
+
+	void ClearHistory();
+
+	// safe from any thread. tokens are never 0
+	static int32 NewReservationToken();
+
+	// game thread only. reserved cells are left alone by spawning and by commands that don't carry the token
+	bool TryReserveCells(const FGridRect& Rect, int32 ReservationToken);
+	void ReleaseCells(const FGridRect& Rect, int32 ReservationToken);
+
+	// 0 if the cell isn't reserved
+	int32 GetReservationAtPosition(const FGridVector& Position) const;
+
+	// game thread only. the returned snapshot can be handed to and read from any thread.
+	// only chunks written since the last call are copied, everything else is shared with previous snapshots
+	FWorldGridSnapshotPtr GetSnapshot();
+
+	// game thread only. replaces the whole elevation and terrain layers, both row-major and Width * Width. actors and reservations
+	// are left where they are and undo history is cleared, since it can't be replayed over a different map
+	bool ImportLayers(const TArray<int32>& Elevation, const TArray<ETerrainType>& TerrainType);
+
+	// game thread only. runs FWorldGridGenerator with Settings and imports the result
+	bool GenerateIsland(const FWorldGridGeneratorConfig& Settings);
+
+	// game thread only. places Rules with FWorldGridScatter around whatever is already on the grid.
+	// actors whose class isn't loaded yet are spawned once it has streamed in. returns how many things were placed or queued
+	int32 ScatterFromRules(const TArray<FWorldGridScatterRule>& Rules, int32 Seed);
+
 private:
 
 	FVector GetWorldLocationAtGridPosition_Internal(const FGridVector& Position) const;
 
 	AActor* SpawnActorOnGrid_Internal(TSubclassOf<AActor> ActorClass, const FGridVector& GridPosition, const FGridVector& ActorSize, AActor* Owner, TFunction<void(AActor*)> PreFinalizeConstructionCallback);
 
+	// broadcasts OnOccupantsChanged unless a batch is running, which broadcasts once at the end instead
 	void SetActorAtPositions(AActor* Actor, const FGridVector& StartPosition, const FGridVector& EndPosition);
 	void SetTerrainTypeAtPositions(ETerrainType TerrainType, const FGridVector& StartPosition, const FGridVector& EndPosition);
 	void SetElevationAtPositions(int32 Elevation, const FGridVector& StartPosition, const FGridVector& EndPosition);
 	void SetDigActualizerAtPosition(TSoftObjectPtr<UDigActualizer> DigActualizer, const FGridVector& Position);
 	void SetDetectionDataAtPosition(const TTuple<int32, int32>& DetectionData, const FGridVector& Position);
+	void SetDetectionDataInRadius(int32 Rarity, int32 Radius, const FGridVector& Position);
 
 	int32 GetArrayIndexForGridPosition(const FGridVector& Position) const;
 
+	void AddChunkOccupant(AActor* Actor, const FGridRect& Rect);
+	void RemoveChunkOccupant(AActor* Actor, const FGridRect& Rect);
+
+	// Predicate gets each actor overlapping Rect once, with its grid rect
+	template<typename PredicateType>
+	void ForEachActorInRect(const FGridRect& Rect, PredicateType Predicate) const;
+
+	// records that cells in [StartPosition, EndPosition) were written on Layer. cheap, nothing is delivered until FlushChanges
+	void MarkRegionDirty(const FGridVector& StartPosition, const FGridVector& EndPosition, EWorldGridLayer Layer);
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params);
+
+	// full copy of the terrain and elevation of one chunk
+	struct FChunkImage
+	{
+		int32 ChunkIndex = INDEX_NONE;
+		// the chunk's version when this image was last the live one. only meaningful for the side of the transaction that's applied
+		int32 Version = 0;
+		TArray<int32> Elevation;
+		TArray<ETerrainType> TerrainType;
+
+		FORCEINLINE SIZE_T GetAllocatedSize() const { return Elevation.GetAllocatedSize() + TerrainType.GetAllocatedSize(); }
+	};
+
+	struct FTransaction
+	{
+		TArray<FChunkImage> Before;
+		TArray<FChunkImage> After;
+		SIZE_T AllocatedSize = 0;
+	};
+
+	// captures the before-image of every chunk under the rect that this transaction hasn't touched yet
+	void RecordTransactionWrite(const FGridVector& StartPosition, const FGridVector& EndPosition);
+
+	void CaptureChunkImage(int32 ChunkIndex, FChunkImage& OutImage) const;
+	void RestoreChunkImages(const TArray<FChunkImage>& Images);
+
+	// whether every chunk in Images is as Images left it, and stamping them with the chunks' current versions
+	bool AreChunkImagesCurrent(const TArray<FChunkImage>& Images) const;
+	void StampChunkImageVersions(TArray<FChunkImage>& Images) const;
+
+	// restores Images and carries the versions over to the next transaction in Stack that saw the same chunk state,
+	// so undoing (or redoing) several in a row doesn't look like a conflict
+	void RestoreTransactionImages(TArray<FChunkImage>& Images, TArray<FTransaction>& Stack, bool bStackAfterImages);
+
+	void TrimHistory();
+
+	void ApplyCommands();
+	EWorldGridCommandResult ApplyCommand(const FWorldGridCommand& Command);
+
+	// whether Rect has an actor on it, or is reserved with anything but AllowedToken
+	bool IsRectBlocked(const FGridRect& Rect, int32 AllowedToken) const;
+
+	void SetReservationAtPositions(int32 ReservationToken, const FGridVector& StartPosition, const FGridVector& EndPosition);
+
+	struct FSubscription
+	{
+		FDelegateHandle Handle;
+		FGridRect Region;
+		TBitArray<> ChunkMask; // one bit per chunk. empty means the subscription is by Region
+		EWorldGridLayer Layers;
+		FOnWorldGridChanged Delegate;
+	};
+
+	void FlushChanges();
+
+	// defers to PendingSubscriptions while a flush is running so the array doesn't move under a callback
+	FDelegateHandle AddSubscription(FSubscription&& Subscription);
+
+	FWorldGridSnapshotChunkPtr BuildSnapshotChunk(const FGridVector& Chunk, int32 Version) const;
+
 	FWorldGridConfig Config;
 
 	TArray<int32> ElevationGrid;
@@ -122,6 +330,55 @@ private:
 	TArray<AActor*> ActorGrid;
 	TArray<TSoftObjectPtr<UDigActualizer>> DigGrid;
 	TArray<TTuple<int32,int32>> DetectionGrid;
+	TArray<int32> ReservationGrid;
+
+	struct FChunkOccupant
+	{
+		AActor* Actor;
+		// kept here so queries don't have to look up the actor's annotation
+		FGridRect Rect;
+	};
+
+	// per chunk, every actor with a cell in it. an actor spanning chunks is in each of them
+	TArray<TArray<FChunkOccupant>> ChunkOccupants;
+
+	// buried items are sparse so their summaries are keyed by array index instead of stored per cell
+	TMap<int32, FDigDetectionSummary> DigSummaries;
+
+	int32 ChunkCountPerSide = 0;
+
+	// per chunk, the bounds of everything written since the last flush and on which layers
+	TArray<FGridRect> DirtyChunkRects;
+	TArray<EWorldGridLayer> DirtyChunkLayers;
+	TArray<int32> DirtyChunks;
+
+	// ChunkCount * WorldGridLayerCount, indexed ChunkIndex * WorldGridLayerCount + layer bit. allocated once so workers can read it
+	TArray<int32> ChunkLayerVersions;
+
+	TArray<FSubscription> Subscriptions;
+
+	// made or dropped by listeners during FlushChanges. unsubscribing mid flush resets the handle and the entry is removed after
+	TArray<FSubscription> PendingSubscriptions;
+	bool bFlushingChanges = false;
+
+	// set while SpawnActorsOnGridBatch runs
+	bool bBatchingOccupants = false;
+
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle InitializedActorsHandle;
+
+	TQueue<FWorldGridCommand, EQueueMode::Mpsc> PendingCommands;
+
+	TArray<FTransaction> UndoStack;
+	TArray<FTransaction> RedoStack;
+	SIZE_T HistorySize = 0;
+
+	FTransaction OpenTransaction;
+	TBitArray<> OpenTransactionChunks;
+	int32 TransactionDepth = 0;
+
+	// the newest snapshot handed out. its chunks are reused by the next one if their version hasn't moved
+	FWorldGridSnapshotPtr LatestSnapshot;
 };
 
 UINTERFACE()
@@ -6,6 +6,9 @@
 
 #include "WorldGridTypes.generated.h"
 
+class UAEMetaAsset;
+class UDigActualizer;
+
 USTRUCT(BlueprintType)
 struct ANIMALEFFECT_API FGridVector
 {
@@ -48,6 +51,90 @@ struct ANIMALEFFECT_API FGridVector
 
 FGridVector operator+(const FGridVector& A, const FGridVector& B);
 
+// the grid is split into square chunks of this many cells per side for change tracking
+constexpr int32 GridChunkSize = 16;
+
+// Min is inclusive, Max is exclusive, same as the Start/End pairs the grid setters take
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FGridRect
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FGridVector Min = FGridVector(0, 0);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FGridVector Max = FGridVector(0, 0);
+
+	constexpr FGridRect() = default;
+
+	constexpr FGridRect(const FGridVector& InMin, const FGridVector& InMax) : Min(InMin), Max(InMax) {}
+
+	FORCEINLINE bool IsEmpty() const { return (Min.X >= Max.X) || (Min.Y >= Max.Y); }
+
+	FORCEINLINE int32 Width() const { return Max.X - Min.X; }
+	FORCEINLINE int32 Height() const { return Max.Y - Min.Y; }
+
+	FORCEINLINE bool Contains(const FGridVector& Position) const
+	{
+		return (Position.X >= Min.X) && (Position.X < Max.X) && (Position.Y >= Min.Y) && (Position.Y < Max.Y);
+	}
+
+	FORCEINLINE bool Intersects(const FGridRect& Other) const
+	{
+		return (Min.X < Other.Max.X) && (Other.Min.X < Max.X) && (Min.Y < Other.Max.Y) && (Other.Min.Y < Max.Y);
+	}
+
+	FORCEINLINE FGridRect Intersection(const FGridRect& Other) const
+	{
+		return { FGridVector(FMath::Max(Min.X, Other.Min.X), FMath::Max(Min.Y, Other.Min.Y)), FGridVector(FMath::Min(Max.X, Other.Max.X), FMath::Min(Max.Y, Other.Max.Y)) };
+	}
+
+	// an empty rect doesn't grow the union
+	FORCEINLINE FGridRect Union(const FGridRect& Other) const
+	{
+		if (IsEmpty())
+		{
+			return Other;
+		}
+		if (Other.IsEmpty())
+		{
+			return *this;
+		}
+		return { FGridVector(FMath::Min(Min.X, Other.Min.X), FMath::Min(Min.Y, Other.Min.Y)), FGridVector(FMath::Max(Max.X, Other.Max.X), FMath::Max(Max.Y, Other.Max.Y)) };
+	}
+
+	FORCEINLINE FString ToString() const
+	{
+		return FString::Printf(TEXT("Min: (%s), Max: (%s)"), *Min.ToString(), *Max.ToString());
+	}
+};
+
+UENUM(meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class EWorldGridLayer : uint8
+{
+	None = 0 UMETA(Hidden),
+	Elevation = 1 << 0,
+	Terrain = 1 << 1,
+	Actor = 1 << 2,
+	Dig = 1 << 3,
+	Detection = 1 << 4,
+	Reservation = 1 << 5,
+	All = Elevation | Terrain | Actor | Dig | Detection | Reservation UMETA(Hidden),
+};
+ENUM_CLASS_FLAGS(EWorldGridLayer);
+
+constexpr int32 WorldGridLayerCount = 6;
+
+// one coalesced change: every cell written in Rect since the last flush lies inside it, on the layers in Layers
+struct FWorldGridChange
+{
+	FGridRect Rect;
+	EWorldGridLayer Layers = EWorldGridLayer::None;
+};
+
+DECLARE_DELEGATE_OneParam(FOnWorldGridChanged, const TArray<FWorldGridChange>& /*Changes*/);
+
 UENUM()
 enum class ETerrainType : uint8
 {
@@ -57,3 +144,272 @@ enum class ETerrainType : uint8
 	Water,
 	OutOfBounds,
 };
+
+// how expensive it is to walk onto a cell. a negative terrain cost makes that terrain impassable
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FWorldGridPathCostConfig
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Terrain")
+	float SandCost = 1.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Terrain")
+	float DirtCost = 1.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Terrain")
+	float RockCost = 1.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Terrain")
+	float WaterCost = -1.f;
+
+	// added per level of elevation difference between two neighbouring cells
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Elevation", meta = (ClampMin = 0))
+	float ElevationStepCost = 4.f;
+
+	// neighbouring cells further apart than this in elevation are a cliff and can't be walked between
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Elevation", meta = (ClampMin = 0))
+	int32 MaxElevationStep = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	bool bAllowDiagonal = true;
+
+	// off for searches whose results outlive a few frames (flow fields), since agents reserve cells as they walk
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	bool bReservationsBlock = true;
+
+	FORCEINLINE EWorldGridLayer GetBlockingLayers() const
+	{
+		return EWorldGridLayer::Elevation | EWorldGridLayer::Terrain | EWorldGridLayer::Actor | (bReservationsBlock ? EWorldGridLayer::Reservation : EWorldGridLayer::None);
+	}
+
+	// negative if impassable
+	FORCEINLINE float GetTerrainCost(ETerrainType TerrainType) const
+	{
+		switch (TerrainType)
+		{
+		case ETerrainType::Sand: return SandCost;
+		case ETerrainType::Dirt: return DirtCost;
+		case ETerrainType::Rock: return RockCost;
+		case ETerrainType::Water: return WaterCost;
+		default: return -1.f;
+		}
+	}
+
+	// the cheapest passable terrain, so heuristics built on it never overestimate
+	FORCEINLINE float GetMinTerrainCost() const
+	{
+		float MinCost = MAX_flt;
+		for (float Cost : { SandCost, DirtCost, RockCost, WaterCost })
+		{
+			if (Cost >= 0.f)
+			{
+				MinCost = FMath::Min(MinCost, Cost);
+			}
+		}
+		return (MinCost == MAX_flt) ? 0.f : MinCost;
+	}
+};
+
+// settings for FWorldGridGenerator. the same settings and seed always give the same island, cell for cell
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FWorldGridGeneratorConfig
+{
+	GENERATED_BODY()
+
+	// generate an island when the grid starts instead of keeping whatever was authored
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bGenerateOnStartup = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Seed = 1;
+
+	// cells across the largest noise features
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 4, ClampMax = 512))
+	int32 FeatureSize = 64;
+
+	// 0 to 1, how much of the grid is sea, mostly around the edges
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0, ClampMax = 1))
+	float SeaLevel = 0.35f;
+
+	// 0 to 1 above sea level. land below this is beach
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0, ClampMax = 1))
+	float BeachHeight = 0.08f;
+
+	// plateaus above the beach level
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0, ClampMax = 8))
+	int32 PlateauCount = 2;
+
+	// 0 to 1 of a second noise, above which dirt on the highest plateau becomes rock
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0, ClampMax = 1))
+	float RockThreshold = 0.6f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0, ClampMax = 16))
+	int32 RiverCount = 2;
+
+	// passes that flatten plateau edges too ragged to walk around
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0, ClampMax = 8))
+	int32 ErosionPasses = 2;
+};
+
+// what stops a grid raycast
+UENUM(meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class EGridRayBlock : uint8
+{
+	None = 0 UMETA(Hidden),
+	// an actor is on the cell
+	Occupied = 1 << 0,
+	// the cell is higher than the cell the ray started in
+	ElevationStep = 1 << 1,
+	Water = 1 << 2,
+	All = Occupied | ElevationStep | Water UMETA(Hidden),
+};
+ENUM_CLASS_FLAGS(EGridRayBlock);
+
+struct FGridRay
+{
+	// world space. only X and Y are used, the ray is walked over the grid from above
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+
+	EGridRayBlock BlockOn = EGridRayBlock::All;
+
+	// occupying this actor doesn't block, usually whoever cast the ray
+	const AActor* IgnoreActor = nullptr;
+};
+
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FGridRaycastHit
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bBlocked = false;
+
+	// the blocking cell, or the last cell on the grid the ray got to
+	UPROPERTY(BlueprintReadOnly)
+	FGridVector Cell;
+
+	// the cell before Cell. invalid if the ray was blocked in the first cell it entered after its start
+	UPROPERTY(BlueprintReadOnly)
+	FGridVector PreviousCell;
+
+	UPROPERTY(BlueprintReadOnly)
+	EGridRayBlock BlockedBy = EGridRayBlock::None;
+
+	// where the ray entered Cell, or its end if it wasn't blocked
+	UPROPERTY(BlueprintReadOnly)
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 VisitedCellCount = 0;
+};
+
+// how UGridAgentSubsystem spends its frame. distances are in grid cells, intervals in seconds
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FGridAgentConfig
+{
+	GENERATED_BODY()
+
+	// agents are updated until this is spent, the rest wait for a later frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0))
+	float FrameBudgetMs = 0.5f;
+
+	// agents this close to a player update every frame and get their proxy actor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0))
+	int32 NearDistance = 24;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0))
+	int32 MidDistance = 64;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0))
+	float MidUpdateInterval = 0.5f;
+
+	// beyond MidDistance
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0))
+	float FarUpdateInterval = 2.f;
+
+	// cells per second
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0.1))
+	float MoveSpeed = 3.f;
+
+	// consecutive blocked updates before an agent asks for a new path
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 1))
+	int32 BlockedUpdatesBeforeRepath = 3;
+};
+
+// what the grid needs to know about a buried item to place and remove it without loading the item's asset
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FDigDetectionSummary
+{
+	GENERATED_BODY()
+
+	// radius in grid cells that the buried item can be detected
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 Radius = 0;
+
+	// the detected rarity of the buried item. 0 is not detectable, but can still be buried
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 Rarity = 0;
+
+	// false for a default constructed summary, so one that was never filled in (or saved before this existed) isn't mistaken for rarity 0
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	bool bHasSummary = false;
+
+	FORCEINLINE bool IsValid() const { return bHasSummary && (Radius >= 0); }
+};
+
+// one kind of thing FWorldGridScatter places, like a tree, a rock or a buried item
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FWorldGridScatterRule
+{
+	GENERATED_BODY()
+
+	// an actor to spawn on the grid. leave empty to bury Actualizer instead
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UAEMetaAsset* Asset = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TSoftObjectPtr<UDigActualizer> Actualizer;
+
+	// terrain every cell under a placement has to be
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Bitmask, BitmaskEnum = "ETerrainType"))
+	int32 TerrainMask = (1 << static_cast<int32>(ETerrainType::Dirt));
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0))
+	int32 MinElevation = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0))
+	int32 MaxElevation = 8;
+
+	// cells between any two placements of this rule
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 1.5, ClampMax = 64))
+	float Spacing = 4.f;
+
+	// 0 to 1, the share of evenly spaced candidates kept. thins placements out without clumping them
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0, ClampMax = 1))
+	float Density = 1.f;
+
+	// 0 is no limit
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = 0))
+	int32 MaxCount = 0;
+
+	FORCEINLINE bool AllowsTerrain(ETerrainType TerrainType) const { return (TerrainMask & (1 << static_cast<int32>(TerrainType))) != 0; }
+};
+
+USTRUCT(BlueprintType)
+struct ANIMALEFFECT_API FWorldGridScatterConfig
+{
+	GENERATED_BODY()
+
+	// scatter Rules once the level's actors are initialized
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bScatterOnBeginPlay = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Seed = 1;
+
+	// placed in order. earlier rules get first pick of contested cells
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<FWorldGridScatterRule> Rules;
+};